@@ -26,6 +26,18 @@ namespace code {
 		from->remove(ptrC);
 	}
 
+	Listing *Arena::optimize(Listing *src) const {
+		return src;
+	}
+
+	RegSet *Arena::varRegs() const {
+		return new (this) RegSet();
+	}
+
+	Bool Arena::intRegister(Reg r) const {
+		return true;
+	}
+
 
 #if defined(X86) && defined(WINDOWS)
 	Arena *arena(EnginePtr e) {
@@ -35,6 +35,11 @@ namespace code {
 		// backend-specific. 'owner' is the binary object that will be called to handle exceptions.
 		virtual Listing *STORM_FN transform(Listing *src) const ABSTRACT;
 
+		// Apply optimizations to the code before it is transformed. The optimizations are not
+		// required for correctness, and may therefore be skipped when code needs to be produced
+		// quickly. The default implementation returns 'src' unmodified.
+		virtual Listing *STORM_FN optimize(Listing *src) const;
+
 		// Translate a previously transformed listing into machine code for this arena.
 		virtual void STORM_FN output(Listing *src, Output *to) const ABSTRACT;
 
@@ -53,6 +58,15 @@ namespace code {
 		// remove others as well.
 		virtual void STORM_FN removeFnRegs(RegSet *from) const;
 
+		// Get the registers that may be used to store variables. Only registers that are preserved
+		// across function calls and that are not used implicitly by the backend may be
+		// included. The default implementation returns an empty set, which means that all
+		// variables are stored on the stack.
+		virtual RegSet *STORM_FN varRegs() const;
+
+		// Is 'r' an integer register (as opposed to a floating-point register)?
+		virtual Bool STORM_FN intRegister(Reg r) const;
+
 		/**
 		 * Other backend-specific things.
 		 */
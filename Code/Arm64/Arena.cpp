@@ -6,6 +6,8 @@
 #include "Code/Listing.h"
 #include "Code/Output.h"
 #include "RemoveInvalid.h"
+#include "Code/Peephole.h"
+#include "Code/RegAlloc.h"
 #include "Layout.h"
 #include "Params.h"
 #include "../Exception.h"
@@ -30,6 +32,16 @@ namespace code {
 			return l;
 		}
 
+		Listing *Arena::optimize(Listing *l) const {
+			// Simplify the code before doing anything else.
+			l = code::transform(l, this, new (this) Peephole(this));
+
+			// Store variables in registers where possible.
+			l = code::transform(l, this, new (this) RegAlloc(this));
+
+			return l;
+		}
+
 		void Arena::output(Listing *src, Output *to) const {
 			code::arm64::output(src, to);
 			to->finish();
@@ -48,6 +60,19 @@ namespace code {
 				from->remove(fnDirtyRegs[i]);
 		}
 
+		RegSet *Arena::varRegs() const {
+			// Note: x19-x22 are used by the layout transform to preserve the return value while
+			// running destructors, so they are not included.
+			RegSet *result = new (this) RegSet();
+			for (Nat i = 23; i < 29; i++)
+				result->put(ptrr(i));
+			return result;
+		}
+
+		Bool Arena::intRegister(Reg r) const {
+			return isIntReg(r);
+		}
+
 		Listing *Arena::redirect(Bool member, TypeDesc *result, Array<TypeDesc *> *params, Ref fn, Operand param) {
 			Listing *l = new (this) Listing(this);
 
@@ -5,15 +5,41 @@
 
 namespace code {
 
-	Binary::Binary(Arena *arena, Listing *listing) {
-		compile(arena, listing, false);
+	Binary::Binary(Arena *arena, Listing *listing) :
+		pendingArena(null), pendingSrc(null), pendingLabels(null) {
+
+		compile(arena, listing, true, false);
+	}
+
+	Binary::Binary(Arena *arena, Listing *listing, Bool debug) :
+		pendingArena(null), pendingSrc(null), pendingLabels(null) {
+
+		compile(arena, listing, true, debug);
+	}
+
+	Binary::Binary(Arena *arena, Listing *listing, Bool optimize, Bool debug) :
+		pendingArena(null), pendingSrc(null), pendingLabels(null) {
+
+		compile(arena, listing, optimize, debug);
+	}
+
+	Binary::Binary() : pendingArena(null), pendingSrc(null), pendingLabels(null) {}
+
+	Binary *Binary::prepare(Arena *arena, Listing *listing, Bool optimize) {
+		Binary *b = new (arena) Binary();
+		b->layout(arena, listing, optimize, false);
+		return b;
 	}
 
-	Binary::Binary(Arena *arena, Listing *listing, Bool debug) {
-		compile(arena, listing, debug);
+	void Binary::compile(Arena *arena, Listing *listing, Bool optimize, Bool debug) {
+		layout(arena, listing, optimize, debug);
+		finish();
 	}
 
-	void Binary::compile(Arena *arena, Listing *listing, Bool debug) {
+	void Binary::layout(Arena *arena, Listing *listing, Bool optimize, Bool debug) {
+		if (optimize)
+			listing = arena->optimize(listing);
+
 		Listing *tfm = arena->transform(listing);
 		if (debug)
 			PVAR(tfm);
@@ -33,8 +59,23 @@ namespace code {
 			WARNING(L"Exception cleanup will not work!");
 		}
 
-		CodeOutput *output = arena->codeOutput(this, labels);
-		arena->output(tfm, output);
+		pendingArena = arena;
+		pendingSrc = tfm;
+		pendingLabels = labels;
+	}
+
+	void Binary::finish() {
+		if (!pendingSrc)
+			return;
+
+		// Note: The code output creates references to other code, which is why this needs to
+		// happen on the Compiler thread.
+		CodeOutput *output = pendingArena->codeOutput(this, pendingLabels);
+		pendingArena->output(pendingSrc, output);
+
+		pendingArena = null;
+		pendingSrc = null;
+		pendingLabels = null;
 
 		runtime::codeUpdatePtrs(output->codePtr());
 		set(output->codePtr(), output->tell());
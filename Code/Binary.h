@@ -28,6 +28,20 @@ namespace code {
 		// Output the transformed ASM code for debugging.
 		Binary(Arena *arena, Listing *src, Bool debug);
 
+		// Translate a listing into machine code, optionally skipping the optimizations provided
+		// by the arena.
+		Binary(Arena *arena, Listing *src, Bool optimize, Bool debug);
+
+		// Translate a listing into machine code in two steps. 'prepare' transforms the listing and
+		// computes the layout of the machine code. This step does not touch any references, and
+		// may therefore be done on any thread. The resulting Binary has no code until 'finish' is
+		// called on the Compiler thread.
+		static Binary *prepare(Arena *arena, Listing *src, Bool optimize);
+
+		// Generate the machine code for a Binary created by 'prepare'. Does nothing if the code
+		// is already generated.
+		void finish();
+
 		// Clean up a stack frame from this function.
 		void cleanup(StackFrame &frame);
 
@@ -112,8 +126,21 @@ namespace code {
 		// (perhaps using a binary search).
 		GcArray<TryInfo> *tryBlocks;
 
+		// Create an empty Binary, used by 'prepare'.
+		Binary();
+
+		// Arena used, transformed listing and label offsets between 'prepare' and 'finish'. Null
+		// when there is no pending work.
+		MAYBE(Arena *) pendingArena;
+		MAYBE(Listing *) pendingSrc;
+		MAYBE(LabelOutput *) pendingLabels;
+
 		// Compile the Listing object.
-		void compile(Arena *arena, Listing *src, Bool debug);
+		void compile(Arena *arena, Listing *src, Bool optimize, Bool debug);
+
+		// Transform the Listing object and compute the layout. Stores the results in the pending
+		// variables.
+		void layout(Arena *arena, Listing *src, Bool optimize, Bool debug);
 
 		// Fill the 'blocks' array.
 		void fillBlocks(Listing *src);
@@ -0,0 +1,565 @@
+#include "stdafx.h"
+#include "Peephole.h"
+#include "Arena.h"
+
+namespace code {
+
+	// Maximum number of times to run all passes.
+	static const Nat maxIterations = 4;
+
+	// Maximum number of instructions to examine when looking for uses of flags and registers.
+	static const Nat maxScan = 16;
+
+	// Number of bits in integers of 'size'. Zero if 'size' is not an integer size.
+	static Nat bits(Size size) {
+		if (size == Size::sByte)
+			return 8;
+		if (size == Size::sInt)
+			return 32;
+		if (size == Size::sLong)
+			return 64;
+		return 0;
+	}
+
+	// Mask for the lowest 'bits' bits.
+	static Word mask(Nat bits) {
+		if (bits >= 64)
+			return ~Word(0);
+		return (Word(1) << bits) - 1;
+	}
+
+	// Sign-extend a value of 'bits' bits.
+	static Long signExtend(Word value, Nat bits) {
+		Nat shift = 64 - bits;
+		return Long(value << shift) >> shift;
+	}
+
+	// If 'value' is a power of two, get its logarithm. Otherwise, returns zero.
+	static Nat exactLog2(Word value) {
+		if (value < 2 || (value & (value - 1)) != 0)
+			return 0;
+
+		Nat result = 0;
+		while (value > 1) {
+			value >>= 1;
+			result++;
+		}
+		return result;
+	}
+
+	// Evaluate 'cond' after comparing 'a' and 'b'. Returns false if the result is not known.
+	static Bool evaluate(CondFlag cond, Word a, Word b, Nat bits, Bool &result) {
+		Word ua = a & mask(bits);
+		Word ub = b & mask(bits);
+		Long sa = signExtend(ua, bits);
+		Long sb = signExtend(ub, bits);
+
+		switch (cond) {
+		case ifEqual:
+			result = ua == ub;
+			return true;
+		case ifNotEqual:
+			result = ua != ub;
+			return true;
+		case ifBelow:
+			result = ua < ub;
+			return true;
+		case ifBelowEqual:
+			result = ua <= ub;
+			return true;
+		case ifAboveEqual:
+			result = ua >= ub;
+			return true;
+		case ifAbove:
+			result = ua > ub;
+			return true;
+		case ifLess:
+			result = sa < sb;
+			return true;
+		case ifLessEqual:
+			result = sa <= sb;
+			return true;
+		case ifGreaterEqual:
+			result = sa >= sb;
+			return true;
+		case ifGreater:
+			result = sa > sb;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Is 'op' a 32-bit register? Writing these clears the upper part of the 64-bit register on
+	// most architectures, so instructions that write to them are not removed.
+	static Bool isIntRegister(const Operand &op) {
+		return op.type() == opRegister && op.size() == Size::sInt;
+	}
+
+	// Does 'instr' read the register 'r'?
+	static Bool readsReg(Instr *instr, Reg r) {
+		const Operand &src = instr->src();
+		const Operand &dest = instr->dest();
+
+		if ((src.type() == opRegister || src.type() == opRelative) && same(src.reg(), r))
+			return true;
+		if (dest.type() == opRelative && same(dest.reg(), r))
+			return true;
+		if (dest.type() == opRegister && same(dest.reg(), r)) {
+			// Note: Operands that are not written (e.g. the target of 'call') are read.
+			DestMode mode = instr->mode();
+			return (mode & destRead) || !(mode & destWrite);
+		}
+		return false;
+	}
+
+	// Does 'instr' generate any code?
+	static Bool hasCode(Instr *instr) {
+		return instr && instr->op() != op::location && instr->op() != op::meta;
+	}
+
+	Peephole::Peephole(const Arena *arena) : arena(arena), hasRet(false) {}
+
+	void Peephole::before(Listing *dest, Listing *src) {
+		Nat count = src->count();
+
+		code = new (this) Array<Instr *>(count);
+		labelled = new (this) Array<Bool>(count + 1, false);
+		labelLine = new (this) Array<Nat>(src->labelCount(), count + 1);
+		hasRet = false;
+
+		for (Nat i = 0; i <= count; i++) {
+			if (i < count) {
+				code->at(i) = src->at(i);
+				if (src->at(i)->op() == op::ret)
+					hasRet = true;
+			}
+
+			if (Array<Label> *labels = src->labels(i)) {
+				labelled->at(i) = labels->any();
+				for (Nat j = 0; j < labels->count(); j++) {
+					Nat id = labels->at(j).key();
+					if (id < labelLine->count())
+						labelLine->at(id) = i;
+				}
+			}
+		}
+
+		for (Nat i = 0; i < maxIterations; i++) {
+			Bool changed = jumps();
+			changed |= constants();
+			changed |= stores();
+			changed |= copies();
+			if (!changed)
+				break;
+		}
+	}
+
+	void Peephole::during(Listing *dest, Listing *src, Nat line) {
+		if (Instr *instr = code->at(line))
+			*dest << instr;
+	}
+
+	Nat Peephole::next(Nat line) const {
+		Nat count = code->count();
+		for (Nat i = line + 1; i < count; i++)
+			if (hasCode(code->at(i)))
+				return i;
+		return count;
+	}
+
+	Nat Peephole::prev(Nat line) const {
+		for (Nat i = line; i > 0; i--)
+			if (hasCode(code->at(i - 1)))
+				return i - 1;
+		return code->count();
+	}
+
+	Bool Peephole::joins(Nat from, Nat to) const {
+		for (Nat i = from + 1; i <= to && i < labelled->count(); i++)
+			if (labelled->at(i))
+				return true;
+		return false;
+	}
+
+	Nat Peephole::target(Label label) const {
+		Nat count = code->count();
+		if (label.key() >= labelLine->count())
+			return count + 1;
+
+		Nat line = labelLine->at(label.key());
+		if (line >= count)
+			return line;
+		if (hasCode(code->at(line)))
+			return line;
+		return next(line);
+	}
+
+	Bool Peephole::flagsDead(Nat line) const {
+		Nat count = code->count();
+		Nat steps = 0;
+		for (Nat i = next(line); i < count && steps < maxScan; i = next(i), steps++) {
+			Instr *instr = code->at(i);
+			switch (instr->op()) {
+			case op::jmp:
+				if (instr->src().condFlag() == ifNever)
+					continue;
+				// Conditional jumps read the flags, and we do not follow unconditional jumps.
+				return false;
+			case op::jmpBlock:
+			case op::setCond:
+			case op::adc:
+			case op::sbb:
+			case op::pushFlags:
+				return false;
+			case op::cmp:
+			case op::test:
+			case op::fcmp:
+				// Overwrites the flags.
+				return true;
+			case op::fnCall:
+			case op::fnCallRef:
+			case op::call:
+			case op::fnRet:
+			case op::fnRetRef:
+			case op::ret:
+				// Flags are not preserved across function calls and returns.
+				return true;
+			default:
+				// Other instructions might not update the flags on all architectures.
+				break;
+			}
+		}
+
+		return false;
+	}
+
+	Bool Peephole::regDead(Reg r, Nat line) const {
+		Nat count = code->count();
+		Nat steps = 0;
+		for (Nat i = next(line); i < count && steps < maxScan; i = next(i), steps++) {
+			Instr *instr = code->at(i);
+			if (readsReg(instr, r))
+				return false;
+
+			switch (instr->op()) {
+			case op::fnCall:
+			case op::fnCallRef:
+			case op::call: {
+				// Does the call overwrite the register?
+				RegSet *preserved = new (this) RegSet(r);
+				arena->removeFnRegs(preserved);
+				if (!preserved->has(r))
+					return true;
+				break;
+			}
+			case op::fnRet:
+			case op::fnRetRef:
+				return true;
+			case op::jmp:
+			case op::jmpBlock:
+			case op::endBlock:
+			case op::ret:
+				// Control flow, or possible implicit uses.
+				return false;
+			default:
+				break;
+			}
+
+			const Operand &dest = instr->dest();
+			if ((instr->mode() & destWrite) && dest.type() == opRegister && same(dest.reg(), r)) {
+				if (size(dest.reg()).size64() >= size(r).size64())
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	Bool Peephole::constantAt(const Operand &op, Nat line, Word &out) const {
+		if (op.type() == opConstant) {
+			out = op.constant();
+			return true;
+		}
+
+		if (op.type() != opRegister && op.type() != opVariable)
+			return false;
+
+		// Was it just assigned a constant?
+		Nat p = prev(line);
+		if (p >= code->count() || joins(p, line))
+			return false;
+
+		Instr *instr = code->at(p);
+		if (instr->op() != op::mov || instr->dest() != op || instr->src().type() != opConstant)
+			return false;
+
+		out = instr->src().constant();
+		return true;
+	}
+
+	Bool Peephole::jumps() {
+		Bool changed = false;
+		Nat count = code->count();
+
+		for (Nat i = 0; i < count; i++) {
+			Instr *instr = code->at(i);
+			if (!instr || instr->op() != op::jmp || instr->dest().type() != opLabel)
+				continue;
+
+			CondFlag cond = instr->src().condFlag();
+			if (cond == ifNever) {
+				code->at(i) = null;
+				changed = true;
+				continue;
+			}
+
+			// Follow chains of unconditional jumps.
+			Label to = instr->dest().label();
+			for (Nat hops = 0; hops < maxScan; hops++) {
+				Nat t = target(to);
+				if (t >= count)
+					break;
+
+				Instr *at = code->at(t);
+				if (at->op() != op::jmp || at->dest().type() != opLabel || at->src().condFlag() != ifAlways)
+					break;
+				if (at->dest().label() == to)
+					break;
+				to = at->dest().label();
+			}
+
+			if (to != instr->dest().label()) {
+				code->at(i) = jmp(engine(), to, cond);
+				changed = true;
+			}
+
+			// Jumps to the next instruction are not needed.
+			if (target(to) == next(i)) {
+				code->at(i) = null;
+				changed = true;
+			}
+		}
+
+		return changed;
+	}
+
+	Bool Peephole::constants() {
+		Bool changed = false;
+		Nat count = code->count();
+
+		for (Nat i = 0; i < count; i++) {
+			Instr *instr = code->at(i);
+			if (!instr)
+				continue;
+
+			Operand dest = instr->dest();
+			Operand src = instr->src();
+
+			if (instr->op() == op::cmp) {
+				// Comparison of known values, followed by a conditional jump?
+				Word a, b;
+				Nat size = bits(dest.size());
+				Nat j = next(i);
+				if (size && constantAt(dest, i, a) && constantAt(src, i, b) && j < count && !joins(i, j)) {
+					Instr *jump = code->at(j);
+					CondFlag cond = jump->op() == op::jmp ? jump->src().condFlag() : ifAlways;
+					Bool taken = false;
+					if (cond != ifAlways && jump->dest().type() == opLabel && evaluate(cond, a, b, size, taken)) {
+						code->at(j) = taken ? jmp(engine(), jump->dest().label(), ifAlways) : null;
+						changed = true;
+					}
+				}
+			}
+
+			if (instr->op() == op::cmp || instr->op() == op::test) {
+				// Comparisons without any effect.
+				if (flagsDead(i)) {
+					code->at(i) = null;
+					changed = true;
+				}
+				continue;
+			}
+
+			Nat size = bits(dest.size());
+			Nat srcSize = bits(src.size());
+			if (!size || !srcSize || src.type() != opConstant)
+				continue;
+
+			Word value = src.constant() & mask(srcSize);
+			Nat shift = exactLog2(value);
+			Instr *replace = instr;
+			switch (instr->op()) {
+			case op::add:
+			case op::sub:
+			case op::bor:
+			case op::bxor:
+			case op::shl:
+			case op::shr:
+			case op::sar:
+				if (value == 0)
+					replace = null;
+				break;
+			case op::band:
+				if (value == mask(size))
+					replace = null;
+				else if (value == 0)
+					replace = mov(engine(), dest, xConst(dest.size(), 0));
+				break;
+			case op::mul:
+				if (value == 1)
+					replace = null;
+				else if (value == 0)
+					replace = mov(engine(), dest, xConst(dest.size(), 0));
+				else if (shift)
+					replace = shl(engine(), dest, byteConst(Byte(shift)));
+				break;
+			case op::idiv:
+				if (value == 1)
+					replace = null;
+				break;
+			case op::udiv:
+				if (value == 1)
+					replace = null;
+				else if (shift)
+					replace = shr(engine(), dest, byteConst(Byte(shift)));
+				break;
+			case op::imod:
+				if (value == 1)
+					replace = mov(engine(), dest, xConst(dest.size(), 0));
+				break;
+			case op::umod:
+				if (value == 1)
+					replace = mov(engine(), dest, xConst(dest.size(), 0));
+				else if (shift)
+					replace = band(engine(), dest, xConst(dest.size(), value - 1));
+				break;
+			default:
+				break;
+			}
+
+			if (replace == instr)
+				continue;
+			if (!replace && isIntRegister(dest))
+				continue;
+			if (!flagsDead(i))
+				continue;
+
+			code->at(i) = replace;
+			changed = true;
+		}
+
+		return changed;
+	}
+
+	Bool Peephole::stores() {
+		Bool changed = false;
+		Nat count = code->count();
+
+		for (Nat i = 0; i < count; i++) {
+			Instr *instr = code->at(i);
+			if (!instr || instr->op() != op::mov)
+				continue;
+
+			Operand a = instr->dest();
+			Operand b = instr->src();
+
+			// Move to itself.
+			if (a == b && !isIntRegister(a)) {
+				code->at(i) = null;
+				changed = true;
+				continue;
+			}
+
+			Nat j = next(i);
+			if (j >= count || joins(i, j))
+				continue;
+
+			Instr *other = code->at(j);
+			if (other->op() != op::mov)
+				continue;
+
+			Operand c = other->dest();
+			Operand d = other->src();
+
+			if (c == b && d == a) {
+				// Loading a value that was just stored, or storing a value that was just loaded.
+				// Loading into a 32-bit register clears the upper part of it, so that load has to
+				// stay.
+				Bool regVar = a.type() == opRegister && b.type() == opVariable;
+				Bool varReg = a.type() == opVariable && b.type() == opRegister && !isIntRegister(b);
+				if (regVar || varReg) {
+					code->at(j) = null;
+					changed = true;
+				}
+			} else if (c == a && a.type() == opVariable) {
+				// The first store is overwritten immediately. Make sure the second one does not
+				// read the variable through a pointer.
+				if (d.type() == opRegister || d.type() == opConstant) {
+					code->at(i) = null;
+					changed = true;
+				}
+			}
+		}
+
+		return changed;
+	}
+
+	Bool Peephole::copies() {
+		Bool changed = false;
+		Nat count = code->count();
+
+		for (Nat i = 0; i < count; i++) {
+			Instr *instr = code->at(i);
+			if (!instr || instr->op() != op::mov)
+				continue;
+
+			// Looking for: mov(r, x); mov(y, r), where 'r' is a temporary register.
+			Operand r = instr->dest();
+			Operand x = instr->src();
+			if (r.type() != opRegister || !arena->intRegister(r.reg()))
+				continue;
+			if (same(r.reg(), ptrStack) || same(r.reg(), ptrFrame))
+				continue;
+			// 'ret' returns the value in 'ptrA' implicitly.
+			if (hasRet && same(r.reg(), ptrA))
+				continue;
+
+			if (x.type() == opRegister) {
+				if (!arena->intRegister(x.reg()))
+					continue;
+			} else if (x.type() != opConstant) {
+				continue;
+			}
+
+			Nat j = next(i);
+			if (j >= count || joins(i, j))
+				continue;
+
+			Instr *other = code->at(j);
+			if (other->op() != op::mov || other->src() != r)
+				continue;
+
+			Operand y = other->dest();
+			if (y.type() == opRegister) {
+				if (!arena->intRegister(y.reg()))
+					continue;
+			} else if (y.type() != opVariable) {
+				continue;
+			}
+
+			if (!regDead(r.reg(), j))
+				continue;
+
+			code->at(i) = null;
+			code->at(j) = mov(engine(), y, x);
+			changed = true;
+
+			// Don't consider the new instruction until the next iteration.
+			i = j;
+		}
+
+		return changed;
+	}
+
+}
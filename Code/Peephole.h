@@ -0,0 +1,93 @@
+#pragma once
+#include "Transform.h"
+#include "Listing.h"
+#include "Core/Array.h"
+
+namespace code {
+	STORM_PKG(core.asm);
+
+	class Arena;
+
+	/**
+	 * Architecture-neutral peephole optimizations.
+	 *
+	 * Front-ends generally emit quite literal code, which contains patterns like a store to a
+	 * variable that is immediately loaded again, jumps to jumps, and arithmetic with constants
+	 * that has no effect. This transform removes the most common of these patterns:
+	 *
+	 * - Jumps to other jumps are redirected to the final destination, and jumps to the next
+	 *   instruction are removed.
+	 * - Conditional jumps after comparisons of known constants are either made unconditional or
+	 *   removed.
+	 * - Loads of a value that was just stored (and stores of a value that was just loaded) are
+	 *   removed, as are stores that are immediately overwritten.
+	 * - Values that are copied through a temporary register are copied directly, if the
+	 *   temporary register is not used afterwards.
+	 * - Arithmetic with constants that does not affect the result is removed, and
+	 *   multiplications, divisions and modulo operations with powers of two are replaced with
+	 *   shifts and masks.
+	 *
+	 * All optimizations only consider instructions that are executed in sequence, without any
+	 * labels in between. Instructions that may affect the flags are only modified if the flags
+	 * are overwritten before they are used.
+	 *
+	 * Should be executed before the backend's other transforms.
+	 */
+	class Peephole : public Transform {
+		STORM_CLASS;
+	public:
+		STORM_CTOR Peephole(const Arena *arena);
+
+		// Start transform.
+		virtual void STORM_FN before(Listing *dest, Listing *src);
+
+		// Transform a single instruction.
+		virtual void STORM_FN during(Listing *dest, Listing *src, Nat id);
+
+	private:
+		// Arena.
+		const Arena *arena;
+
+		// Does each line have labels?
+		Array<Bool> *labelled;
+
+		// Instruction to emit for each line in the source listing. Null if the instruction was
+		// removed.
+		Array<Instr *> *code;
+
+		// Line of each label.
+		Array<Nat> *labelLine;
+
+		// Does the listing contain 'ret' instructions?
+		Bool hasRet;
+
+		// Optimization passes. Returns true if anything was changed.
+		Bool jumps();
+		Bool constants();
+		Bool stores();
+		Bool copies();
+
+		// Next line containing an instruction after 'line'. Returns 'code->count()' if none.
+		Nat next(Nat line) const;
+
+		// Previous line containing an instruction before 'line'. Returns 'code->count()' if none.
+		Nat prev(Nat line) const;
+
+		// Are there any labels on the lines (from, to]? If so, execution may reach 'to' from
+		// somewhere other than 'from'.
+		Bool joins(Nat from, Nat to) const;
+
+		// First line containing an instruction at or after the location of 'label'.
+		Nat target(Label label) const;
+
+		// Are the flags after 'line' overwritten before they are read?
+		Bool flagsDead(Nat line) const;
+
+		// Is the register 'r' overwritten after 'line' before it is read?
+		Bool regDead(Reg r, Nat line) const;
+
+		// Try to find the value of 'op' at 'line', if it is a constant.
+		Bool constantAt(const Operand &op, Nat line, Word &out) const;
+	};
+
+}
@@ -0,0 +1,382 @@
+#include "stdafx.h"
+#include "RegAlloc.h"
+#include "Arena.h"
+#include "UsedRegs.h"
+
+namespace code {
+
+	RegAlloc::RegAlloc(const Arena *arena) : arena(arena), any(false) {}
+
+	// Is 'desc' a value that is stored in integer registers?
+	static Bool intValue(TypeDesc *desc) {
+		PrimitiveDesc *p = as<PrimitiveDesc>(desc);
+		return p && p->v.kind() != primitive::real;
+	}
+
+	// Is 'v' a variable we can store in a register, disregarding how it is used?
+	static Bool candidate(Listing *src, Var v) {
+		if (src->freeFn(v).any())
+			return false;
+		if (src->freeOpt(v) & (freeIndirection | freeInactive))
+			return false;
+
+		Size size = v.size();
+		if (size != Size::sByte && size != Size::sInt && size != Size::sLong && size != Size::sPtr)
+			return false;
+
+		if (src->isParam(v))
+			return intValue(src->paramDesc(v));
+
+		return true;
+	}
+
+	void RegAlloc::before(Listing *dest, Listing *src) {
+		Nat vars = src->allVars()->count();
+		assigned = new (this) Array<Nat>(vars, Nat(noReg));
+		first = new (this) Array<Nat>(vars, src->count());
+		last = new (this) Array<Nat>(vars, 0);
+		eligible = new (this) Array<Bool>(vars, false);
+		any = false;
+
+		if (!liveRanges(src))
+			return;
+
+		allocate(src);
+
+		// The stack slots of variables in registers are never used, so there is no need to
+		// initialize them.
+		Array<Var> *all = src->allVars();
+		for (Nat i = 0; i < all->count(); i++) {
+			Var v = all->at(i);
+			if (assigned->at(v.key()) != noReg && !src->isParam(v))
+				dest->freeOpt(v, src->freeOpt(v) | freeNoInit);
+		}
+	}
+
+	void RegAlloc::during(Listing *dest, Listing *src, Nat line) {
+		Instr *instr = src->at(line);
+		if (!any) {
+			*dest << instr;
+			return;
+		}
+
+		switch (instr->op()) {
+		case op::prolog: {
+			*dest << instr;
+
+			// Load parameters into their registers.
+			Array<Var> *params = src->allParams();
+			for (Nat i = 0; i < params->count(); i++) {
+				Var p = params->at(i);
+				Reg r = Reg(assigned->at(p.key()));
+				if (r != noReg)
+					*dest << mov(asSize(r, p.size()), p);
+			}
+
+			initBlock(dest, src, src->root());
+			return;
+		}
+		case op::beginBlock:
+			*dest << instr;
+			initBlock(dest, src, instr->src().block());
+			return;
+		default:
+			break;
+		}
+
+		Operand to = replace(instr->dest());
+		Operand from = replace(instr->src());
+		if (to != instr->dest() || from != instr->src())
+			instr = instr->alter(to, from);
+		*dest << instr;
+	}
+
+	// Does 'op' refer to a register that is not an integer register?
+	static Bool nonIntReg(const Arena *arena, const Operand &op) {
+		return op.type() == opRegister && !arena->intRegister(op.reg());
+	}
+
+	// Does 'op' refer to a label?
+	static Bool isLabel(const Operand &op) {
+		return op.type() == opLabel || op.type() == opRelativeLbl;
+	}
+
+	Bool RegAlloc::liveRanges(Listing *src) {
+		// Execution may resume at a catch handler at any point where an exception is thrown. At
+		// that point, the contents of the registers are not reliable.
+		if (src->exceptionCaught())
+			return false;
+
+		Nat lines = src->count();
+
+		Array<Var> *vars = src->allVars();
+		for (Nat i = 0; i < vars->count(); i++) {
+			Var v = vars->at(i);
+			eligible->at(v.key()) = candidate(src, v);
+		}
+
+		// Line of each label.
+		Array<Nat> *labelLine = new (this) Array<Nat>(src->labelCount(), lines);
+		for (Nat i = 0; i <= lines; i++) {
+			if (Array<Label> *labels = src->labels(i)) {
+				for (Nat j = 0; j < labels->count(); j++) {
+					Nat id = labels->at(j).key();
+					if (id < labelLine->count())
+						labelLine->at(id) = i;
+				}
+			}
+		}
+
+		// Backward edges in the control flow, and where each block is entered first.
+		Array<Nat> *jumpFrom = new (this) Array<Nat>();
+		Array<Nat> *jumpTo = new (this) Array<Nat>();
+		Array<Nat> *blockBegin = new (this) Array<Nat>(src->allBlocks()->count(), lines);
+		Nat prolog = lines;
+
+		for (Nat i = 0; i < lines; i++) {
+			Instr *instr = src->at(i);
+			Operand dest = instr->dest();
+			Operand from = instr->src();
+
+			if (instr->op() == op::prolog) {
+				if (prolog == lines)
+					prolog = i;
+			} else if (instr->op() == op::beginBlock) {
+				Nat &begin = blockBegin->at(from.block().key());
+				begin = min(begin, i);
+			}
+
+			if ((instr->op() == op::jmp || instr->op() == op::jmpBlock) && dest.type() == opLabel) {
+				Nat to = labelLine->at(dest.label().key());
+				if (to < i) {
+					jumpFrom->push(i);
+					jumpTo->push(to);
+				}
+			} else {
+				// Labels used as data may be the target of indirect jumps from anywhere.
+				if (isLabel(dest)) {
+					jumpFrom->push(lines);
+					jumpTo->push(labelLine->at(dest.label().key()));
+				}
+				if (isLabel(from)) {
+					jumpFrom->push(lines);
+					jumpTo->push(labelLine->at(from.label().key()));
+				}
+			}
+
+			// Variables used together with fp registers are most likely not integers.
+			Bool intRegs = !nonIntReg(arena, dest) && !nonIntReg(arena, from);
+
+			if (dest.type() == opVariable) {
+				Nat id = dest.var().key();
+				if (!intRegs || !accessOk(src, instr, dest, true)) {
+					eligible->at(id) = false;
+				} else {
+					first->at(id) = min(first->at(id), i);
+					last->at(id) = max(last->at(id), i);
+				}
+			}
+
+			if (from.type() == opVariable) {
+				Nat id = from.var().key();
+				if (!intRegs || !accessOk(src, instr, from, false)) {
+					eligible->at(id) = false;
+				} else {
+					first->at(id) = min(first->at(id), i);
+					last->at(id) = max(last->at(id), i);
+				}
+			}
+		}
+
+		if (prolog == lines)
+			return false;
+		blockBegin->at(src->root().key()) = prolog;
+
+		Bool found = false;
+		for (Nat i = 0; i < vars->count(); i++) {
+			Var v = vars->at(i);
+			Nat id = v.key();
+			if (!eligible->at(id))
+				continue;
+
+			// Unused variables do not need a register.
+			if (first->at(id) == lines) {
+				eligible->at(id) = false;
+				continue;
+			}
+
+			// The variable is live from where its block is entered, since it is initialized
+			// there.
+			Nat start = src->isParam(v) ? prolog : blockBegin->at(src->parent(v).key());
+			if (start == lines) {
+				eligible->at(id) = false;
+				continue;
+			}
+			first->at(id) = min(first->at(id), start);
+
+			// If the variable is live at the start of a loop, it is live throughout the loop.
+			Bool changed;
+			do {
+				changed = false;
+				for (Nat j = 0; j < jumpFrom->count(); j++) {
+					Nat to = jumpTo->at(j);
+					Nat from = jumpFrom->at(j);
+					if (first->at(id) <= to && to <= last->at(id) && from > last->at(id)) {
+						last->at(id) = from;
+						changed = true;
+					}
+				}
+			} while (changed);
+
+			found = true;
+		}
+
+		return found;
+	}
+
+	Bool RegAlloc::accessOk(Listing *src, Instr *instr, const Operand &op, Bool isDest) {
+		// Only accesses to the entire variable.
+		if (op.offset() != Offset() || op.size() != op.var().size())
+			return false;
+
+		switch (instr->op()) {
+		case op::mov:
+		case op::add:
+		case op::adc:
+		case op::sub:
+		case op::sbb:
+		case op::cmp:
+		case op::test:
+		case op::bor:
+		case op::band:
+		case op::bxor:
+		case op::bnot:
+		case op::mul:
+		case op::idiv:
+		case op::udiv:
+		case op::imod:
+		case op::umod:
+		case op::shl:
+		case op::shr:
+		case op::sar:
+		case op::icast:
+		case op::ucast:
+		case op::setCond:
+			return true;
+		case op::fnParam:
+			if (TypeInstr *t = as<TypeInstr>(instr))
+				return !isDest && intValue(t->type);
+			return false;
+		case op::fnCall:
+			if (TypeInstr *t = as<TypeInstr>(instr))
+				return isDest && intValue(t->type);
+			return false;
+		case op::fnRet:
+			return !isDest && intValue(src->result);
+		default:
+			// Most likely, the address of the variable is needed.
+			return false;
+		}
+	}
+
+	// Order variables by the start of their live ranges.
+	struct StartOrder {
+		Array<Nat> *first;
+
+		StartOrder(Array<Nat> *first) : first(first) {}
+
+		bool operator ()(Nat a, Nat b) const {
+			if (first->at(a) != first->at(b))
+				return first->at(a) < first->at(b);
+			return a < b;
+		}
+	};
+
+	void RegAlloc::allocate(Listing *src) {
+		RegSet *used = allUsedRegs(src);
+		RegSet *regs = arena->varRegs();
+
+		vector<Reg> free;
+		for (RegSet::Iter i = regs->begin(), end = regs->end(); i != end; ++i)
+			if (!used->has(*i))
+				free.push_back(*i);
+
+		if (free.empty())
+			return;
+
+		vector<Nat> order;
+		for (Nat i = 0; i < eligible->count(); i++)
+			if (eligible->at(i))
+				order.push_back(i);
+		std::sort(order.begin(), order.end(), StartOrder(first));
+
+		// Variables currently in registers.
+		vector<Nat> active;
+
+		for (size_t i = 0; i < order.size(); i++) {
+			Nat id = order[i];
+
+			// Release registers of variables that are no longer live.
+			for (size_t j = 0; j < active.size(); ) {
+				if (last->at(active[j]) < first->at(id)) {
+					free.push_back(Reg(assigned->at(active[j])));
+					active[j] = active.back();
+					active.pop_back();
+				} else {
+					j++;
+				}
+			}
+
+			if (!free.empty()) {
+				assigned->at(id) = free.back();
+				free.pop_back();
+				active.push_back(id);
+				continue;
+			}
+
+			// Out of registers. Keep the variable that is live the longest in memory.
+			size_t furthest = 0;
+			for (size_t j = 1; j < active.size(); j++)
+				if (last->at(active[j]) > last->at(active[furthest]))
+					furthest = j;
+
+			Nat spill = active[furthest];
+			if (last->at(spill) > last->at(id)) {
+				assigned->at(id) = assigned->at(spill);
+				assigned->at(spill) = noReg;
+				active[furthest] = id;
+			}
+		}
+
+		for (Nat i = 0; i < assigned->count(); i++)
+			if (assigned->at(i) != noReg)
+				any = true;
+	}
+
+	Operand RegAlloc::replace(const Operand &op) const {
+		if (op.type() != opVariable)
+			return op;
+
+		Reg r = Reg(assigned->at(op.var().key()));
+		if (r == noReg)
+			return op;
+
+		return asSize(r, op.size());
+	}
+
+	void RegAlloc::initBlock(Listing *dest, Listing *src, Block block) {
+		Array<Var> *vars = src->allVars(block);
+		for (Nat i = 0; i < vars->count(); i++) {
+			Var v = vars->at(i);
+			Reg r = Reg(assigned->at(v.key()));
+			if (r == noReg || src->isParam(v))
+				continue;
+			if (src->freeOpt(v) & freeNoInit)
+				continue;
+
+			// Note: 'mov' rather than 'bxor' so that flags are not affected.
+			*dest << mov(asSize(r, v.size()), xConst(v.size(), 0));
+		}
+	}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "Transform.h"
+#include "Listing.h"
+#include "Reg.h"
+#include "Core/Array.h"
+
+namespace code {
+	STORM_PKG(core.asm);
+
+	class Arena;
+
+	/**
+	 * Allocate variables to registers.
+	 *
+	 * Assigns the registers in 'Arena::varRegs' to variables in a listing, so that the backend does
+	 * not need to access the stack each time the variables are used. The backends only provide
+	 * registers that are preserved across function calls. Therefore, values in these registers
+	 * survive function calls without any spill code, and the layout transform saves and restores
+	 * them in the prolog and epilog like any other preserved register used by the listing.
+	 *
+	 * The allocation is a linear scan over the live ranges of all eligible variables. A live range
+	 * is approximated as the lines from where the variable's block is entered until the last use
+	 * of the variable, extended to cover any loops it is live in. If there are not enough
+	 * registers, the variable whose live range ends last is kept on the stack.
+	 *
+	 * A variable is only eligible if it is always accessed as a whole, in instructions that accept
+	 * a register in place of a memory operand, and if its address is never taken. Variables with
+	 * destructors are never allocated to registers. Neither are variables in listings that catch
+	 * exceptions, since execution may resume at the catch handler with the registers in an unknown
+	 * state.
+	 *
+	 * Should be executed before the backend's other transforms.
+	 */
+	class RegAlloc : public Transform {
+		STORM_CLASS;
+	public:
+		STORM_CTOR RegAlloc(const Arena *arena);
+
+		// Start transform.
+		virtual void STORM_FN before(Listing *dest, Listing *src);
+
+		// Transform a single instruction.
+		virtual void STORM_FN during(Listing *dest, Listing *src, Nat id);
+
+	private:
+		// Arena.
+		const Arena *arena;
+
+		// Register assigned to each variable, or 'noReg' if it is kept in memory. Indexed by the
+		// key of the variables.
+		Array<Nat> *assigned;
+
+		// First and last line where each variable is live. Only valid for eligible variables.
+		Array<Nat> *first;
+		Array<Nat> *last;
+
+		// Is each variable eligible for allocation?
+		Array<Bool> *eligible;
+
+		// Any variables allocated to registers?
+		Bool any;
+
+		// Find eligible variables and their live ranges. Returns false if no variables in the
+		// listing can be allocated.
+		Bool liveRanges(Listing *src);
+
+		// Allocate registers to the live ranges found by 'liveRanges'.
+		void allocate(Listing *src);
+
+		// Check if a variable may be accessed by an instruction if it is stored in a register.
+		Bool accessOk(Listing *src, Instr *instr, const Operand &op, Bool isDest);
+
+		// Replace a variable with its register, if it has one.
+		Operand replace(const Operand &op) const;
+
+		// Initialize all variables in 'block' that are stored in registers.
+		void initBlock(Listing *dest, Listing *src, Block block);
+	};
+
+}
@@ -5,6 +5,8 @@
 #include "Asm.h"
 #include "AsmOut.h"
 #include "RemoveInvalid.h"
+#include "Code/Peephole.h"
+#include "Code/RegAlloc.h"
 #include "WindowsLayout.h"
 #include "PosixLayout.h"
 #include "Code/PosixEh/StackInfo.h"
@@ -37,6 +39,16 @@ namespace code {
 			return l;
 		}
 
+		Listing *Arena::optimize(Listing *l) const {
+			// Simplify the code before doing anything else.
+			l = code::transform(l, this, new (this) Peephole(this));
+
+			// Store variables in registers where possible.
+			l = code::transform(l, this, new (this) RegAlloc(this));
+
+			return l;
+		}
+
 		void Arena::output(Listing *src, Output *to) const {
 			code::x64::output(src, to);
 			to->finish();
@@ -51,6 +63,24 @@ namespace code {
 				from->remove(*i);
 		}
 
+		RegSet *Arena::varRegs() const {
+			// Note: 'r15' is used by the function call transform, so it is not included. 'rsi' and
+			// 'rdi' are only preserved on Windows.
+			static const Reg candidates[] = {
+				ptrB, ptr12, ptr13, ptr14, ptrSi, ptrDi,
+			};
+
+			RegSet *result = new (this) RegSet();
+			for (size_t i = 0; i < ARRAY_COUNT(candidates); i++)
+				if (!dirtyRegs->has(candidates[i]))
+					result->put(candidates[i]);
+			return result;
+		}
+
+		Bool Arena::intRegister(Reg r) const {
+			return !fpRegister(r);
+		}
+
 		Listing *Arena::redirect(Bool member, TypeDesc *result, Array<TypeDesc *> *params, Ref fn, Operand param) {
 			Listing *l = new (this) Listing(this);
 
@@ -24,6 +24,7 @@ namespace code {
 			 */
 
 			virtual Listing *STORM_FN transform(Listing *src) const;
+			virtual Listing *STORM_FN optimize(Listing *src) const;
 			virtual void STORM_FN output(Listing *src, Output *to) const;
 
 			/**
@@ -37,6 +38,8 @@ namespace code {
 			 */
 
 			virtual void STORM_FN removeFnRegs(RegSet *from) const;
+			virtual RegSet *STORM_FN varRegs() const;
+			virtual Bool STORM_FN intRegister(Reg r) const;
 
 			/**
 			 * Misc.
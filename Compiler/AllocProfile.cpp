@@ -0,0 +1,163 @@
+#include "stdafx.h"
+#include "AllocProfile.h"
+#include "Engine.h"
+#include "Type.h"
+#include "Core/StrBuf.h"
+#include "Gc/HeapSnapshot.h"
+
+namespace storm {
+
+	static void putType(StrBuf *to, Type *type) {
+		if (type)
+			*to << type->identifier();
+		else
+			*to << S("<no type>");
+	}
+
+	// Sort (size, id) pairs with the largest size first.
+	typedef std::pair<size_t, nat> SizeId;
+
+	static bool largestFirst(const SizeId &a, const SizeId &b) {
+		if (a.first != b.first)
+			return a.first > b.first;
+		return a.second < b.second;
+	}
+
+	AllocSite::AllocSite(Type *type, StackTrace trace, Word samples, Word bytes)
+		: type(type), trace(trace), samples(samples), bytes(bytes) {}
+
+	void AllocSite::toS(StrBuf *to) const {
+		*to << bytes << S(" bytes (") << samples << S(" samples) of ");
+		putType(to, type);
+		*to << S(" at:\n");
+		trace.format(to);
+	}
+
+	void startAllocProfile(EnginePtr e, Nat interval) {
+		e.v.gc.profiler.start(interval);
+	}
+
+	void stopAllocProfile(EnginePtr e) {
+		e.v.gc.profiler.stop();
+	}
+
+	void clearAllocProfile(EnginePtr e) {
+		e.v.gc.profiler.clear();
+	}
+
+	Array<AllocSite> *allocProfile(EnginePtr e) {
+		AllocProfiler &profiler = e.v.gc.profiler;
+
+		// Sites may be added while we are working, but existing sites are never removed. Note:
+		// 'Site' contains pointers that are only safe to keep on the stack, so we only store the
+		// sizes here.
+		vector<SizeId> order;
+		AllocProfiler::Site site;
+		for (nat i = 0; profiler.site(i, site); i++)
+			order.push_back(SizeId(site.bytes, i));
+		std::sort(order.begin(), order.end(), &largestFirst);
+
+		Array<AllocSite> *result = new (e.v) Array<AllocSite>();
+		result->reserve(Nat(order.size()));
+		for (size_t i = 0; i < order.size(); i++) {
+			if (!profiler.site(order[i].second, site))
+				continue;
+
+			StackTrace trace(e.v);
+			trace.reserve(site.frameCount);
+			for (nat j = 0; j < site.frameCount; j++) {
+				const StackFrame &f = site.frames[j];
+				trace.push(StackTrace::Frame(f.fnBase, Nat(f.offset), Nat(f.id)));
+			}
+
+			result->push(AllocSite(site.type, trace, site.samples, site.bytes));
+		}
+
+		return result;
+	}
+
+	Str *allocProfileReport(EnginePtr e, Nat limit) {
+		Array<AllocSite> *sites = allocProfile(e);
+
+		// Aggregate by type. 'sites' is scanned by the GC, so the types are valid even if objects
+		// are moved while we are working.
+		vector<nat> typeSite;
+		vector<size_t> typeSamples;
+		vector<SizeId> typeBytes;
+		Word total = 0;
+		for (Nat i = 0; i < sites->count(); i++) {
+			const AllocSite &site = sites->at(i);
+			total += site.samples;
+
+			nat found = nat(typeSite.size());
+			for (nat j = 0; j < typeSite.size(); j++) {
+				if (sites->at(typeSite[j]).type == site.type) {
+					found = j;
+					break;
+				}
+			}
+
+			if (found == typeSite.size()) {
+				typeSite.push_back(i);
+				typeSamples.push_back(0);
+				typeBytes.push_back(SizeId(0, found));
+			}
+
+			typeSamples[found] += size_t(site.samples);
+			typeBytes[found].first += size_t(site.bytes);
+		}
+		std::sort(typeBytes.begin(), typeBytes.end(), &largestFirst);
+
+		StrBuf *to = new (e.v) StrBuf();
+		*to << S("Allocation profile: ") << total << S(" samples, ")
+			<< Word(e.v.gc.profiler.dropped()) << S(" dropped\n");
+
+		*to << S("\nBy type:\n");
+		for (size_t i = 0; i < typeBytes.size(); i++) {
+			nat id = typeBytes[i].second;
+			*to << width(12) << Word(typeBytes[i].first) << S(" bytes ")
+				<< width(8) << Word(typeSamples[id]) << S(" samples  ");
+			putType(to, sites->at(typeSite[id]).type);
+			*to << S("\n");
+		}
+
+		*to << S("\nBy call site:\n");
+		for (Nat i = 0; i < sites->count() && i < limit; i++) {
+			*to << S("\n");
+			sites->at(i).toS(to);
+			*to << S("\n");
+		}
+
+		return to->toS();
+	}
+
+
+	HeapType::HeapType(Type *type, Word count, Word bytes, Word retained)
+		: type(type), count(count), bytes(bytes), retained(retained) {}
+
+	void HeapType::toS(StrBuf *to) const {
+		putType(to, type);
+		*to << S(": ") << count << S(" objects, ") << bytes << S(" bytes, ")
+			<< retained << S(" bytes retained");
+	}
+
+	Array<HeapType> *heapSnapshot(EnginePtr e) {
+		HeapSnapshot snapshot(e.v.gc);
+
+		vector<SizeId> order;
+		order.reserve(snapshot.count());
+		for (nat i = 0; i < snapshot.count(); i++)
+			order.push_back(SizeId(snapshot.at(i).retained, i));
+		std::sort(order.begin(), order.end(), &largestFirst);
+
+		Array<HeapType> *result = new (e.v) Array<HeapType>();
+		result->reserve(snapshot.count());
+		for (size_t i = 0; i < order.size(); i++) {
+			HeapSnapshot::Entry entry = snapshot.at(order[i].second);
+			result->push(HeapType(entry.type, entry.count, entry.bytes, entry.retained));
+		}
+
+		return result;
+	}
+
+}
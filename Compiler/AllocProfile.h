@@ -0,0 +1,87 @@
+#pragma once
+#include "Core/Array.h"
+#include "Core/EnginePtr.h"
+#include "Core/StackTrace.h"
+
+namespace storm {
+	STORM_PKG(core);
+
+	class Type;
+
+	/**
+	 * A call site that allocated memory, as reported by `allocProfile`.
+	 */
+	class AllocSite {
+		STORM_VALUE;
+	public:
+		// Create.
+		STORM_CTOR AllocSite(MAYBE(Type *) type, StackTrace trace, Word samples, Word bytes);
+
+		// Type of the allocated objects. Null for allocations without a type, for example arrays.
+		MAYBE(Type *) type;
+
+		// Stack trace of the call site. Only the topmost frames are included.
+		StackTrace trace;
+
+		// Number of samples taken at this call site.
+		Word samples;
+
+		// Estimated number of bytes allocated from this call site.
+		Word bytes;
+
+		// Output.
+		void STORM_FN toS(StrBuf *to) const;
+	};
+
+	// Start sampling allocations, approximately once every `interval` bytes. Samples from previous
+	// runs of the profiler are kept until `clearAllocProfile` is called. The overhead is low for
+	// coarse intervals (e.g. one sample every megabyte), so it is reasonable to keep the profiler
+	// running in production.
+	void STORM_FN startAllocProfile(EnginePtr e, Nat interval);
+
+	// Stop sampling allocations. Keeps the samples collected so far.
+	void STORM_FN stopAllocProfile(EnginePtr e);
+
+	// Remove all samples.
+	void STORM_FN clearAllocProfile(EnginePtr e);
+
+	// Get all call sites sampled so far, the ones that allocated the most memory first.
+	Array<AllocSite> *STORM_FN allocProfile(EnginePtr e);
+
+	// Create a human-readable report of the samples collected so far. Allocations are aggregated
+	// both by type and by call site. At most `limit` call sites are included in the report.
+	Str *STORM_FN allocProfileReport(EnginePtr e, Nat limit);
+
+
+	/**
+	 * Information about all live objects of a type in the heap, as reported by `heapSnapshot`.
+	 */
+	class HeapType {
+		STORM_VALUE;
+	public:
+		// Create.
+		STORM_CTOR HeapType(MAYBE(Type *) type, Word count, Word bytes, Word retained);
+
+		// The type. Null for objects without a type.
+		MAYBE(Type *) type;
+
+		// Number of live objects.
+		Word count;
+
+		// Number of bytes used by the objects themselves.
+		Word bytes;
+
+		// Estimated number of bytes kept alive by the objects. Includes arrays referred to directly
+		// from the objects (e.g. the contents of an `Array` or a `Map`).
+		Word retained;
+
+		// Output.
+		void STORM_FN toS(StrBuf *to) const;
+	};
+
+	// Take a snapshot of all live objects in the heap, the types that retain the most memory
+	// first. This performs a full garbage collection and walks the entire heap, so it is an
+	// expensive operation. Returns an empty array if the GC does not support heap walks.
+	Array<HeapType> *STORM_FN heapSnapshot(EnginePtr e);
+
+}
@@ -19,6 +19,8 @@ namespace storm {
 			engine,
 			// Reference to the entry-point for lazy code updates.
 			lazyCodeUpdate,
+			// Reference to the entry-point for optimizing frequently called lazy code.
+			lazyCodeTierUp,
 			// Reference to the throw function for a rule.
 			ruleThrow,
 			// Allocate an object of the type given.
@@ -71,6 +73,14 @@ namespace storm {
 			createClassVariant,
 			// Create a Join instance.
 			createJoin,
+			// Parallel algorithms for arrays.
+			arrayParallelMap,
+			arrayParallelReduce,
+			// Access to 'receiveRaw' and 'tryReceiveRaw' in Channel.
+			channelReceive,
+			channelTryReceive,
+			// Access to 'takeRaw' in Transfer.
+			transferTake,
 
 			// Should be the last one.
 			count,
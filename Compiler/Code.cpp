@@ -5,9 +5,17 @@
 #include "Exception.h"
 #include "Engine.h"
 #include "Core/Str.h"
+#include "OS/ThreadPool.h"
 
 namespace storm {
 
+	static os::Thread spawnCodeWorkers(Engine &e) {
+		return os::ThreadPool::spawn(0, e.threadGroup);
+	}
+
+	STORM_DEFINE_THREAD_WAIT(CodeWorkers, &spawnCodeWorkers);
+
+
 	Code::Code() : toUpdate(null), owner(null) {}
 
 	void Code::attach(Function *to) {
@@ -128,7 +136,12 @@ namespace storm {
 	 * Lazy code.
 	 */
 
-	LazyCode::LazyCode(Fn<CodeGen *> *generate) : binary(null), sourceData(generate), state(sUnloaded) {}
+	// Number of calls before lazily generated code is compiled with optimizations. Most functions
+	// are only called a few times, so optimizing them is usually not worth the time it takes.
+	static const Nat tierUpCalls = 1000;
+
+	LazyCode::LazyCode(Fn<CodeGen *> *generate) :
+		binary(null), sourceData(generate), state(sUnloaded), callsLeft(0), pending(null) {}
 
 	void LazyCode::compile() {
 		// We're always running on the Compiler thread, so it is safe to call 'updateCodeLocal'.
@@ -136,6 +149,27 @@ namespace storm {
 			updateCodeLocal(this);
 	}
 
+	void LazyCode::compileOptimized() {
+		switch (state & sMask) {
+		case sUnloaded:
+			state |= sOptimize;
+			updateCodeLocal(this);
+			break;
+		case sLoaded:
+			if (pending)
+				tierUpLocal(this);
+			break;
+		}
+	}
+
+	Bool LazyCode::compiled() const {
+		return (state & sMask) == sLoaded;
+	}
+
+	Bool LazyCode::optimized() const {
+		return compiled() && !pending;
+	}
+
 	MAYBE(code::Listing *) LazyCode::source() {
 		// Load our code if we need to.
 		if ((state & sMask) != sLoaded)
@@ -150,6 +184,10 @@ namespace storm {
 	void LazyCode::discardSource() {
 		state |= sDiscardSource;
 
+		// Do not keep the listing alive only to optimize it later. The unoptimized code keeps
+		// working, it just never gets optimized.
+		pending = null;
+
 		if ((state & sMask) == sLoaded)
 			sourceData = null;
 	}
@@ -162,6 +200,7 @@ namespace storm {
 
 	void LazyCode::createRedirect() {
 		state = (state & ~sMask) | sUnloaded;
+		pending = null;
 		Engine &e = engine();
 		using code::TypeDesc;
 
@@ -173,15 +212,91 @@ namespace storm {
 		Bool member = owner->isMember();
 		TypeDesc *result = owner->result.desc(e);
 		code::Ref fn = e.ref(builtin::lazyCodeUpdate);
-		setCode(e.arena()->redirect(member, result, params, fn, code::objPtr(this)));
+		setCode(e.arena()->redirect(member, result, params, fn, code::objPtr(this)), true);
+	}
+
+	void LazyCode::setCode(code::Listing *to, Bool optimize) {
+		setCode(new (this) code::Binary(engine().arena(), to, optimize, false));
 	}
 
-	void LazyCode::setCode(code::Listing *to) {
-		binary = new (this) code::Binary(engine().arena(), to);
+	void LazyCode::setCode(code::Binary *to) {
+		binary = to;
 		if (toUpdate)
 			toUpdate->set(binary);
 	}
 
+	// Parameters to 'prepareBinary'.
+	struct PrepareParams {
+		code::Arena *arena;
+		code::Listing *src;
+		Bool optimize;
+	};
+
+	static code::Binary *CODECALL prepareBinary(PrepareParams *params) {
+		return code::Binary::prepare(params->arena, params->src, params->optimize);
+	}
+
+	code::Binary *LazyCode::compileBinary(code::Listing *src, Bool optimize) {
+		Engine &e = engine();
+
+		// The worker threads are not available during startup and shutdown.
+		if (!e.has(bootDone) || e.has(bootShutdown))
+			return new (this) code::Binary(e.arena(), src, optimize, false);
+
+		// Transform the code on one of the workers. Other UThreads on the Compiler thread may run
+		// while we wait. Note: We can not use the 'Workers' pool here, since all threads in there
+		// may be blocked in 'updateCode', waiting for us.
+		PrepareParams params = { e.arena(), src, optimize };
+		PrepareParams *paramsPtr = &params;
+		os::Future<code::Binary *> result;
+		os::FnCall<code::Binary *, 1> call = os::fnCall().add(paramsPtr);
+		os::UThread::spawn(address(&prepareBinary), false, call, result, &CodeWorkers::thread(e)->thread());
+
+		code::Binary *b = result.result();
+		b->finish();
+		return b;
+	}
+
+	code::Listing *LazyCode::instrument(code::Listing *src) {
+		using namespace code;
+		Engine &e = engine();
+
+		Nat prolog = src->count();
+		for (Nat i = 0; i < src->count(); i++) {
+			if (src->at(i)->op() == op::prolog) {
+				prolog = i;
+				break;
+			}
+		}
+
+		if (prolog == src->count())
+			return null;
+
+		// Note: No registers are in use directly after the prolog, so we may use 'ptrA' and 'ptrC'
+		// freely. We compare the counter explicitly, since not all backends set the flags in 'sub'.
+		Listing *l = new (this) Listing(*src);
+		Label tier = l->label();
+		Label resume = l->label();
+		Operand counter = intRel(ptrA, Offset(OFFSET_OF(LazyCode, callsLeft)));
+
+		Nat pos = prolog + 1;
+		l->insert(pos++, mov(e, ptrA, objPtr(this)));
+		l->insert(pos++, mov(e, ecx, counter));
+		l->insert(pos++, sub(e, ecx, natConst(1)));
+		l->insert(pos++, mov(e, counter, ecx));
+		l->insert(pos++, cmp(e, ecx, natConst(0)));
+		l->insert(pos++, jmp(e, tier, ifEqual));
+		l->insert(pos, resume);
+
+		// Keep the call out of the common path.
+		*l << tier;
+		*l << fnParam(e.ptrDesc(), objPtr(this));
+		*l << fnCall(e.ref(builtin::lazyCodeTierUp), false);
+		*l << jmp(resume);
+
+		return l;
+	}
+
 	const void *LazyCode::updateCode(LazyCode *me) {
 		// TODO? Always allocate a new UThread? This will make sure we don't run out of stack for the compiler.
 		Thread *cThread = Compiler::thread(me->engine());
@@ -215,8 +330,21 @@ namespace storm {
 
 			try {
 				CodeGen *l = me->generate()->call();
-				// Append any data needed.
-				me->setCode(l->l);
+
+				// Start with unoptimized code that tells us when it is worth optimizing. This
+				// requires keeping the listing until then, so code that discards its source is
+				// optimized immediately instead.
+				code::Listing *counted = null;
+				if (tierUpCalls > 0 && (me->state & (sOptimize | sDiscardSource)) == 0)
+					counted = me->instrument(l->l);
+
+				if (counted) {
+					me->callsLeft = tierUpCalls;
+					me->pending = l->l;
+					me->setCode(me->compileBinary(counted, false));
+				} else {
+					me->setCode(me->compileBinary(l->l, true));
+				}
 
 				// Store the listing unless we don't need it anymore.
 				if (me->state & sDiscardSource)
@@ -234,6 +362,35 @@ namespace storm {
 		return me->binary->address();
 	}
 
+	void LazyCode::tierUp(LazyCode *me) {
+		// Note: We do not wait for the compilation to finish. The caller keeps executing the
+		// unoptimized code, and later calls use the optimized code once it is ready.
+		Thread *cThread = Compiler::thread(me->engine());
+		os::FnCall<void, 1> params = os::fnCall().add(me);
+		os::UThread::spawn(address(&LazyCode::tierUpLocal), false, params, &cThread->thread());
+	}
+
+	void LazyCode::tierUpLocal(LazyCode *me) {
+		// Already optimized, or replaced since the request was made?
+		code::Listing *src = me->pending;
+		if (!src)
+			return;
+		me->pending = null;
+
+		// Any UThreads that are currently executing the old code keep the old Binary alive until
+		// they return from it, so it is safe to replace it here.
+		try {
+			code::Binary *old = me->binary;
+			code::Binary *b = me->compileBinary(src, true);
+
+			// Replaced while we were compiling?
+			if (me->binary == old)
+				me->setCode(b);
+		} catch (const Exception *e) {
+			WARNING(L"Failed to optimize " << me->owner->identifier() << L": " << e);
+		}
+	}
+
 
 	/**
 	 * Inline code.
@@ -148,6 +148,14 @@ namespace storm {
 	};
 
 
+	/**
+	 * The thread pool used to translate lazily generated code into machine code. This is separate
+	 * from the 'Workers' pool in 'core.parallel', since the threads in that pool may be blocked
+	 * while they wait for code to be compiled.
+	 */
+	STORM_THREAD(CodeWorkers);
+
+
 	/**
 	 * Lazily generated code.
 	 */
@@ -160,6 +168,16 @@ namespace storm {
 		// Compile.
 		virtual void STORM_FN compile();
 
+		// Compile with optimizations immediately, rather than waiting for the code to be called
+		// often enough. Useful for code that is known to be used frequently.
+		void STORM_FN compileOptimized();
+
+		// Is the code compiled?
+		Bool STORM_FN compiled() const;
+
+		// Is the code compiled with optimizations?
+		Bool STORM_FN optimized() const;
+
 		// Get source.
 		virtual MAYBE(code::Listing *) STORM_FN source();
 
@@ -169,6 +187,10 @@ namespace storm {
 		// Called to update code.
 		static const void *CODECALL updateCode(LazyCode *c);
 
+		// Called by unoptimized code when it has been called often enough to be worth
+		// optimizing. Schedules recompilation on the Compiler thread and returns immediately.
+		static void CODECALL tierUp(LazyCode *c);
+
 	protected:
 		// Update reference.
 		virtual void STORM_FN newRef();
@@ -198,20 +220,43 @@ namespace storm {
 			sMask = 0x0F,
 
 			// Is the source listing to be discarded? (OR:ed with others)
-			sDiscardSource = 0x10
+			sDiscardSource = 0x10,
+
+			// Compile with optimizations directly? (OR:ed with others)
+			sOptimize = 0x20
 		};
 
 		// Current state.
 		Nat state;
 
+		// Number of calls left until the unoptimized code asks to be optimized. Decremented
+		// directly by the generated code.
+		Nat callsLeft;
+
+		// Listing to compile with optimizations once the code is called often enough. Null if no
+		// such compilation is pending, or if the source is discarded.
+		MAYBE(code::Listing *) pending;
+
 		// Called to update code from the Compiler thread.
 		static const void *CODECALL updateCodeLocal(LazyCode *c);
 
 		// Create a redirect chunk of code.
 		void createRedirect();
 
+		// Called to optimize code from the Compiler thread.
+		static void CODECALL tierUpLocal(LazyCode *c);
+
+		// Create a copy of 'src' that counts the number of calls and calls 'tierUp' when
+		// 'callsLeft' reaches zero. Returns null if 'src' can not be instrumented.
+		MAYBE(code::Listing *) instrument(code::Listing *src);
+
+		// Translate 'src' into machine code. The time consuming parts are done by 'CodeWorkers',
+		// so other UThreads may run on the Compiler thread in the meantime.
+		code::Binary *compileBinary(code::Listing *src, Bool optimize);
+
 		// Set the code in here.
-		void setCode(code::Listing *src);
+		void setCode(code::Listing *src, Bool optimize);
+		void setCode(code::Binary *to);
 	};
 
 
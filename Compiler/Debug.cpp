@@ -172,6 +172,9 @@ namespace storm {
 				} else if (t.isClass()) {
 					// Class.
 					RootObject *o = OFFSET_IN(base, offset.current(), Object *);
+					// Strings are immutable, and therefore shared by clones.
+					if (o != null && runtime::typeOf(o) == StormInfo<Str>::type(type->engine))
+						continue;
 					if (o != null && !visited->has(o)) {
 						visited->put(o);
 						if (fn)
@@ -5,7 +5,6 @@
 #include "Package.h"
 #include "Code.h"
 #include "Function.h"
-#include "Core/Hash.h"
 #include "Core/Thread.h"
 #include "Core/Str.h"
 #include "Core/Map.h"
@@ -15,10 +14,13 @@
 #include "Core/Io/Utf8Text.h"
 #include "Core/Convert.h"
 #include "Core/Variant.h"
+#include "Core/Channel.h"
+#include "Core/Transfer.h"
 #include "Lib/Enum.h"
 #include "Lib/Fn.h"
 #include "Lib/Maybe.h"
 #include "Lib/Join.h"
+#include "Lib/Array.h"
 #include "Syntax/Node.h"
 #include "Utils/Memory.h"
 #include "Utils/StackInfoSet.h"
@@ -98,9 +100,9 @@ namespace storm {
 	};
 
 
-	Engine::Engine(const Path &root, ThreadMode mode, void *stackBase) :
+	Engine::Engine(const Path &root, ThreadMode mode, void *stackBase, const GcParams &gcParams) :
 		id(atomicIncrement(engineId)),
-		gc(defaultArena, defaultFinalizer),
+		gc(defaultArena, defaultFinalizer, gcParams),
 		threadGroup(util::memberVoidFn(this, &Engine::attachThread), util::memberVoidFn(this, &Engine::detachThread)),
 		world(gc),
 		objRoot(null),
@@ -217,9 +219,16 @@ namespace storm {
 		*to << o;
 	}
 
+	// Hash based on the identity of an object.
+	static Nat identityHash(const RootObject *o) {
+		if (!o)
+			return 0;
+		return o->engine().gc.identityHash(o);
+	}
+
 	static Nat tObjHash(const void *obj) {
-		const void *ptr = *(const void **)obj;
-		return ptrHash(ptr);
+		const TObject *ptr = *(const TObject **)obj;
+		return identityHash(ptr);
 	}
 
 	static Bool tObjEqual(const void *a, const void *b) {
@@ -232,7 +241,8 @@ namespace storm {
 		if (!o.tObjHandle) {
 			o.tObjHandle = new (*this) Handle();
 			o.tObjHandle->size = sizeof(void *);
-			o.tObjHandle->locationHash = true;
+			o.tObjHandle->locationHash = !gc.stableIdentityHash();
+			o.tObjHandle->identityHash = gc.stableIdentityHash();
 			o.tObjHandle->gcArrayType = &pointerArrayType;
 			o.tObjHandle->copyFn = null; // No special function, use memcpy.
 			o.tObjHandle->deepCopyFn = null; // No need for deepCopy.
@@ -254,8 +264,8 @@ namespace storm {
 	}
 
 	static Nat objHash(const void *obj) {
-		const void *ptr = *(const void **)obj;
-		return ptrHash(ptr);
+		const Object *ptr = *(const Object **)obj;
+		return identityHash(ptr);
 	}
 
 	static Bool objEqual(const void *a, const void *b) {
@@ -268,7 +278,8 @@ namespace storm {
 		if (!o.refObjHandle) {
 			o.refObjHandle = new (*this) Handle();
 			o.refObjHandle->size = sizeof(void *);
-			o.refObjHandle->locationHash = true;
+			o.refObjHandle->locationHash = !gc.stableIdentityHash();
+			o.refObjHandle->identityHash = gc.stableIdentityHash();
 			o.refObjHandle->gcArrayType = &pointerArrayType;
 			o.refObjHandle->copyFn = null;
 			o.refObjHandle->deepCopyFn = &objDeepCopy;
@@ -398,6 +409,8 @@ namespace storm {
 			return arena()->externalSource(S("engine"), this);
 		case builtin::lazyCodeUpdate:
 			return FNREF(LazyCode::updateCode);
+		case builtin::lazyCodeTierUp:
+			return FNREF(LazyCode::tierUp);
 		case builtin::ruleThrow:
 			return FNREF(syntax::Node::throwError);
 		case builtin::alloc:
@@ -458,6 +471,16 @@ namespace storm {
 			return FNREF(createClassVariant);
 		case builtin::createJoin:
 			return FNREF(createJoin);
+		case builtin::arrayParallelMap:
+			return FNREF(arrayParallelMap);
+		case builtin::arrayParallelReduce:
+			return FNREF(ArrayBase::parallelReduceRaw);
+		case builtin::channelReceive:
+			return FNREF(ChannelBase::receiveRaw);
+		case builtin::channelTryReceive:
+			return FNREF(ChannelBase::tryReceiveRaw);
+		case builtin::transferTake:
+			return FNREF(TransferBase::takeRaw);
 		default:
 			assert(false, L"Unknown reference: " + ::toS(ref));
 			return null;
@@ -691,7 +714,7 @@ namespace storm {
 	}
 
 	void Engine::StormInfo::alloc(StackFrame *frames, nat count) const {
-		Gc::Root *r = gc.createRoot(frames, count * sizeof(StackFrame), true);
+		Gc::Root *r = gc.createRoot(frames, count * sizeof(StackFrame) / sizeof(void *), true);
 		roots.insert(std::make_pair(size_t(frames), r));
 	}
 
@@ -722,6 +745,61 @@ namespace storm {
 		e.v.gc.collect();
 	}
 
+	Bool gc(EnginePtr e, Duration time) {
+		Long ms = max(time.inMs(), Long(1));
+		return e.v.gc.collect(Nat(min(ms, Long(0xFFFFFFFF))));
+	}
+
+	void startRampAlloc(EnginePtr e) {
+		e.v.gc.startRamp();
+	}
+
+	void endRampAlloc(EnginePtr e) {
+		e.v.gc.endRamp();
+	}
+
+	Nat gcCollections(EnginePtr e) {
+		return e.v.gc.collections();
+	}
+
+	Word gcGenerationSize(EnginePtr e, Nat generation) {
+		GcParams params = e.v.gc.params();
+		if (generation >= params.generations.size())
+			return 0;
+		return params.generations[generation];
+	}
+
+	void gcGenerationSize(EnginePtr e, Nat generation, Word size) {
+		GcParams params = e.v.gc.params();
+		if (generation >= params.generations.size())
+			return;
+		params.generations[generation] = size_t(size);
+		e.v.gc.params(params);
+	}
+
+	void gcAdaptive(EnginePtr e, Bool enable) {
+		GcParams params = e.v.gc.params();
+		params.adaptive = enable;
+		e.v.gc.params(params);
+	}
+
+	void gcPauseTarget(EnginePtr e, Duration target) {
+		GcParams params = e.v.gc.params();
+		params.adaptive = true;
+		params.pauseTarget = Nat(max(min(target.inUs(), Long(0xFFFFFFFF)), Long(1)));
+		e.v.gc.params(params);
+	}
+
+	Nat gcWorkers(EnginePtr e) {
+		return e.v.gc.params().workers;
+	}
+
+	void gcWorkers(EnginePtr e, Nat count) {
+		GcParams params = e.v.gc.params();
+		params.workers = count;
+		e.v.gc.params(params);
+	}
+
 }
 
 // Get the global StackInfoSet.
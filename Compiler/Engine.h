@@ -10,6 +10,7 @@
 #include "Code/Arena.h"
 #include "Code/RefSource.h"
 #include "Code/Reference.h"
+#include "Core/Timing.h"
 #include "Utils/Lock.h"
 #include "Utils/StackInfo.h"
 
@@ -62,8 +63,9 @@ namespace storm {
 		// assumed to be found as a subdirectory of the given root path.
 		// 'stackBase' is the base of the current thread's stack. Eg. the address of argc and/or
 		// argv or some other variable allocated on the stack near 'main'.
+		// 'gcParams' are passed on to the garbage collector.
 		// TODO: Do not depend on Util/Path!
-		Engine(const Path &root, ThreadMode mode, void *stackBase);
+		Engine(const Path &root, ThreadMode mode, void *stackBase, const GcParams &gcParams = GcParams());
 
 		// Destroy. This will wait until all threads have terminated properly.
 		~Engine();
@@ -330,4 +332,40 @@ namespace storm {
 	// Force garbage collection from Storm.
 	void STORM_FN gc(EnginePtr e);
 
+	// Spend approximately `time` on an incremental garbage collection, for example when the
+	// program is idle. Returns `true` if there is more to do. Does nothing and returns `false` if
+	// the GC does not support incremental collections, or during an allocation ramp (see
+	// `startRampAlloc`).
+	Bool STORM_FN gc(EnginePtr e, Duration time);
+
+	// Tell the garbage collector that a burst of short-lived allocations is about to start, for
+	// example when handling a request. The hint may be ignored by the GC. Calls may be nested, but
+	// each call to `startRampAlloc` must be followed by a call to `endRampAlloc`.
+	void STORM_FN startRampAlloc(EnginePtr e);
+	void STORM_FN endRampAlloc(EnginePtr e);
+
+	// Get the number of collections performed by the garbage collector so far. Always zero if the
+	// GC does not keep track of this.
+	Nat STORM_FN gcCollections(EnginePtr e);
+
+	// Get/set the size of a generation in the garbage collector, in bytes. Generation 0 is the
+	// nursery. Returns zero if the generation does not exist. Not all GC implementations support
+	// changing the size of generations after startup.
+	Word STORM_FN gcGenerationSize(EnginePtr e, Nat generation);
+	void STORM_FN gcGenerationSize(EnginePtr e, Nat generation, Word size);
+
+	// Make the garbage collector adapt the size of its generations to the survival rate of
+	// objects, aiming for collections that take approximately `target`. Setting a pause target
+	// also enables adaptive sizing.
+	void STORM_FN gcAdaptive(EnginePtr e, Bool enable);
+	void STORM_FN gcPauseTarget(EnginePtr e, Duration target);
+
+	// Get/set the maximum number of threads used by each garbage collection, including the
+	// thread that performs the collection. Zero means the default, which depends on the number
+	// of CPUs. Returns zero if the GC does not support this. The threads are used for scanning
+	// stacks, updating references and compacting memory. Tracing live objects is only done by
+	// the thread that performs the collection.
+	Nat STORM_FN gcWorkers(EnginePtr e);
+	void STORM_FN gcWorkers(EnginePtr e, Nat count);
+
 }
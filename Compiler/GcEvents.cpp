@@ -0,0 +1,79 @@
+#include "stdafx.h"
+#include "GcEvents.h"
+#include "Engine.h"
+#include "Core/StrBuf.h"
+
+namespace storm {
+
+	GcEvent::GcEvent()
+		: id(0), start(0), end(0), generation(0), condemned(0), copied(0), freed(0), heapUsed(0), finalizers(0) {}
+
+	void GcEvent::toS(StrBuf *to) const {
+		*to << S("Collection ") << id << S(" of generation ") << generation
+			<< S(": ") << pause()
+			<< S(", ") << condemned << S(" bytes condemned, ")
+			<< copied << S(" copied, ")
+			<< freed << S(" freed, ")
+			<< heapUsed << S(" in use, ")
+			<< finalizers << S(" finalizers");
+	}
+
+	Array<GcEvent> *gcEvents(EnginePtr e, Word after) {
+		Array<GcEvent> *result = new (e.v) Array<GcEvent>();
+		GcTelemetry *telemetry = e.v.gc.telemetry();
+		if (!telemetry)
+			return result;
+
+		vector<GcTelemetry::Event> found = telemetry->events(size_t(after));
+		result->reserve(Nat(found.size()));
+		for (size_t i = 0; i < found.size(); i++) {
+			const GcTelemetry::Event &src = found[i];
+			GcEvent event;
+			event.id = src.id;
+			event.start = Moment(src.start);
+			event.end = Moment(src.end);
+			event.generation = src.generation;
+			event.condemned = src.condemned;
+			event.copied = src.copied;
+			event.freed = src.freed;
+			event.heapUsed = src.heapUsed;
+			event.finalizers = Nat(src.finalizers);
+			result->push(event);
+		}
+		return result;
+	}
+
+	Array<Word> *gcPauseHistogram(EnginePtr e) {
+		Array<Word> *result = new (e.v) Array<Word>();
+		GcTelemetry *telemetry = e.v.gc.telemetry();
+		if (!telemetry)
+			return result;
+
+		for (nat i = 0; i < GcPauseHistogram::buckets; i++)
+			result->push(telemetry->pauses.count(i));
+		return result;
+	}
+
+	Duration gcPausePercentile(EnginePtr e, Float percentile) {
+		GcTelemetry *telemetry = e.v.gc.telemetry();
+		if (!telemetry)
+			return Duration();
+
+		return Duration(telemetry->pauses.percentile(percentile));
+	}
+
+	Bool gcLog(EnginePtr e, Url *file) {
+		GcTelemetry *telemetry = e.v.gc.telemetry();
+		if (!telemetry)
+			return false;
+
+		return telemetry->log(file->format()->c_str());
+	}
+
+	void gcStopLog(EnginePtr e) {
+		GcTelemetry *telemetry = e.v.gc.telemetry();
+		if (telemetry)
+			telemetry->log(null);
+	}
+
+}
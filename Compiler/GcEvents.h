@@ -0,0 +1,73 @@
+#pragma once
+#include "Core/Timing.h"
+#include "Core/Array.h"
+#include "Core/EnginePtr.h"
+#include "Core/Io/Url.h"
+
+namespace storm {
+	STORM_PKG(core);
+
+	/**
+	 * Information about a single garbage collection, as reported by `gcEvents`.
+	 *
+	 * Timestamps use the same clock as `Moment`, so that collections can be correlated with
+	 * other measurements in the program.
+	 */
+	class GcEvent {
+		STORM_VALUE;
+	public:
+		// Create an empty event.
+		STORM_CTOR GcEvent();
+
+		// Sequence number of the event. Events are numbered from 1.
+		Word id;
+
+		// Start and end of the collection.
+		Moment start;
+		Moment end;
+
+		// The collected generation. Zero is the nursery.
+		Nat generation;
+
+		// Number of bytes in the collected generation when the collection started.
+		Word condemned;
+
+		// Number of bytes moved to the next generation.
+		Word copied;
+
+		// Number of bytes freed.
+		Word freed;
+
+		// Number of bytes in use in the heap after the collection.
+		Word heapUsed;
+
+		// Number of finalizers scheduled as a result of the collection.
+		Nat finalizers;
+
+		// Duration of the collection, i.e. how long the program was paused.
+		Duration STORM_FN pause() const { return end - start; }
+
+		// Output.
+		void STORM_FN toS(StrBuf *to) const;
+	};
+
+	// Get all recent collections with an `id` larger than `after`. Only the most recent
+	// collections are kept, so callers should poll regularly to not miss any events. Returns an
+	// empty array if the GC does not provide telemetry.
+	Array<GcEvent> *STORM_FN gcEvents(EnginePtr e, Word after);
+
+	// Get a histogram of the duration of all collections so far. Element `i` contains the number of
+	// collections shorter than 2^i microseconds that are not counted in element `i-1`.
+	Array<Word> *STORM_FN gcPauseHistogram(EnginePtr e);
+
+	// Get an approximation of a percentile (0-100) of the duration of all collections so far.
+	Duration STORM_FN gcPausePercentile(EnginePtr e, Float percentile);
+
+	// Write all collections to `file`, one JSON object per line. Returns `false` if the file could
+	// not be opened, or if the GC does not provide telemetry.
+	Bool STORM_FN gcLog(EnginePtr e, Url *file);
+
+	// Stop writing collections to a file.
+	void STORM_FN gcStopLog(EnginePtr e);
+
+}
@@ -99,6 +99,19 @@ namespace storm {
 		return copy;
 	}
 
+	static void *CODECALL parallelReduceClass(ArrayBase *src, FnBase *fn) {
+		void *result = null;
+		src->parallelReduceRaw(fn, &result);
+		return result;
+	}
+
+	ArrayBase *arrayParallelMap(Type *type, ArrayBase *src, FnBase *fn) {
+		ArrayBase *out = (ArrayBase *)runtime::allocObject(sizeof(ArrayBase), type);
+		createArrayRaw(out);
+		src->parallelMapRaw(out, fn);
+		return out;
+	}
+
 	ArrayType::ArrayType(Str *name, Type *contents) : Type(name, typeClass), contents(contents), watchFor(0) {
 		if (engine.has(bootTemplates))
 			lateInit();
@@ -170,6 +183,7 @@ namespace storm {
 
 			add(nativeFunction(e, Value(), S("sort"), valList(e, 2, t, predicate), address(&ArrayBase::sortRawPred)));
 			add(nativeFunction(e, t, S("sorted"), valList(e, 2, t, predicate), address(&sortedRawPred))->makePure());
+			add(nativeFunction(e, Value(), S("parallelSort"), valList(e, 2, t, predicate), address(&ArrayBase::parallelSortRawPred)));
 
 			add(nativeFunction(e, Value(), S("removeDuplicates"), valList(e, 2, t, predicate), address(&ArrayBase::removeDuplicatesRawPred)));
 			add(nativeFunction(e, t, S("withoutDuplicates"), valList(e, 2, t, predicate), address(&ArrayBase::withoutDuplicatesRawPred))->makePure());
@@ -178,6 +192,10 @@ namespace storm {
 			add(new (e) TemplateFn(new (e) Str(S("upperBound")), fnPtr(e, &ArrayType::createUpperBound, this)));
 		}
 
+		// Parallel algorithms.
+		add(new (e) TemplateFn(new (e) Str(S("parallelMap")), fnPtr(e, &ArrayType::createParallelMap, this)));
+		addParallelReduce();
+
 		if (!param().type->isA(StormInfo<TObject>::type(engine))) {
 			if (SerializeInfo *info = serializeInfo(param().type)) {
 				addSerialization(info);
@@ -265,6 +283,7 @@ namespace storm {
 		// Sort using <.
 		add(nativeFunction(e, Value(), S("sort"), params, address(&ArrayBase::sortRaw)));
 		add(nativeFunction(e, Value(this), S("sorted"), params, address(&sortedRaw))->makePure());
+		add(nativeFunction(e, Value(), S("parallelSort"), params, address(&ArrayBase::parallelSortRaw)));
 
 		// < for comparing.
 		Value b(StormInfo<Bool>::type(e));
@@ -363,6 +382,85 @@ namespace storm {
 		return created;
 	}
 
+	MAYBE(Named *) ArrayType::createParallelMap(Str *name, SimplePart *part) {
+		if (part->params->count() != 2)
+			return null;
+
+		FnType *fn = as<FnType>(part->params->at(1).type);
+		if (!fn)
+			return null;
+
+		Value result = fn->result();
+		if (result == Value())
+			return null;
+
+		// Re-use existing entities if possible, as for 'lowerBound'.
+		NameOverloads *candidates = allOverloads(new (this) Str(S("parallelMap")));
+		for (Nat i = 0; i < candidates->count(); i++) {
+			Named *candidate = candidates->at(i);
+			if (candidate->params->count() == 2)
+				if (candidate->params->at(1).type == fn)
+					return candidate;
+		}
+
+		// Otherwise, create a new entity.
+		Value arrayType = wrapArray(result);
+
+		using namespace code;
+		TypeDesc *ptr = engine.ptrDesc();
+		Listing *l = new (this) Listing(true, ptr);
+		Var me = l->createParam(ptr);
+		Var fnVar = l->createParam(ptr);
+
+		*l << prolog();
+		*l << fnParam(ptr, objPtr(arrayType.type));
+		*l << fnParam(ptr, me);
+		*l << fnParam(ptr, fnVar);
+		*l << fnCall(engine.ref(builtin::arrayParallelMap), false, ptr, ptrA);
+		*l << fnRet(ptrA);
+
+		Array<Value> *params = valList(engine, 2, thisPtr(this), Value(fn));
+		Function *created = dynamicFunction(engine, arrayType, S("parallelMap"), params, l);
+		created->flags |= namedMatchNoInheritance;
+		return created;
+	}
+
+	void ArrayType::addParallelReduce() {
+		Engine &e = engine;
+		Value t = thisPtr(this);
+
+		Array<Value> *fnParams = new (e) Array<Value>(3, param());
+		Value fn = Value(fnType(fnParams));
+
+		if (param().isObject())
+			add(nativeFunction(e, param(), S("parallelReduce"), valList(e, 2, t, fn), address(&parallelReduceClass)));
+		else
+			add(dynamicFunction(e, param(), S("parallelReduce"), valList(e, 2, t, fn), parallelReduceValue()));
+	}
+
+	code::Listing *ArrayType::parallelReduceValue() {
+		using namespace code;
+		Value param = this->param();
+
+		Listing *l = new (this) Listing(true, param.desc(engine));
+
+		TypeDesc *ptr = engine.ptrDesc();
+		Var me = l->createParam(ptr);
+		Var fn = l->createParam(ptr);
+		Var data = l->createVar(l->root(), param.size());
+
+		*l << prolog();
+
+		*l << lea(ptrA, data);
+		*l << fnParam(ptr, me);
+		*l << fnParam(ptr, fn);
+		*l << fnParam(ptr, ptrA);
+		*l << fnCall(engine.ref(builtin::arrayParallelReduce), false);
+		*l << fnRet(data);
+
+		return l;
+	}
+
 	void ArrayType::addSerialization(SerializeInfo *info) {
 		Function *ctor = readCtor(info);
 		add(ctor);
@@ -14,6 +14,10 @@ namespace storm {
 	// Create types for unknown implementations.
 	Type *createArray(Str *name, ValueArray *params);
 
+	// Create an array of type 'type' containing the result of applying 'fn' to each element in
+	// 'src' in parallel. Used by 'parallelMap'.
+	ArrayBase *CODECALL arrayParallelMap(Type *type, ArrayBase *src, FnBase *fn);
+
 	/**
 	 * Type for arrays.
 	 */
@@ -64,6 +68,15 @@ namespace storm {
 		MAYBE(Named *) CODECALL createUpperBound(Str *name, SimplePart *part);
 		MAYBE(Named *) CODECALL createLowerBound(Str *name, SimplePart *part);
 
+		// Create 'parallelMap' from a template, for each result type.
+		MAYBE(Named *) CODECALL createParallelMap(Str *name, SimplePart *part);
+
+		// Add 'parallelReduce'.
+		void addParallelReduce();
+
+		// Generate 'parallelReduce' for value types.
+		code::Listing *parallelReduceValue();
+
 		// Add serialization functions.
 		void addSerialization(SerializeInfo *info);
 
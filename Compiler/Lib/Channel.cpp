@@ -0,0 +1,154 @@
+#include "stdafx.h"
+#include "Channel.h"
+#include "Array.h"
+#include "Maybe.h"
+#include "Engine.h"
+#include "Exception.h"
+#include "Core/Channel.h"
+
+namespace storm {
+
+	Type *createChannel(Str *name, ValueArray *params) {
+		if (params->count() != 1)
+			return null;
+
+		Value param = params->at(0);
+		if (param.ref)
+			return null;
+
+		return new (params) ChannelType(name, param.type);
+	}
+
+	Bool isChannel(Value v) {
+		return as<ChannelType>(v.type) != null;
+	}
+
+	Value unwrapChannel(Value v) {
+		if (ChannelType *t = as<ChannelType>(v.type))
+			return t->param();
+		else
+			return v;
+	}
+
+	ChannelType::ChannelType(Str *name, Type *contents) : Type(name, typeClass), contents(contents) {
+		if (engine.has(bootTemplates))
+			lateInit();
+
+		setSuper(ChannelBase::stormType(engine));
+	}
+
+	void ChannelType::lateInit() {
+		if (!params)
+			params = new (engine) Array<Value>();
+		if (params->count() < 1)
+			params->push(Value(contents));
+
+		Type::lateInit();
+	}
+
+	Value ChannelType::param() const {
+		return Value(contents);
+	}
+
+	static void CODECALL createChannelRaw(void *mem, Nat capacity) {
+		ChannelType *t = (ChannelType *)runtime::typeOf((RootObject *)mem);
+		ChannelBase *o = new (Place(mem)) ChannelBase(t->param().type->handle(), capacity);
+		runtime::setVTable(o);
+	}
+
+	static void CODECALL copyChannel(void *mem, ChannelBase *from) {
+		ChannelBase *o = new (Place(mem)) ChannelBase(*from);
+		runtime::setVTable(o);
+	}
+
+	static void CODECALL sendClass(ChannelBase *c, Object *elem) {
+		c->sendRaw(&elem);
+	}
+
+	static Bool CODECALL trySendClass(ChannelBase *c, Object *elem) {
+		return c->trySendRaw(&elem);
+	}
+
+	static Object *CODECALL receiveClass(ChannelBase *c) {
+		Object *result = null;
+		c->receiveRaw(&result);
+		return result;
+	}
+
+	static Object *CODECALL tryReceiveClass(ChannelBase *c) {
+		Object *result = null;
+		c->tryReceiveRaw(&result);
+		return result;
+	}
+
+	Bool ChannelType::loadAll() {
+		Engine &e = engine;
+		Value t = thisPtr(this);
+		Value vNat(StormInfo<Nat>::type(e));
+
+		add(nativeFunction(e, Value(), Type::CTOR, valList(e, 2, t, vNat), address(&createChannelRaw))->makePure());
+		add(nativeFunction(e, Value(), Type::CTOR, valList(e, 2, t, t), address(&copyChannel))->makePure());
+		add(nativeFunction(e, vNat, S("drain"), valList(e, 3, t, wrapArray(param()), vNat), address(&ChannelBase::drainRaw)));
+
+		if (param().isObject())
+			loadClass();
+		else
+			loadValue();
+
+		return Type::loadAll();
+	}
+
+	void ChannelType::loadClass() {
+		Engine &e = engine;
+		Value t = thisPtr(this);
+		Value vBool(StormInfo<Bool>::type(e));
+		Value maybe = wrapMaybe(param());
+
+		add(nativeFunction(e, Value(), S("send"), valList(e, 2, t, param()), address(&sendClass)));
+		add(nativeFunction(e, vBool, S("trySend"), valList(e, 2, t, param()), address(&trySendClass)));
+		add(nativeFunction(e, maybe, S("receive"), valList(e, 1, t), address(&receiveClass)));
+		add(nativeFunction(e, maybe, S("tryReceive"), valList(e, 1, t), address(&tryReceiveClass)));
+	}
+
+	void ChannelType::loadValue() {
+		Engine &e = engine;
+		Value t = thisPtr(this);
+		Value vBool(StormInfo<Bool>::type(e));
+		Value ref = param().asRef();
+		Value maybe = wrapMaybe(param());
+
+		add(nativeFunction(e, Value(), S("send"), valList(e, 2, t, ref), address(&ChannelBase::sendRaw)));
+		add(nativeFunction(e, vBool, S("trySend"), valList(e, 2, t, ref), address(&ChannelBase::trySendRaw)));
+		add(dynamicFunction(e, maybe, S("receive"), valList(e, 1, t), receiveValue(true)));
+		add(dynamicFunction(e, maybe, S("tryReceive"), valList(e, 1, t), receiveValue(false)));
+	}
+
+	code::Listing *ChannelType::receiveValue(bool wait) {
+		using namespace code;
+		Value maybe = wrapMaybe(param());
+		MaybeValueType *maybeType = as<MaybeValueType>(maybe.type);
+		if (!maybeType)
+			throw new (this) InternalError(S("Expected Maybe<T> to be a value."));
+
+		Listing *l = new (this) Listing(true, maybe.desc(engine));
+
+		TypeDesc *ptr = engine.ptrDesc();
+		Var me = l->createParam(ptr);
+		Var result = l->createVar(l->root(), maybe.desc(engine), freeOnBoth | freeInactive);
+
+		*l << prolog();
+
+		// The value is copied into the first part of 'result', and the flag at the end is set to
+		// the return value. If nothing was received, 'result' is left empty.
+		*l << lea(ptrA, result);
+		*l << fnParam(ptr, me);
+		*l << fnParam(ptr, ptrA);
+		*l << fnCall(engine.ref(wait ? builtin::channelReceive : builtin::channelTryReceive), true, byteDesc(engine), al);
+		*l << mov(byteRel(result, maybeType->boolOffset()), al);
+		*l << activate(result);
+		*l << fnRet(result);
+
+		return l;
+	}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ValueArray.h"
+#include "Type.h"
+#include "Code/Listing.h"
+
+namespace storm {
+	STORM_PKG(core.lang);
+
+	// Create types for unknown implementations.
+	Type *createChannel(Str *name, ValueArray *params);
+
+	/**
+	 * Type for channels.
+	 */
+	class ChannelType : public Type {
+		STORM_CLASS;
+	public:
+		// Create.
+		STORM_CTOR ChannelType(Str *name, Type *contents);
+
+		// Late init.
+		virtual void lateInit();
+
+		// Parameter.
+		Value STORM_FN param() const;
+
+	protected:
+		// Lazy loading.
+		virtual Bool STORM_FN loadAll();
+
+	private:
+		// Content type.
+		Type *contents;
+
+		// Load different varieties.
+		void loadClass();
+		void loadValue();
+
+		// Generate code for receiving values. Either waits for a value or returns immediately.
+		code::Listing *receiveValue(bool wait);
+	};
+
+	Bool STORM_FN isChannel(Value v);
+	Value STORM_FN unwrapChannel(Value v);
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "Compiler/Template.h"
+#include "Core/Map.h"
 
 namespace storm {
 	STORM_PKG(core.lang);
@@ -0,0 +1,79 @@
+#include "stdafx.h"
+#include "ThreadDump.h"
+#include "Io.h"
+#include "Core/Thread.h"
+#include "Core/StrBuf.h"
+#include "Core/Array.h"
+#include "Compiler/Engine.h"
+#include "Compiler/Package.h"
+#include "Compiler/NamedThread.h"
+#include "OS/Thread.h"
+
+namespace storm {
+
+	static void findNames(Named *current, const vector<os::Thread> &threads, Array<Str *> *names) {
+		if (NamedThread *t = as<NamedThread>(current)) {
+			for (Nat i = 0; i < names->count(); i++) {
+				if (t->thread()->sameAs(threads[i]))
+					names->at(i) = t->identifier();
+			}
+			return;
+		}
+
+		if (NameSet *search = as<NameSet>(current)) {
+			for (NameSet::Iter i = search->begin(), e = search->end(); i != e; ++i)
+				findNames(i.v(), threads, names);
+		}
+	}
+
+	// Find the names of all threads. Threads without a name are named after their ID.
+	static Array<Str *> *threadNames(Engine &e, const vector<os::Thread> &threads) {
+		Array<Str *> *names = new (e) Array<Str *>(Nat(threads.size()), null);
+		findNames(e.package(), threads, names);
+
+		for (Nat i = 0; i < names->count(); i++) {
+			if (!names->at(i)) {
+				StrBuf *b = new (e) StrBuf();
+				*b << S("Thread ") << hex((void *)threads[i].id());
+				names->at(i) = b->toS();
+			}
+		}
+
+		return names;
+	}
+
+	Str *threadStats(EnginePtr e) {
+		vector<os::Thread> threads = e.v.allThreads();
+		Array<Str *> *names = threadNames(e.v, threads);
+
+		StrBuf *out = new (e.v) StrBuf();
+		for (size_t i = 0; i < threads.size(); i++)
+			*out << names->at(Nat(i)) << S(": ") << ThreadStats(threads[i].stats()) << S("\n");
+		return out->toS();
+	}
+
+	void dumpThreadStats(EnginePtr e, Duration interval, Nat times) {
+		// Statistics from the previous report, so that we can compute the difference.
+		map<uintptr_t, os::ThreadStats> prev;
+
+		for (Nat t = 0; t < times; t++) {
+			sleep(interval);
+
+			vector<os::Thread> threads = e.v.allThreads();
+			Array<Str *> *names = threadNames(e.v, threads);
+
+			StrBuf *out = new (e.v) StrBuf();
+			*out << S("Thread statistics for the last ") << interval << S(":");
+			for (size_t i = 0; i < threads.size(); i++) {
+				os::ThreadStats now = threads[i].stats();
+				ThreadStats delta = ThreadStats(now) - ThreadStats(prev[threads[i].id()]);
+				prev[threads[i].id()] = now;
+
+				*out << S("\n  ") << names->at(Nat(i)) << S(": ") << delta;
+			}
+
+			io::print(out->toS());
+		}
+	}
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "Core/Str.h"
+#include "Core/EnginePtr.h"
+#include "Core/Timing.h"
+
+namespace storm {
+	STORM_PKG(core);
+
+	// Format statistics about the scheduling and I/O activity of all threads in the system. One
+	// line is produced for each thread.
+	Str *STORM_FN threadStats(EnginePtr e) ON(Compiler);
+
+	// Print statistics for all threads in the system to standard output every 'interval', 'times'
+	// times. Each report contains the activity since the previous report. Returns when all reports
+	// have been printed, so it is usually a good idea to spawn this function.
+	void STORM_FN dumpThreadStats(EnginePtr e, Duration interval, Nat times) ON(Compiler);
+
+}
@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "Transfer.h"
+#include "Engine.h"
+#include "Core/Transfer.h"
+
+namespace storm {
+
+	Type *createTransfer(Str *name, ValueArray *params) {
+		if (params->count() != 1)
+			return null;
+
+		// Actors are never copied, so there is no need to transfer them.
+		Value param = params->at(0);
+		if (param.ref || !param.type || param.isActor())
+			return null;
+
+		return new (params) TransferType(name, param.type);
+	}
+
+	Bool isTransfer(Value v) {
+		return as<TransferType>(v.type) != null;
+	}
+
+	Value unwrapTransfer(Value v) {
+		if (TransferType *t = as<TransferType>(v.type))
+			return t->param();
+		else
+			return v;
+	}
+
+	TransferType::TransferType(Str *name, Type *contents) : Type(name, typeClass), contents(contents) {
+		if (engine.has(bootTemplates))
+			lateInit();
+
+		setSuper(TransferBase::stormType(engine));
+	}
+
+	void TransferType::lateInit() {
+		if (!params)
+			params = new (engine) Array<Value>();
+		if (params->count() < 1)
+			params->push(Value(contents));
+
+		Type::lateInit();
+	}
+
+	Value TransferType::param() const {
+		return Value(contents);
+	}
+
+	static void CODECALL createTransferRaw(void *mem) {
+		TransferType *t = (TransferType *)runtime::typeOf((RootObject *)mem);
+		TransferBase *o = new (Place(mem)) TransferBase(t->param().type->handle());
+		runtime::setVTable(o);
+	}
+
+	static void CODECALL createTransferClass(void *mem, Object *value) {
+		createTransferRaw(mem);
+		((TransferBase *)mem)->putRaw(&value);
+	}
+
+	static void CODECALL createTransferValue(void *mem, const void *value) {
+		createTransferRaw(mem);
+		((TransferBase *)mem)->putRaw(value);
+	}
+
+	static void CODECALL copyTransfer(void *mem, TransferBase *from) {
+		TransferBase *o = new (Place(mem)) TransferBase(*from);
+		runtime::setVTable(o);
+	}
+
+	static void CODECALL putClass(TransferBase *t, Object *value) {
+		t->putRaw(&value);
+	}
+
+	static Object *CODECALL takeClass(TransferBase *t) {
+		Object *result = null;
+		t->takeRaw(&result);
+		return result;
+	}
+
+	Bool TransferType::loadAll() {
+		Engine &e = engine;
+		Value t = thisPtr(this);
+
+		add(nativeFunction(e, Value(), Type::CTOR, valList(e, 1, t), address(&createTransferRaw))->makePure());
+		add(nativeFunction(e, Value(), Type::CTOR, valList(e, 2, t, t), address(&copyTransfer))->makePure());
+
+		if (param().isObject())
+			loadClass();
+		else
+			loadValue();
+
+		return Type::loadAll();
+	}
+
+	void TransferType::loadClass() {
+		Engine &e = engine;
+		Value t = thisPtr(this);
+
+		add(nativeFunction(e, Value(), Type::CTOR, valList(e, 2, t, param()), address(&createTransferClass)));
+		add(nativeFunction(e, param(), S("take"), valList(e, 1, t), address(&takeClass)));
+		add(nativeFunction(e, Value(), S("put"), valList(e, 2, t, param()), address(&putClass)));
+	}
+
+	void TransferType::loadValue() {
+		Engine &e = engine;
+		Value t = thisPtr(this);
+		Value ref = param().asRef();
+
+		add(nativeFunction(e, Value(), Type::CTOR, valList(e, 2, t, ref), address(&createTransferValue)));
+		add(dynamicFunction(e, param(), S("take"), valList(e, 1, t), takeValue()));
+		add(nativeFunction(e, Value(), S("put"), valList(e, 2, t, ref), address(&TransferBase::putRaw)));
+	}
+
+	code::Listing *TransferType::takeValue() {
+		using namespace code;
+		Listing *l = new (this) Listing(true, param().desc(engine));
+
+		TypeDesc *ptr = engine.ptrDesc();
+		Var me = l->createParam(ptr);
+		Var result = l->createVar(l->root(), param().desc(engine), freeOnBoth | freeInactive);
+
+		*l << prolog();
+
+		// 'takeRaw' copies the value into 'result', or throws.
+		*l << lea(ptrA, result);
+		*l << fnParam(ptr, me);
+		*l << fnParam(ptr, ptrA);
+		*l << fnCall(engine.ref(builtin::transferTake), true);
+		*l << activate(result);
+		*l << fnRet(result);
+
+		return l;
+	}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ValueArray.h"
+#include "Type.h"
+#include "Code/Listing.h"
+
+namespace storm {
+	STORM_PKG(core.lang);
+
+	// Create types for unknown implementations.
+	Type *createTransfer(Str *name, ValueArray *params);
+
+	/**
+	 * Type for Transfer<T>.
+	 */
+	class TransferType : public Type {
+		STORM_CLASS;
+	public:
+		// Create.
+		STORM_CTOR TransferType(Str *name, Type *contents);
+
+		// Late init.
+		virtual void lateInit();
+
+		// Parameter.
+		Value STORM_FN param() const;
+
+	protected:
+		// Lazy loading.
+		virtual Bool STORM_FN loadAll();
+
+	private:
+		// Content type.
+		Type *contents;
+
+		// Load different varieties.
+		void loadClass();
+		void loadValue();
+
+		// Generate code for taking a value.
+		code::Listing *takeValue();
+	};
+
+	Bool STORM_FN isTransfer(Value v);
+	Value STORM_FN unwrapTransfer(Value v);
+
+}
@@ -7,6 +7,8 @@
 #include "Engine.h"
 #include "Reader.h"
 #include "Exception.h"
+#include "Function.h"
+#include "Code.h"
 
 namespace storm {
 
@@ -160,6 +162,78 @@ namespace storm {
 		discardOnLoad = false;
 	}
 
+	// Number of functions compiled at the same time by 'compileParallel'. Limits the number of
+	// UThreads that are alive at the same time.
+	static const Nat warmUpBatch = 64;
+
+	static void warmUpCompile(Named *named, Bool optimize) {
+		if (optimize) {
+			if (Function *fn = as<Function>(named)) {
+				if (LazyCode *code = as<LazyCode>(fn->getCode())) {
+					code->compileOptimized();
+					return;
+				}
+			}
+		}
+
+		named->compile();
+	}
+
+	void Package::warmUp() {
+		compileParallel(warmUpNames(), null);
+	}
+
+	Array<Named *> *Package::warmUpNames() {
+		Array<Named *> *result = new (this) Array<Named *>();
+		warmUpCollect(result, this);
+		return result;
+	}
+
+	void Package::warmUpCollect(Array<Named *> *to, NameSet *in) {
+		in->forceLoad();
+		for (NameSet::Iter i = in->begin(), end = in->end(); i != end; ++i) {
+			Named *named = i.v();
+			if (as<Package>(named))
+				continue;
+
+			if (NameSet *set = as<NameSet>(named))
+				warmUpCollect(to, set);
+			else
+				to->push(named);
+		}
+	}
+
+	void compileParallel(Array<Named *> *names, Array<Bool> *optimize) {
+		// Each function is compiled in a UThread of its own. When one UThread waits for the
+		// workers, the next one generates code in the meantime.
+		const os::Thread &on = Compiler::thread(names->engine())->thread();
+		for (Nat from = 0; from < names->count(); from += warmUpBatch) {
+			Nat count = min(warmUpBatch, names->count() - from);
+
+			os::Future<void> results[warmUpBatch];
+			for (Nat i = 0; i < count; i++) {
+				Named *named = names->at(from + i);
+				Bool opt = optimize ? optimize->at(from + i) : false;
+				os::FnCall<void, 2> call = os::fnCall().add(named).add(opt);
+				os::UThread::spawn(address(&warmUpCompile), false, call, results[i], &on);
+			}
+
+			// Wait for all of them before throwing any errors.
+			Nat firstError = count;
+			for (Nat i = 0; i < count; i++) {
+				try {
+					results[i].result();
+				} catch (...) {
+					if (firstError == count)
+						firstError = i;
+				}
+			}
+
+			if (firstError < count)
+				results[firstError].result();
+		}
+	}
+
 	void Package::discardSource() {
 		// We don't need to propagate this message, we emit it ourselves.
 	}
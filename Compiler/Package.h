@@ -54,6 +54,16 @@ namespace storm {
 		// Inhibit discard messages from propagating.
 		void STORM_FN noDiscard();
 
+		// Compile all functions in this package, including members of types, so that they do not
+		// need to be compiled when they are first called. Code for the functions is generated on
+		// the Compiler thread, while previously generated code is translated into machine code by
+		// the worker threads in parallel. Sub-packages are not compiled. Returns when all
+		// functions are compiled. If any function fails to compile, the error is thrown from here.
+		void STORM_FN warmUp();
+
+		// Get all named entities that are compiled by 'warmUp'.
+		Array<Named *> *STORM_FN warmUpNames();
+
 		// We don't need to propagate the discard source message in general.
 		virtual void STORM_FN discardSource();
 
@@ -89,6 +99,9 @@ namespace storm {
 		// Load exports if necessary.
 		void loadExports();
 
+		// Find all named entities to compile in 'warmUp'.
+		static void warmUpCollect(Array<Named *> *to, NameSet *in);
+
 		// Type for keeping track of recursive package lookups. Pre-allocated enough so that we
 		// won't have to heap allocate too often. Typically, this should not be very large. If it
 		// would be, then we would need a set instead for performance.
@@ -116,6 +129,11 @@ namespace storm {
 	};
 
 
+	// Compile all entities in 'names' in parallel, in the same way as 'Package.warmUp'. If
+	// 'optimize' is given, it contains one element for each element in 'names' that indicates if
+	// the corresponding function shall be compiled with optimizations directly.
+	void compileParallel(Array<Named *> *names, MAYBE(Array<Bool> *) optimize);
+
 	// Find a package from a path.
 	MAYBE(Package *) STORM_FN package(Url *path);
 
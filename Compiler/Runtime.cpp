@@ -156,6 +156,22 @@ namespace storm {
 			return e.gc.createWatch();
 		}
 
+		bool stableIdentityHash(Engine &e) {
+			return e.gc.stableIdentityHash();
+		}
+
+		Nat identityHash(Engine &e, const void *obj) {
+			return e.gc.identityHash(obj);
+		}
+
+		Nat storeIdentityHash(Engine &e, const void *obj) {
+			return e.gc.storeIdentityHash(obj);
+		}
+
+		void releaseIdentityHash(Engine &e, const void *obj) {
+			e.gc.releaseIdentityHash(obj);
+		}
+
 		void *allocCode(Engine &e, size_t code, size_t refs) {
 			return e.gc.allocCode(code, refs);
 		}
@@ -224,11 +240,15 @@ namespace storm {
 				return t;
 
 			Object *src = (Object *)obj;
+			Type *t = typeOf(src);
+
+			// Strings are immutable, so they can be shared.
+			if (t == StormInfo<Str>::type(t->engine))
+				return src;
 
 			if (Object *prev = env->cloned(src))
 				return prev;
 
-			Type *t = typeOf(src);
 			const GcType *gcType = t->gcType();
 			void *mem = t->engine.gc.alloc(gcType);
 
@@ -240,10 +260,11 @@ namespace storm {
 				memcpy(mem, src, gcType->stride);
 			}
 
+			// Remember the clone before copying the members, so that cycles refer to the clone.
 			Object *result = (Object *)mem;
+			env->cloned(src, result);
 			result->deepCopy(env);
 
-			env->cloned(src, result);
 			return result;
 		}
 
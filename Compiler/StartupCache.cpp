@@ -0,0 +1,213 @@
+#include "stdafx.h"
+#include "StartupCache.h"
+#include "Function.h"
+#include "Code.h"
+#include "Core/Str.h"
+#include "Core/StrBuf.h"
+#include "Core/Io/Text.h"
+#include "Core/Io/Utf8Text.h"
+#include "Core/Io/Buffer.h"
+#include "Core/Io/Protocol.h"
+#include "Utils/Path.h"
+
+namespace storm {
+
+	StartupEntry::StartupEntry(Str *key) : key(key) {
+		fns = new (this) Map<Str *, Bool>();
+	}
+
+
+	// First line of the file. Update the number whenever the format changes.
+	static const wchar *cacheHeader = S("storm startup cache 1");
+
+	// FNV-1a hashing.
+	static const Word fnvBasis = 14695981039346656037ULL;
+	static const Word fnvPrime = 1099511628211ULL;
+
+	static Word hashStr(Word h, Str *str) {
+		for (const wchar *at = str->c_str(); *at; at++) {
+			h ^= Word(*at);
+			h *= fnvPrime;
+		}
+		return h;
+	}
+
+	static Word hashWord(Word h, Word v) {
+		for (Nat i = 0; i < sizeof(Word); i++) {
+			h ^= (v >> (i * 8)) & 0xFF;
+			h *= fnvPrime;
+		}
+		return h;
+	}
+
+	static Word hashFile(Word h, Url *file) {
+		IStream *src = file->read();
+		Buffer b = buffer(file->engine(), 64*1024);
+		while (true) {
+			b.filled(0);
+			b = src->read(b);
+			if (b.empty())
+				break;
+
+			for (Nat i = 0; i < b.filled(); i++) {
+				h ^= Word(b[i]);
+				h *= fnvPrime;
+			}
+		}
+		src->close();
+		return h;
+	}
+
+	// Hash the name, size and modification time of 'file'. Reading all files in a package would
+	// add noticeable I/O to each start. Files that are not on disk are hashed by their contents.
+	static Word hashFileInfo(Word h, Url *file) {
+		h = hashStr(h, file->name());
+		if (!as<FileProtocol>(file->protocol()))
+			return hashFile(h, file);
+
+		RIStream *src = file->read()->randomAccess();
+		h = hashWord(h, src->length());
+		src->close();
+		return hashWord(h, Path(String(file->format()->c_str())).mTime().time);
+	}
+
+	// The executable is too large to hash on every start. Its size and modification time change
+	// whenever it is rebuilt or replaced.
+	static Word hashExecutable(Engine &e) {
+		RIStream *src = executableFileUrl(e)->read()->randomAccess();
+		Word h = hashWord(fnvBasis, src->length());
+		src->close();
+		return hashWord(h, Path::executableFile().mTime().time);
+	}
+
+	StartupCache::StartupCache(Url *file) : file(file), compilerHash(0) {
+		entries = new (this) Map<Str *, StartupEntry *>();
+		load();
+	}
+
+	Nat StartupCache::warmUp(Package *pkg) {
+		StartupEntry *entry = entries->get(pkg->identifier(), null);
+		if (!entry)
+			return 0;
+
+		Str *key = packageKey(pkg);
+		if (!key || *key != *entry->key)
+			return 0;
+
+		Array<Named *> *all = pkg->warmUpNames();
+		Array<Named *> *todo = new (this) Array<Named *>();
+		Array<Bool> *optimize = new (this) Array<Bool>();
+		for (Nat i = 0; i < all->count(); i++) {
+			Named *named = all->at(i);
+			Str *id = named->identifier();
+			if (entry->fns->has(id)) {
+				todo->push(named);
+				optimize->push(entry->fns->get(id));
+			}
+		}
+
+		compileParallel(todo, optimize);
+		return todo->count();
+	}
+
+	void StartupCache::record(Package *pkg) {
+		Str *key = packageKey(pkg);
+		if (!key)
+			return;
+
+		StartupEntry *entry = new (this) StartupEntry(key);
+		Array<Named *> *all = pkg->warmUpNames();
+		for (Nat i = 0; i < all->count(); i++) {
+			Function *fn = as<Function>(all->at(i));
+			if (!fn)
+				continue;
+
+			LazyCode *code = as<LazyCode>(fn->getCode());
+			if (code && code->compiled())
+				entry->fns->put(fn->identifier(), code->optimized());
+		}
+
+		entries->put(pkg->identifier(), entry);
+	}
+
+	void StartupCache::save() {
+		TextOutput *out = new (this) Utf8Output(file->write());
+		out->writeLine(new (this) Str(cacheHeader));
+
+		for (Map<Str *, StartupEntry *>::Iter i = entries->begin(), end = entries->end(); i != end; ++i) {
+			StartupEntry *entry = i.v();
+			out->writeLine(TO_S(this, S("package ") << entry->key << S(" ") << i.k()));
+
+			for (Map<Str *, Bool>::Iter j = entry->fns->begin(), fend = entry->fns->end(); j != fend; ++j)
+				out->writeLine(TO_S(this, (j.v() ? S("+ ") : S("- ")) << j.k()));
+		}
+
+		out->close();
+	}
+
+	void StartupCache::load() {
+		if (!file->exists())
+			return;
+
+		TextInput *in = readText(file);
+		if (!in->more() || *in->readLine() != *new (this) Str(cacheHeader)) {
+			in->close();
+			return;
+		}
+
+		Str *packagePrefix = new (this) Str(S("package "));
+		StartupEntry *current = null;
+		while (in->more()) {
+			Str *line = in->readLine();
+			if (line->empty())
+				continue;
+
+			if (line->startsWith(packagePrefix)) {
+				// Format: package <key> <identifier>
+				Str *rest = line->cut(line->begin() + packagePrefix->peekLength());
+				Str::Iter space = rest->find(Char(' '));
+				if (space == rest->end()) {
+					current = null;
+					continue;
+				}
+
+				current = new (this) StartupEntry(rest->cut(rest->begin(), space));
+				entries->put(rest->cut(space + 1), current);
+			} else if (current) {
+				// Format: <+ or -> <identifier>
+				Char mark = line->begin().v();
+				if (mark != Char('+') && mark != Char('-'))
+					continue;
+
+				current->fns->put(line->cut(line->begin() + 2), mark == Char('+'));
+			}
+		}
+
+		in->close();
+	}
+
+	Str *StartupCache::packageKey(Package *pkg) {
+		Url *dir = pkg->url();
+		if (!dir)
+			return null;
+
+		if (compilerHash == 0)
+			compilerHash = hashExecutable(engine());
+
+		// Note: The hashes of the files are added so that the order of the files does not matter.
+		Word files = 0;
+		Array<Url *> *children = dir->children();
+		for (Nat i = 0; i < children->count(); i++) {
+			Url *child = children->at(i);
+			if (child->dir())
+				continue;
+
+			files += hashFileInfo(fnvBasis, child);
+		}
+
+		StrBuf *out = new (this) StrBuf();
+		*out << hex(compilerHash) << hex(files);
+		return out->toS();
+	}
+
+}
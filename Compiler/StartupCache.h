@@ -0,0 +1,83 @@
+#pragma once
+#include "Core/Map.h"
+#include "Core/Io/Url.h"
+#include "Package.h"
+
+namespace storm {
+	STORM_PKG(core.lang);
+
+	/**
+	 * The functions recorded for a single package in a StartupCache.
+	 */
+	class StartupEntry : public Object {
+		STORM_CLASS;
+	public:
+		// Create.
+		STORM_CTOR StartupEntry(Str *key);
+
+		// Key computed from the files in the package and the compiler.
+		Str *key;
+
+		// Identifiers of the functions that were compiled, and whether or not they were
+		// compiled with optimizations.
+		Map<Str *, Bool> *fns;
+	};
+
+
+	/**
+	 * A persistent record of the functions that a program needed while it was running, so that
+	 * the same functions can be compiled ahead of time the next time the program is started.
+	 *
+	 * A typical use is to call 'warmUp' for the packages of a program before it starts accepting
+	 * requests, and to call 'record' and 'save' once the program has been running for a while. The
+	 * functions are then compiled in parallel before they are first needed, and functions that were
+	 * frequently used are compiled with optimizations immediately.
+	 *
+	 * Note that only the names of the functions are stored. Parse results, listings and binaries
+	 * are not persisted, since they refer to objects in the GC heap that are created anew on each
+	 * start. Packages are therefore still parsed and code is still generated on each start. The
+	 * cache only moves the code generation ahead of the first request and runs it in parallel.
+	 *
+	 * The entries of each package are keyed on the names, sizes and modification times of the
+	 * files in the package, and on the size and modification time of the Storm executable. Entries
+	 * are ignored if any of them have changed since they were recorded. Only files that are not
+	 * stored on disk are hashed by their contents.
+	 *
+	 * The cache is stored as a text file. If the file is missing or in an unknown format, the
+	 * cache is empty.
+	 */
+	class StartupCache : public ObjectOn<Compiler> {
+		STORM_CLASS;
+	public:
+		// Create a cache stored in 'file'. Reads the file if it exists.
+		STORM_CTOR StartupCache(Url *file);
+
+		// Compile the functions in 'pkg' that were recorded earlier, if 'pkg' is unchanged since
+		// then. Sub-packages are not compiled. Returns the number of functions compiled.
+		Nat STORM_FN warmUp(Package *pkg);
+
+		// Record the functions in 'pkg' that are currently compiled, replacing any previous
+		// entries for 'pkg'. Call 'save' to write the cache to disk.
+		void STORM_FN record(Package *pkg);
+
+		// Write the cache to disk.
+		void STORM_FN save();
+
+	private:
+		// File to store the cache in.
+		Url *file;
+
+		// Entries for each package, keyed on the identifier of the package.
+		Map<Str *, StartupEntry *> *entries;
+
+		// Hash of the size and modification time of the Storm executable. Zero if not yet computed.
+		Word compilerHash;
+
+		// Read the cache from 'file'.
+		void load();
+
+		// Compute the key for 'pkg'. Returns null if 'pkg' can not be cached.
+		MAYBE(Str *) packageKey(Package *pkg);
+	};
+
+}
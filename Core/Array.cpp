@@ -4,6 +4,7 @@
 #include "GcType.h"
 #include "Random.h"
 #include "Sort.h"
+#include "Parallel/Parallel.h"
 #include "Exception.h"
 
 namespace storm {
@@ -205,6 +206,195 @@ namespace storm {
 		sort(d);
 	}
 
+	/**
+	 * Parallel algorithms.
+	 */
+
+	// Minimum number of elements to sort in each worker. Smaller arrays are sorted sequentially.
+	static const Nat parallelSortMin = 4096;
+
+	// Minimum number of elements in each chunk for map and reduce.
+	static const Nat parallelChunkMin = 64;
+
+	static void sortChunk(void *data, Nat chunk, Nat begin, Nat end) {
+		const SortData *d = (const SortData *)data;
+		SortData part(*d, begin, end);
+		// Each chunk needs its own temporary element.
+		part.temp = d->temp + chunk;
+		sort(part);
+	}
+
+	/**
+	 * One round of merging sorted runs. A run consists of 'width' consecutive chunks.
+	 */
+	struct MergeRound {
+		// Data to merge from, and where to store the result.
+		const SortData *from;
+		GcArray<byte> *to;
+
+		// The original chunks.
+		const ParallelChunks *chunks;
+
+		// Number of chunks in each run.
+		Nat width;
+	};
+
+	static void mergeChunk(void *data, Nat pair, Nat, Nat) {
+		MergeRound *m = (MergeRound *)data;
+		Nat count = m->chunks->count();
+		Nat first = pair * 2 * m->width;
+		Nat mid = min(first + m->width, count);
+		Nat last = min(first + 2 * m->width, count);
+
+		SortData d(*m->from, m->chunks->begin(first), m->chunks->end(last - 1));
+		merge(d, mid < count ? m->chunks->begin(mid) : d.end, m->to);
+	}
+
+	static void parallelSort(Engine &e, const SortData &data) {
+		Nat count = Nat(data.end - data.begin);
+		Nat workers = min(parallelWorkers(e), count / parallelSortMin);
+		if (workers <= 1) {
+			sort(data);
+			return;
+		}
+
+		ParallelChunks chunks(count, workers);
+		parallelRun(e, chunks, &sortChunk, (void *)&data);
+
+		// Merge pairs of runs until only one remains, alternating between 'data' and 'aux'.
+		GcArray<byte> *aux = runtime::allocArray<byte>(e, data.type.gcArrayType, count);
+		aux->filled = count;
+
+		SortData from = data;
+		GcArray<byte> *to = aux;
+		for (Nat width = 1; width < chunks.count(); width *= 2) {
+			MergeRound round = { &from, to, &chunks, width };
+			Nat pairs = (chunks.count() + 2*width - 1) / (2*width);
+			parallelRun(e, ParallelChunks(pairs, pairs), &mergeChunk, &round);
+
+			GcArray<byte> *t = from.data;
+			from.data = to;
+			to = t;
+		}
+
+		// The result is in 'aux'. Move it back.
+		if (from.data != data.data)
+			memcpy(data.data->v, aux->v, count * data.type.size);
+		aux->filled = 0;
+	}
+
+	void ArrayBase::parallelSortRaw() {
+		assert(handle.lessFn, L"The operator < is required when sorting an array.");
+
+		if (empty())
+			return;
+
+		// We need one temporary element for each worker.
+		ensure(count() + parallelWorkers(engine()));
+
+		SortData d(data, handle);
+		parallelSort(engine(), d);
+	}
+
+	void ArrayBase::parallelSortRawPred(FnBase *compare) {
+		if (empty())
+			return;
+
+		// We need one temporary element for each worker.
+		ensure(count() + parallelWorkers(engine()));
+
+		SortData d(data, handle, compare);
+		parallelSort(engine(), d);
+	}
+
+	/**
+	 * State for parallel map and reduce.
+	 */
+	struct ParallelFnData {
+		const ArrayBase *src;
+		FnBase *fn;
+		RawFn call;
+		GcArray<byte> *out;
+		// Handle for the elements in 'out'.
+		const Handle *outHandle;
+	};
+
+	static void mapChunk(void *data, Nat chunk, Nat begin, Nat end) {
+		ParallelFnData *d = (ParallelFnData *)data;
+		size_t size = d->outHandle->size;
+		for (Nat i = begin; i < end; i++) {
+			const void *params[1] = { d->src->getRaw(i) };
+			d->call.call(d->fn, d->out->v + i*size, params);
+		}
+	}
+
+	void ArrayBase::parallelMapRaw(ArrayBase *out, FnBase *fn) const {
+		Nat count = this->count();
+		if (count == 0)
+			return;
+
+		out->ensure(count);
+		// The elements are created in place. The GC scans the entire array regardless of
+		// 'filled', and elements that are not yet created are zero, so this is safe.
+		out->data->filled = count;
+
+		ParallelFnData d = { this, fn, fn->rawCall(), out->data, &out->handle };
+		try {
+			parallelRun(engine(), ParallelChunks(count, parallelWorkers(engine()), parallelChunkMin), &mapChunk, &d);
+		} catch (...) {
+			out->data->filled = 0;
+			throw;
+		}
+	}
+
+	// Combine 'acc' and 'elem' into 'acc' using 'temp' as temporary storage.
+	static void reduceStep(ParallelFnData *d, const Handle &h, void *acc, const void *elem, void *temp) {
+		const void *params[2] = { acc, elem };
+		d->call.call(d->fn, temp, params);
+		h.safeDestroy(acc);
+		memcpy(acc, temp, h.size);
+		memset(temp, 0, h.size);
+	}
+
+	static void reduceChunk(void *data, Nat chunk, Nat begin, Nat end) {
+		ParallelFnData *d = (ParallelFnData *)data;
+		const Handle &h = d->src->handle;
+
+		// Elements 2*chunk and 2*chunk + 1 belong to this chunk.
+		void *acc = d->out->v + (2*chunk)*h.size;
+		void *temp = d->out->v + (2*chunk + 1)*h.size;
+
+		h.safeCopy(acc, d->src->getRaw(begin));
+		for (Nat i = begin + 1; i < end; i++)
+			reduceStep(d, h, acc, d->src->getRaw(i), temp);
+	}
+
+	void ArrayBase::parallelReduceRaw(FnBase *fn, void *out) const {
+		Nat count = this->count();
+		if (count == 0)
+			throw new (this) ArrayError(0, 0, new (this) Str(S("parallelReduce")));
+
+		ParallelChunks chunks(count, parallelWorkers(engine()), parallelChunkMin);
+		GcArray<byte> *partial = runtime::allocArray<byte>(engine(), handle.gcArrayType, 2*chunks.count());
+		partial->filled = partial->count;
+
+		ParallelFnData d = { this, fn, fn->rawCall(), partial, &handle };
+		parallelRun(engine(), chunks, &reduceChunk, &d);
+
+		// Combine the partial results in order, since 'fn' is not necessarily commutative.
+		void *acc = partial->v;
+		void *temp = partial->v + handle.size;
+		for (Nat i = 1; i < chunks.count(); i++) {
+			void *elem = partial->v + (2*i)*handle.size;
+			reduceStep(&d, handle, acc, elem, temp);
+			handle.safeDestroy(elem);
+		}
+
+		handle.safeCopy(out, acc);
+		handle.safeDestroy(acc);
+		partial->filled = 0;
+	}
+
 	void ArrayBase::removeDuplicatesRaw() {
 		if (count() == 0)
 			return;
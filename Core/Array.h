@@ -66,6 +66,19 @@ namespace storm {
 		// Sort using a predicate.
 		void CODECALL sortRawPred(FnBase *compare);
 
+		// Sort the array using the workers in core.parallel. Like 'sortRaw', the sort is not
+		// stable. Small arrays are sorted using 'sortRaw'.
+		void CODECALL parallelSortRaw();
+		void CODECALL parallelSortRawPred(FnBase *compare);
+
+		// Apply 'fn' to each element in parallel and store the results in 'out', which is assumed
+		// to be empty.
+		void CODECALL parallelMapRaw(ArrayBase *out, FnBase *fn) const;
+
+		// Combine all elements using 'fn' in parallel, and store the result in 'out'. 'fn' is
+		// assumed to be associative. Throws if the array is empty.
+		void CODECALL parallelReduceRaw(FnBase *fn, void *out) const;
+
 		// Remove duplicates, assumes sorted beforehand.
 		void CODECALL removeDuplicatesRaw();
 
@@ -289,6 +302,15 @@ namespace storm {
 			return copy;
 		}
 
+		// Sort in parallel.
+		void parallelSort() {
+			parallelSortRaw();
+		}
+
+		void parallelSort(Fn<Bool, T, T> *compare) {
+			parallelSortRawPred(compare);
+		}
+
 		// Remove duplicates, assuming sorted beforehand.
 		// Assumes we have a '==' or '<' in the handle.
 		void removeDuplicates() {
@@ -0,0 +1,356 @@
+#include "stdafx.h"
+#include "Channel.h"
+#include "CloneEnv.h"
+#include "Exception.h"
+#include "StrBuf.h"
+#include "OS/UThread.h"
+
+namespace storm {
+
+	struct ChannelBase::Waiter {
+		// Next waiter in the list. Used by InlineList.
+		Waiter *next;
+
+		// The waiting UThread.
+		os::UThreadData *thread;
+
+		// Shared between all waiters of a single wait. The first channel that manages to set this
+		// to 1 wakes the thread, the others leave it alone.
+		Nat *woken;
+	};
+
+	ChannelBase::ChannelBase(const Handle &type, Nat capacity) : data(null) {
+		capacity = max(capacity, Nat(1));
+		GcArray<byte> *buffer = (GcArray<byte> *)runtime::allocArray(engine(), type.gcArrayType, capacity);
+		data = new (runtime::allocStaticRaw(engine(), &Data::gcType.type)) Data(type, buffer);
+	}
+
+	ChannelBase::ChannelBase(const ChannelBase &o) : data(o.data) {
+		data->addRef();
+	}
+
+	ChannelBase::~ChannelBase() {
+		data->release();
+	}
+
+	void ChannelBase::deepCopy(CloneEnv *env) {
+		// Nothing to do, all copies refer to the same channel.
+	}
+
+	const void *ChannelBase::copyValue(const void *value) {
+		const Handle &h = *data->handle;
+		if (!h.deepCopyFn)
+			return value;
+
+		GcArray<byte> *tmp = (GcArray<byte> *)runtime::allocArray(engine(), h.gcArrayType, 1);
+		h.safeCopy(tmp->v, value);
+		(*h.deepCopyFn)(tmp->v, new (this) CloneEnv());
+		return tmp->v;
+	}
+
+	void ChannelBase::sendRaw(const void *value) {
+		// Copy the value before locking the channel, since deep copies may take time.
+		value = copyValue(value);
+
+		Data *d = data;
+		while (true) {
+			os::InlineList<os::UThreadData> wake;
+			bool done = false;
+			{
+				util::Lock::L z(d->lock);
+				if (d->closed)
+					throw new (this) UsageError(S("Can not send elements to a closed channel."));
+
+				if (d->count < d->buffer->count) {
+					d->push(value);
+					d->notify(d->receivers, wake, false);
+					done = true;
+				}
+			}
+
+			if (done) {
+				wakeAll(wake);
+				return;
+			}
+
+			Waiter w;
+			waitAny(&d, &w, 1, true);
+		}
+	}
+
+	Bool ChannelBase::trySendRaw(const void *value) {
+		Data *d = data;
+		if (atomicRead(d->closed) || atomicRead(d->count) >= d->buffer->count)
+			return false;
+
+		value = copyValue(value);
+
+		os::InlineList<os::UThreadData> wake;
+		{
+			util::Lock::L z(d->lock);
+			if (d->closed || d->count >= d->buffer->count)
+				return false;
+
+			d->push(value);
+			d->notify(d->receivers, wake, false);
+		}
+
+		wakeAll(wake);
+		return true;
+	}
+
+	Bool ChannelBase::receiveRaw(void *to) {
+		Data *d = data;
+		while (true) {
+			os::InlineList<os::UThreadData> wake;
+			bool done = false;
+			{
+				util::Lock::L z(d->lock);
+				if (d->count > 0) {
+					d->pop(to);
+					d->notify(d->senders, wake, false);
+					done = true;
+				} else if (d->closed) {
+					return false;
+				}
+			}
+
+			if (done) {
+				wakeAll(wake);
+				return true;
+			}
+
+			Waiter w;
+			waitAny(&d, &w, 1, false);
+		}
+	}
+
+	Bool ChannelBase::tryReceiveRaw(void *to) {
+		Data *d = data;
+		os::InlineList<os::UThreadData> wake;
+		{
+			util::Lock::L z(d->lock);
+			if (d->count == 0)
+				return false;
+
+			d->pop(to);
+			d->notify(d->senders, wake, false);
+		}
+
+		wakeAll(wake);
+		return true;
+	}
+
+	Nat ChannelBase::drainRaw(ArrayBase *to, Nat max) {
+		Data *d = data;
+		const Handle &h = *d->handle;
+		Nat moved = min(max, atomicRead(d->count));
+		if (moved == 0)
+			return 0;
+
+		// Move the elements to a temporary array while holding the lock, and copy them to 'to'
+		// afterwards, so that we do not allocate memory or run copy constructors while holding
+		// the lock.
+		GcArray<byte> *tmp = (GcArray<byte> *)runtime::allocArray(engine(), h.gcArrayType, moved);
+		os::InlineList<os::UThreadData> wake;
+		{
+			util::Lock::L z(d->lock);
+			moved = min(moved, d->count);
+
+			for (Nat i = 0; i < moved; i++) {
+				d->move(tmp->v + i*h.size);
+				d->notify(d->senders, wake, false);
+			}
+		}
+
+		wakeAll(wake);
+
+		to->reserve(to->count() + moved);
+		for (Nat i = 0; i < moved; i++) {
+			to->pushRaw(tmp->v + i*h.size);
+			h.safeDestroy(tmp->v + i*h.size);
+		}
+
+		return moved;
+	}
+
+	void ChannelBase::close() {
+		Data *d = data;
+		os::InlineList<os::UThreadData> wake;
+		{
+			util::Lock::L z(d->lock);
+			d->closed = 1;
+			d->notify(d->senders, wake, true);
+			d->notify(d->receivers, wake, true);
+		}
+
+		wakeAll(wake);
+	}
+
+	Bool ChannelBase::closed() const {
+		return atomicRead(data->closed) != 0;
+	}
+
+	Nat ChannelBase::count() const {
+		return atomicRead(data->count);
+	}
+
+	Nat ChannelBase::capacity() const {
+		return Nat(data->buffer->count);
+	}
+
+	void ChannelBase::toS(StrBuf *to) const {
+		*to << S("Channel(") << count() << S("/") << capacity();
+		if (closed())
+			*to << S(", closed");
+		*to << S(")");
+	}
+
+	Nat ChannelBase::waitAny(Data **channels, Waiter *waiters, Nat count, bool send) {
+		os::UThreadState *state = os::UThreadState::current();
+		Nat woken = 0;
+		Nat found = count;
+
+		// Add ourselves to all channels, unless we find one that is ready.
+		Nat registered = 0;
+		for (; registered < count; registered++) {
+			Data *d = channels[registered];
+			util::Lock::L z(d->lock);
+			if (d->ready(send)) {
+				found = registered;
+				break;
+			}
+
+			Waiter &w = waiters[registered];
+			w.next = null;
+			w.thread = state->runningThread();
+			w.woken = &woken;
+			(send ? d->senders : d->receivers).push(&w);
+		}
+
+		// If we found a ready channel, we try to cancel the wait. If that fails, one of the other
+		// channels has already decided to wake us, and we need to wait for that to happen.
+		if (found == count || atomicCAS(woken, 0, 1) != 0)
+			state->wait();
+
+		// Remove ourselves from the channels. If we waited for more than one channel, we might
+		// have consumed a notification meant for a channel the caller will not use. In that case,
+		// we pass it on to someone else waiting for that channel.
+		os::InlineList<os::UThreadData> wake;
+		for (Nat i = 0; i < registered; i++) {
+			Data *d = channels[i];
+			util::Lock::L z(d->lock);
+			os::InlineList<Waiter> &list = send ? d->senders : d->receivers;
+			list.remove(&waiters[i]);
+			if (count > 1 && d->ready(send))
+				d->notify(list, wake, false);
+		}
+
+		wakeAll(wake);
+		return found;
+	}
+
+	void ChannelBase::wakeAll(os::InlineList<os::UThreadData> &wake) {
+		while (os::UThreadData *toWake = wake.pop())
+			toWake->owner()->wake(toWake);
+	}
+
+	Nat select(Array<ChannelBase *> *channels) {
+		Nat count = channels->count();
+		if (count == 0)
+			throw new (channels) UsageError(S("Can not select from an empty array of channels."));
+
+		vector<ChannelBase::Data *> data(count, null);
+		vector<ChannelBase::Waiter> waiters(count);
+		for (Nat i = 0; i < count; i++)
+			data[i] = channels->at(i)->data;
+
+		while (true) {
+			Nat found = ChannelBase::waitAny(&data[0], &waiters[0], count, false);
+			if (found < count)
+				return found;
+		}
+	}
+
+
+	/**
+	 * Shared data.
+	 */
+
+	const GcTypeStore<2> ChannelBase::Data::gcType = {
+		{
+			GcType::tFixed,
+			null,
+			&ChannelBase::Data::finalize,
+			sizeof(ChannelBase::Data),
+			2,
+			// First pointer offset.
+			{ OFFSET_OF(ChannelBase::Data, handle) }
+		},
+		// Remaining pointer offset.
+		{
+			OFFSET_OF(ChannelBase::Data, buffer),
+		}
+	};
+
+	ChannelBase::Data::Data(const Handle &type, GcArray<byte> *buffer)
+		: handle(&type), buffer(buffer), head(0), count(0), closed(0), refs(1) {}
+
+	ChannelBase::Data::~Data() {}
+
+	void ChannelBase::Data::push(const void *value) {
+		handle->safeCopy(at(count), value);
+		count++;
+	}
+
+	void ChannelBase::Data::pop(void *to) {
+		void *first = at(0);
+		if (to)
+			handle->safeCopy(to, first);
+		handle->safeDestroy(first);
+		removeFirst();
+	}
+
+	void ChannelBase::Data::move(void *to) {
+		memcpy(to, at(0), handle->size);
+		removeFirst();
+	}
+
+	void ChannelBase::Data::removeFirst() {
+		// Clear the slot so that the GC does not keep the old element alive.
+		memset(at(0), 0, handle->size);
+
+		head = Nat((head + 1) % buffer->count);
+		count--;
+	}
+
+	void ChannelBase::Data::notify(os::InlineList<Waiter> &list, os::InlineList<os::UThreadData> &wake, bool all) {
+		while (Waiter *w = list.pop()) {
+			// Skip threads that were already woken by some other channel.
+			if (atomicCAS(*w->woken, 0, 1) != 0)
+				continue;
+
+			wake.push(w->thread);
+			if (!all)
+				break;
+		}
+	}
+
+	void ChannelBase::Data::addRef() {
+		atomicIncrement(refs);
+	}
+
+	void ChannelBase::Data::release() {
+		if (atomicDecrement(refs) == 0)
+			this->~Data();
+	}
+
+	void ChannelBase::Data::finalize(void *object, os::Thread *) {
+		// If the refcount is not zero, someone forgot to update the refcount, and we need to call
+		// the destructor.
+		Data *d = static_cast<Data *>(object);
+		if (atomicRead(d->refs) != 0)
+			d->~Data();
+	}
+
+}
@@ -0,0 +1,250 @@
+#pragma once
+#include "Object.h"
+#include "Handle.h"
+#include "Array.h"
+#include "GcTypeStore.h"
+#include "OS/InlineList.h"
+#include "Utils/Lock.h"
+
+namespace os {
+	class UThreadData;
+}
+
+namespace storm {
+	STORM_PKG(core);
+
+	/**
+	 * Base class for Channel<T>.
+	 *
+	 * A channel is a bounded queue that is shared between threads. Any number of threads may send
+	 * elements to the channel, and any number of threads may receive elements from it. Elements
+	 * are received in the order they were sent. When the channel is full, senders wait until a
+	 * receiver has made room for more elements, and when it is empty, receivers wait until an
+	 * element is sent. Waiting only blocks the current UThread, so other UThreads on the same
+	 * thread may continue executing in the meantime.
+	 *
+	 * Like Future and Sema, copies of a channel refer to the same channel. As such, a channel may
+	 * be passed to other threads as a parameter. Elements are deep copied when they are sent, so
+	 * that the sender and the receiver do not share any data. Use Transfer<T> to avoid copying
+	 * large objects.
+	 *
+	 * A channel may be closed by calling 'close'. After that, no more elements may be sent to the
+	 * channel. Receivers may still receive the elements that were sent before the channel was
+	 * closed, after which 'receive' returns an empty value.
+	 */
+	class ChannelBase : public Object {
+		STORM_CLASS;
+	public:
+		// Create a channel that holds at most 'capacity' elements.
+		ChannelBase(const Handle &type, Nat capacity);
+
+		// Copy. Refers to the same channel.
+		ChannelBase(const ChannelBase &o);
+
+		// Destroy.
+		~ChannelBase();
+
+		// Deep copy. Does nothing, as all copies refer to the same channel.
+		virtual void STORM_FN deepCopy(CloneEnv *env);
+
+		// Send an element, waiting until there is room for it. Throws if the channel is closed.
+		void CODECALL sendRaw(const void *value);
+
+		// Send an element if there is room for it. Returns false if the channel is full or closed.
+		Bool CODECALL trySendRaw(const void *value);
+
+		// Receive an element, waiting until one is available. 'to' is uninitialized memory where
+		// the element is copied. Returns false, without touching 'to', if the channel is closed
+		// and empty.
+		Bool CODECALL receiveRaw(void *to);
+
+		// Receive an element if one is available. Returns false if the channel is empty.
+		Bool CODECALL tryReceiveRaw(void *to);
+
+		// Move at most 'max' elements to the end of 'to' without waiting. Returns the number of
+		// elements moved.
+		Nat CODECALL drainRaw(ArrayBase *to, Nat max);
+
+		// Close the channel. Wakes all threads waiting for the channel.
+		void STORM_FN close();
+
+		// Is the channel closed?
+		Bool STORM_FN closed() const;
+
+		// Number of elements in the channel.
+		Nat STORM_FN count() const;
+
+		// Maximum number of elements in the channel.
+		Nat STORM_FN capacity() const;
+
+		// Empty?
+		inline Bool STORM_FN empty() const { return count() == 0; }
+
+		// Any elements?
+		inline Bool STORM_FN any() const { return count() > 0; }
+
+		// Full?
+		inline Bool STORM_FN full() const { return count() >= capacity(); }
+
+		// To string.
+		virtual void STORM_FN toS(StrBuf *to) const;
+
+	private:
+		friend Nat select(Array<ChannelBase *> *channels);
+
+		// A UThread waiting for one or more channels. Allocated on the stack of the waiting
+		// UThread.
+		struct Waiter;
+
+		// Data shared between copies of the channel. Allocated on the non-moving GC heap since it
+		// contains OS locks, and reference counted like the data in Future, so that the locks are
+		// released promptly. The finalizer is a backup in case the reference count is not updated.
+		struct Data {
+			Data(const Handle &handle, GcArray<byte> *buffer);
+
+			~Data();
+
+			// Handle.
+			const Handle *handle;
+
+			// Ring buffer of elements. 'count' of the array is the capacity of the channel.
+			GcArray<byte> *buffer;
+
+			// Index of the first element in 'buffer'.
+			Nat head;
+
+			// Number of elements in 'buffer'.
+			Nat count;
+
+			// Closed?
+			Nat closed;
+
+			// References.
+			Nat refs;
+
+			// Lock for the members above and the lists below.
+			util::Lock lock;
+
+			// UThreads waiting to send or receive.
+			os::InlineList<Waiter> senders;
+			os::InlineList<Waiter> receivers;
+
+			// Get element number 'i', counting from 'head'.
+			inline void *at(Nat i) const {
+				return buffer->v + ((head + i) % buffer->count) * handle->size;
+			}
+
+			// Is a sender or receiver able to continue?
+			inline bool ready(bool send) const {
+				return closed || (send ? count < buffer->count : count > 0);
+			}
+
+			// Add an element to the end. Assumes the lock is held, and that there is room for it.
+			void push(const void *value);
+
+			// Remove the first element, copying it to 'to' unless it is null. Assumes the lock is held.
+			void pop(void *to);
+
+			// Move the first element to the uninitialized memory at 'to' without copying it.
+			// Assumes the lock is held.
+			void move(void *to);
+
+			// Clear the first slot and remove it from the buffer. Assumes the lock is held, and that
+			// the element has been destroyed or moved.
+			void removeFirst();
+
+			// Pick waiters to wake from 'list' and add them to 'wake'. Assumes the lock is held.
+			void notify(os::InlineList<Waiter> &list, os::InlineList<os::UThreadData> &wake, bool all);
+
+			// Add/release references.
+			void addRef();
+			void release();
+
+			// Finalizer for this type.
+			static void finalize(void *object, os::Thread *thread);
+
+			// GC description for this type.
+			static const GcTypeStore<2> gcType;
+		};
+
+		// Pointer to the data.
+		UNKNOWN(PTR_GC) Data *data;
+
+		// Deep copy 'value' if required. Returns a pointer to the copy.
+		const void *copyValue(const void *value);
+
+		// Wait for any of 'channels' to become ready. Returns the index of a channel that was
+		// found to be ready, or 'count' if we waited and need to check again.
+		static Nat waitAny(Data **channels, Waiter *waiters, Nat count, bool send);
+
+		// Wake all threads in 'wake'. Called without holding any locks.
+		static void wakeAll(os::InlineList<os::UThreadData> &wake);
+	};
+
+	// Wait until one of 'channels' has an element to receive, or is closed. Returns the index of
+	// that channel. Note that another thread may receive the element before the caller does, so
+	// use 'tryReceive' on the returned channel and call 'select' again if it fails.
+	Nat STORM_FN select(Array<ChannelBase *> *channels);
+
+	// Declare the template.
+	STORM_TEMPLATE(Channel, createChannel);
+
+	/**
+	 * Class used from C++.
+	 */
+	template <class T>
+	class Channel : public ChannelBase {
+		STORM_SPECIAL;
+	public:
+		// Get the Storm type for this object.
+		static Type *stormType(Engine &e) {
+			return runtime::cppTemplate(e, ChannelId, 1, StormInfo<T>::id());
+		}
+
+		// Create.
+		Channel(Nat capacity) : ChannelBase(StormInfo<T>::handle(engine()), capacity) {
+			runtime::setVTable(this);
+		}
+
+		// Copy.
+		Channel(const Channel<T> &o) : ChannelBase(o) {
+			runtime::setVTable(this);
+		}
+
+		// Send.
+		void send(T t) {
+			sendRaw(&t);
+		}
+
+		// Try to send.
+		Bool trySend(T t) {
+			return trySendRaw(&t);
+		}
+
+		// Receive. Returns false if the channel is closed and empty.
+		Bool receive(T &to) {
+			byte data[sizeof(T)];
+			if (!receiveRaw(data))
+				return false;
+			to = *(T *)data;
+			((T *)data)->~T();
+			return true;
+		}
+
+		// Try to receive. Returns false if the channel is empty.
+		Bool tryReceive(T &to) {
+			byte data[sizeof(T)];
+			if (!tryReceiveRaw(data))
+				return false;
+			to = *(T *)data;
+			((T *)data)->~T();
+			return true;
+		}
+
+		// Move at most 'max' elements into 'to'.
+		Nat drain(Array<T> *to, Nat max) {
+			return drainRaw(to, max);
+		}
+	};
+
+}
@@ -1,23 +1,99 @@
 #include "stdafx.h"
 #include "CloneEnv.h"
-#include "TObject.h"
+#include "Utils/Bitwise.h"
 
 namespace storm {
 
-	CloneEnv::CloneEnv() {
-		const Handle &h = StormInfo<TObject>::handle(engine());
-		MapBase *base = new (this) MapBase(h, h);
-		data = (Map<Object *, Object *> *)base;
-	}
+	// Number of objects stored in the array before we switch to a hash table.
+	static const Nat linearCount = 8;
+
+	CloneEnv::CloneEnv() : count(0), table(null), watch(null) {}
 
 	Object *CloneEnv::cloned(Object *o) {
-		// It is ok if we accidentally insert an additional 'null', that will be overwritten soon
-		// anyway!
-		return data->get(o, null);
+		if (!hashed()) {
+			// Small enough for linear search.
+			for (Nat i = 0; i < count; i++)
+				if (table->v[2*i] == o)
+					return table->v[2*i + 1];
+			return null;
+		}
+
+		Nat slot = find(o);
+		if (table->v[2*slot] == o)
+			return table->v[2*slot + 1];
+
+		// Did the GC move any objects? Then 'o' may be in the wrong slot.
+		if (watch->moved()) {
+			rehash(slots());
+			slot = find(o);
+			if (table->v[2*slot] == o)
+				return table->v[2*slot + 1];
+		}
+
+		return null;
 	}
 
 	void CloneEnv::cloned(Object *o, Object *to) {
-		data->put(o, to);
+		if (!hashed()) {
+			if (count < linearCount) {
+				if (!table)
+					table = runtime::allocArray<Object *>(engine(), &pointerArrayType, 2*linearCount);
+
+				table->v[2*count] = o;
+				table->v[2*count + 1] = to;
+				count++;
+				return;
+			}
+
+			// Switch to a hash table. We do not store the hashes of the objects, as that is
+			// expensive and the table is short-lived. Instead, we watch for moving objects, since
+			// their hashes may change when they are moved.
+			watch = runtime::createWatch(engine());
+			rehash(linearCount * 4);
+		} else if (2*(count + 1) > slots()) {
+			// Keep the load factor below 0.5 to keep probe sequences short.
+			rehash(slots() * 2);
+		}
+
+		// Register the dependency before computing the hash, in case 'o' moves in between.
+		watch->add(o);
+		Nat slot = find(o);
+		table->v[2*slot] = o;
+		table->v[2*slot + 1] = to;
+		count++;
+	}
+
+	bool CloneEnv::hashed() const {
+		return slots() > linearCount;
+	}
+
+	Nat CloneEnv::find(Object *o) const {
+		Nat mask = slots() - 1;
+		Nat slot = runtime::identityHash(engine(), o) & mask;
+		while (table->v[2*slot] != null && table->v[2*slot] != o)
+			slot = (slot + 1) & mask;
+		return slot;
+	}
+
+	void CloneEnv::rehash(Nat newSlots) {
+		assert(isPowerOfTwo(newSlots));
+
+		GcArray<Object *> *old = table;
+		Nat oldSlots = Nat(old->count / 2);
+
+		table = runtime::allocArray<Object *>(engine(), &pointerArrayType, 2*newSlots);
+		watch->clear();
+
+		for (Nat i = 0; i < oldSlots; i++) {
+			Object *key = old->v[2*i];
+			if (!key)
+				continue;
+
+			watch->add(key);
+			Nat slot = find(key);
+			table->v[2*slot] = key;
+			table->v[2*slot + 1] = old->v[2*i + 1];
+		}
 	}
 
 }
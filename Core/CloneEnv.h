@@ -1,6 +1,7 @@
 #pragma once
 #include "Object.h"
-#include "Map.h"
+#include "GcArray.h"
+#include "GcWatch.h"
 #include "Utils/Templates.h"
 
 namespace storm {
@@ -9,8 +10,14 @@ namespace storm {
 	/**
 	 * Remember objects copied during a clone.
 	 *
-	 * TODO: We can maybe increase performance by inlining the implementation from Map and ripping
-	 * out any Handles.
+	 * Since a CloneEnv is created for each deep copy, and most deep copies only involve a few
+	 * objects, the first few objects are simply stored in an array that is searched linearly. This
+	 * means that we do not need to worry about the GC moving objects for small clones. When more
+	 * objects are cloned, the array is turned into an open-addressed hash table keyed by the
+	 * identity hash of the original objects. The hashes are not stored in the GC, since that is
+	 * expensive, and the hashes of objects that are not stored may change when the GC moves them.
+	 * Therefore, a GcWatch is used to detect when the GC moves objects, in which case the table is
+	 * re-hashed.
 	 */
 	class CloneEnv : public Object {
 		STORM_CLASS;
@@ -20,12 +27,32 @@ namespace storm {
 		// If 'o' was cloned before, get the clone of it. Otherwise returns null.
 		Object *cloned(Object *o);
 
-		// Tell us that 'o' is cloned into 'to'.
+		// Tell us that 'o' is cloned into 'to'. Assumes 'o' was not cloned before.
 		void cloned(Object *o, Object *to);
 
 	private:
-		// Keep track of the cloned objects. Note: we're letting this map act as if it contained TObjects.
-		Map<Object *, Object *> *data;
+		// Number of objects stored.
+		Nat count;
+
+		// Table of pairs: element 2*i is the original object and 2*i + 1 is its clone. Null if
+		// nothing has been cloned yet. Empty slots have a null original.
+		GcArray<Object *> *table;
+
+		// Watch for moving objects. Only used when 'table' is a hash table.
+		GcWatch *watch;
+
+		// Number of slots in 'table'.
+		inline Nat slots() const { return table ? Nat(table->count / 2) : 0; }
+
+		// Is 'table' a hash table?
+		bool hashed() const;
+
+		// Find the slot containing 'o', or the empty slot where it should be inserted. Only for
+		// the hash table.
+		Nat find(Object *o) const;
+
+		// Re-create the hash table with 'slots' slots.
+		void rehash(Nat slots);
 	};
 
 
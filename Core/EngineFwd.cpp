@@ -38,6 +38,10 @@ namespace storm {
 			&runtime::threadGroup,
 			&runtime::threadLock,
 			&runtime::createWatch,
+			&runtime::stableIdentityHash,
+			&runtime::identityHash,
+			&runtime::storeIdentityHash,
+			&runtime::releaseIdentityHash,
 			&runtime::postStdRequest,
 			&runtime::cloneObject,
 			&runtime::cloneObjectEnv,
@@ -52,6 +52,10 @@ namespace storm {
 		os::ThreadGroup &(*threadGroup)(Engine &e);
 		util::Lock &(*threadLock)(Engine &e);
 		GcWatch *(*createWatch)(Engine &e);
+		bool (*stableIdentityHash)(Engine &e);
+		Nat (*identityHash)(Engine &e, const void *obj);
+		Nat (*storeIdentityHash)(Engine &e, const void *obj);
+		void (*releaseIdentityHash)(Engine &e, const void *obj);
 		void (*postStdRequest)(Engine &e, StdRequest *request);
 		RootObject *(*cloneObject)(RootObject *obj);
 		RootObject *(*cloneObjectEnv)(RootObject *obj, CloneEnv *env);
@@ -1,6 +1,7 @@
 #pragma once
 #include "Object.h"
 #include "TObject.h"
+#include "Handle.h"
 #include "CloneEnv.h"
 #include "OS/FnCall.h"
 #include "Utils/Templates.h"
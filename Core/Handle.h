@@ -28,6 +28,11 @@ namespace storm {
 		// Is this type hashed based off its pointer somehow?
 		bool locationHash;
 
+		// Is this type a pointer that is hashed using 'runtime::identityHash'? If so, containers
+		// call 'runtime::storeIdentityHash' when inserting elements, and
+		// 'runtime::releaseIdentityHash' when removing them.
+		bool identityHash;
+
 		// Copy constructor. Acts as an assignment (ie. never deeply copies heap-allocated types).
 		typedef void (*CopyFn)(void *dest, const void *src);
 		UNKNOWN(PTR_GC) CopyFn copyFn;
@@ -96,6 +96,19 @@ namespace storm {
 		return r;
 	}
 
+	Buffer cutInto(EnginePtr e, Buffer into, Buffer src, Nat from, Nat to) {
+		if (to <= from || into.count() < to - from)
+			return cut(e, src, from, to);
+
+		Nat copy = 0;
+		if (src.filled() > from) {
+			copy = min(to, src.filled()) - from;
+			memcpy(into.dataPtr(), src.dataPtr() + from, copy);
+		}
+		into.filled(copy);
+		return into;
+	}
+
 	void Buffer::toS(StrBuf *to) const {
 		outputMark(to, count() + 1);
 	}
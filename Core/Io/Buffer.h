@@ -127,6 +127,11 @@ namespace storm {
 	Buffer STORM_FN cut(EnginePtr e, Buffer src, Nat from);
 	Buffer STORM_FN cut(EnginePtr e, Buffer src, Nat from, Nat to);
 
+	// Like `cut`, but stores the bytes in `into` if it is large enough, rather than allocating a
+	// new buffer. Returns the buffer that contains the bytes, which is either `into` or a new
+	// buffer. Useful to reuse a buffer for data that is extracted repeatedly.
+	Buffer STORM_FN cutInto(EnginePtr e, Buffer into, Buffer src, Nat from, Nat to);
+
 	// Conversion to/from UTF-8 strings. This is possible through the memory streams and text
 	// interface as well, but this is more convenient in some cases.
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "Core/Object.h"
 #include "Core/Array.h"
+#include "Core/Map.h"
 #include "Core/Exception.h"
 #include "Buffer.h"
 
@@ -36,15 +36,30 @@ namespace storm {
 
 		if (o.watch)
 			watch = o.watch->clone();
+
+		// We contain the same objects as 'o'.
+		storeHashes();
 	}
 
 	void MapBase::deepCopy(CloneEnv *env) {
 		if (keyT.deepCopyFn) {
+			// Copies of keys hashed by their identity have different hashes than the originals.
+			bool identity = keyT.locationHash || keyT.identityHash;
+			if (identity && watch)
+				watch->clear();
+
 			for (size_t i = 0; i < capacity(); i++) {
 				if (info->v[i].status != Info::free) {
+					if (identity)
+						releaseHash(keyPtr(Nat(i)));
 					(*keyT.deepCopyFn)(keyPtr(Nat(i)), env);
+					if (identity)
+						info->v[i].hash = insertHash(keyPtr(Nat(i)), info->v[i].hash);
 				}
 			}
+
+			if (identity && capacity() > 0)
+				rehash(capacity());
 		}
 
 		if (valT.deepCopyFn) {
@@ -57,6 +72,11 @@ namespace storm {
 	}
 
 	void MapBase::clear() {
+		releaseHashes();
+		reset();
+	}
+
+	void MapBase::reset() {
 		size = 0;
 		lastFree = 0;
 		info = null;
@@ -108,6 +128,50 @@ namespace storm {
 		}
 	}
 
+	nat MapBase::insertHash(const void *key, nat hash) {
+		if (watch) {
+			// In case the object moved, we need to re-compute the hash.
+			return newHash(key);
+		} else if (keyT.identityHash) {
+			// Make sure the hash stays the same if the object moves.
+			const void *kPtr = *(const void **)key;
+			if (kPtr)
+				return runtime::storeIdentityHash(engine(), kPtr);
+		}
+		return hash;
+	}
+
+	void MapBase::releaseHash(const void *key) {
+		if (!watch && keyT.identityHash) {
+			const void *kPtr = *(const void **)key;
+			if (kPtr)
+				runtime::releaseIdentityHash(engine(), kPtr);
+		}
+	}
+
+	void MapBase::storeHashes() {
+		if (watch || !keyT.identityHash)
+			return;
+
+		for (nat i = 0; i < capacity(); i++) {
+			if (info->v[i].status == Info::free)
+				continue;
+
+			const void *kPtr = *(const void **)keyPtr(i);
+			if (kPtr)
+				runtime::storeIdentityHash(engine(), kPtr);
+		}
+	}
+
+	void MapBase::releaseHashes() {
+		if (watch || !keyT.identityHash)
+			return;
+
+		for (nat i = 0; i < capacity(); i++)
+			if (info->v[i].status != Info::free)
+				releaseHash(keyPtr(i));
+	}
+
 	bool MapBase::changedHash(const void *key) {
 		if (watch) {
 			const void *kPtr = *(const void **)key;
@@ -121,9 +185,7 @@ namespace storm {
 		nat hash = (*keyT.hashFn)(key);
 		nat old = findSlot(key, hash);
 		if (old == Info::free) {
-			if (watch)
-				// In case the object moved, we need to re-compute the hash.
-				hash = newHash(key);
+			hash = insertHash(key, hash);
 			nat w = Info::free;
 			insert(key, value, hash, w);
 			return true;
@@ -245,6 +307,7 @@ namespace storm {
 
 				// Destroy the node.
 				info->v[slot].status = Info::free;
+				releaseHash(keyPtr(slot));
 				keyT.safeDestroy(keyPtr(slot));
 				valT.safeDestroy(valPtr(slot));
 
@@ -391,7 +454,7 @@ namespace storm {
 
 			// The Gc will destroy the old arrays and all elements in there later on.
 		} catch (...) {
-			clear();
+			reset();
 
 			// Restore old state.
 			swap(oldSize, size);
@@ -436,7 +499,7 @@ namespace storm {
 			// The Gc will destroy the old arrays and all elements in there later on.
 			return found;
 		} catch (...) {
-			clear();
+			reset();
 
 			// Restore old state.
 			swap(oldSize, size);
@@ -486,7 +549,7 @@ namespace storm {
 			// The Gc will destroy the old arrays and all elements in there later on.
 			return found;
 		} catch (...) {
-			clear();
+			reset();
 
 			// Restore old state.
 			swap(oldSize, size);
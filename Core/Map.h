@@ -92,9 +92,7 @@ namespace storm {
 			nat slot = findSlot(key, hash);
 
 			if (slot == Info::free) {
-				if (watch)
-					// In case the object moved, we need to re-compute the hash.
-					hash = newHash(key);
+				hash = insertHash(key, hash);
 				nat w = Info::free;
 				slot = insert(key, hash, w);
 				fn(valPtr(slot), engine());
@@ -195,6 +193,21 @@ namespace storm {
 		// object is moved.
 		nat newHash(const void *key);
 
+		// Compute the hash for an element that is about to be inserted. 'hash' is the hash that
+		// was used to find out that the element is not present.
+		nat insertHash(const void *key, nat hash);
+
+		// Tell the GC that 'key', which was inserted using 'insertHash', is about to be removed.
+		void releaseHash(const void *key);
+
+		// Call 'runtime::storeIdentityHash' or 'runtime::releaseIdentityHash' for all keys, if
+		// the keys are hashed by their identity.
+		void storeHashes();
+		void releaseHashes();
+
+		// Remove all elements without telling the GC.
+		void reset();
+
 		// Check if the hash of an object has changed due to the GC moving the object. Only returns
 		// 'true' if we're using location dependent hashes with the 'watch' object.
 		bool changedHash(const void *key);
@@ -1,5 +1,9 @@
 #include "stdafx.h"
 #include "Listener.h"
+#include <cstdlib>
+#if defined(POSIX)
+#include <sys/stat.h>
+#endif
 
 namespace storm {
 
@@ -23,6 +27,26 @@ namespace storm {
 		return null;
 	}
 
+	Bool Listener::handover(Url *to) {
+		if (handle == os::Handle())
+			return false;
+
+		sockaddr_storage addr;
+		socklen_t addrSize = localSocketAddr(&addr, to->format()->utf8_str());
+		if (addrSize == 0)
+			return false;
+
+		os::Handle local = createLocalSocket();
+		if (!local)
+			return false;
+
+		attachedTo.attach(local);
+		bool ok = connectSocket(local, attachedTo, (sockaddr *)&addr, addrSize)
+			&& sendHandle(local, attachedTo, handle);
+		closeSocket(local, attachedTo);
+		return ok;
+	}
+
 	void Listener::toS(StrBuf *to) const {
 		Socket::toS(to);
 		*to << S(" (listening)");
@@ -76,6 +100,107 @@ namespace storm {
 		return listen(e, (sockaddr *)&addr, sizeof(addr), reuseAddr);
 	}
 
+	Listener *inheritListener(EnginePtr e, Nat fd) {
+		initSockets();
+
+#if defined(WINDOWS)
+		os::Handle socket((HANDLE)size_t(fd));
+#else
+		os::Handle socket((int)fd);
+#endif
+		if (!isListeningSocket(socket))
+			return null;
+
+		os::Thread thread = os::Thread::current();
+		thread.attach(socket);
+		return new (e.v) Listener(socket, thread);
+	}
+
+	Listener *inheritListener(EnginePtr e) {
+#if defined(POSIX)
+		// Sockets passed using this protocol start at fd 3.
+		const char *pid = getenv("LISTEN_PID");
+		const char *fds = getenv("LISTEN_FDS");
+		if (!pid || !fds)
+			return null;
+
+		if (atol(pid) != long(getpid()))
+			return null;
+		if (atoi(fds) < 1)
+			return null;
+
+		// Make sure the sockets are not passed on to any children.
+		unsetenv("LISTEN_PID");
+		unsetenv("LISTEN_FDS");
+		unsetenv("LISTEN_FDNAMES");
+
+		Listener *result = inheritListener(e, 3);
+		if (result)
+			fcntl(3, F_SETFL, fcntl(3, F_GETFL, 0) | O_NONBLOCK);
+		return result;
+#else
+		return null;
+#endif
+	}
+
+	Listener *receiveListener(Url *from) {
+		initSockets();
+
+		const char *path = from->format()->utf8_str();
+		sockaddr_storage addr;
+		socklen_t addrSize = localSocketAddr(&addr, path);
+		if (addrSize == 0)
+			return null;
+
+		os::Handle local = createLocalSocket();
+		if (!local)
+			return null;
+
+#if defined(POSIX)
+		// Remove any stale socket from an earlier handover, but never anything else.
+		struct stat info;
+		if (lstat(path, &info) == 0) {
+			if (!S_ISSOCK(info.st_mode)) {
+				closeSocket(local, os::Thread::invalid);
+				return null;
+			}
+			unlink(path);
+		}
+#endif
+
+		os::Thread thread = os::Thread::current();
+		os::Handle received;
+		if (bindSocket(local, (sockaddr *)&addr, addrSize)) {
+			if (listenSocket(local, 1)) {
+				thread.attach(local);
+
+				sockaddr_storage peer;
+				os::Handle conn = acceptSocket(local, thread, (sockaddr *)&peer, sizeof(peer));
+				if (conn) {
+					thread.attach(conn);
+					received = receiveHandle(conn, thread);
+					closeSocket(conn, thread);
+				}
+				closeSocket(local, thread);
+			} else {
+				closeSocket(local, os::Thread::invalid);
+			}
+
+#if defined(POSIX)
+			// Remove the socket we created.
+			unlink(path);
+#endif
+		} else {
+			closeSocket(local, os::Thread::invalid);
+		}
+
+		if (!received)
+			return null;
+
+		thread.attach(received);
+		return new (from) Listener(received, thread);
+	}
+
 	Listener *listen(Address *addr) {
 		return listen(addr, true);
 	}
@@ -3,6 +3,7 @@
 #include "Address.h"
 #include "NetStream.h"
 #include "Core/EnginePtr.h"
+#include "Core/Io/Url.h"
 
 namespace storm {
 	STORM_PKG(core.net);
@@ -25,6 +26,12 @@ namespace storm {
 		// Accept a new connection. Returns `null` if the listener has been closed.
 		MAYBE(NetStream *) STORM_FN accept();
 
+		// Hand the listening socket over to another process that is waiting in `receiveListener`
+		// for the local socket `to`. The listener in this process is left open, so that it is
+		// possible to keep accepting connections until the new process is ready. Call `close`
+		// afterwards to stop accepting connections here. Only supported on POSIX systems.
+		Bool STORM_FN handover(Url *to);
+
 		// To string.
 		virtual void STORM_FN toS(StrBuf *to) const;
 	};
@@ -41,4 +48,19 @@ namespace storm {
 	// Listen on the address specified by `addr`, explicitly specifying the use of SO_REUSEADDR.
 	MAYBE(Listener *) STORM_FN listen(Address *addr, Bool reuseAddr);
 
+	// Create a listener from a listening socket inherited from the parent process, for example
+	// from a process manager that passes sockets to its children. Returns `null` if `fd` is not a
+	// listening socket.
+	MAYBE(Listener *) STORM_FN inheritListener(EnginePtr e, Nat fd);
+
+	// Create a listener from the first socket passed using the systemd socket activation protocol
+	// (i.e. the environment variables `LISTEN_FDS` and `LISTEN_PID`). Returns `null` if no socket
+	// was passed to this process.
+	MAYBE(Listener *) STORM_FN inheritListener(EnginePtr e);
+
+	// Wait for another process to hand over a listening socket through `Listener.handover`, using
+	// the local socket `from`. Returns `null` on failure, or if `from` exists and is not a socket.
+	// Only supported on POSIX systems.
+	MAYBE(Listener *) STORM_FN receiveListener(Url *from);
+
 }
@@ -191,6 +191,29 @@ namespace storm {
 		return setSocketOpt(handle, level, name, &out, sizeof(out));
 	}
 
+	// Handle passing is not supported on Windows. WSADuplicateSocket requires the target process
+	// id, which does not fit the model used here.
+	os::Handle createLocalSocket() {
+		return os::Handle();
+	}
+
+	socklen_t localSocketAddr(sockaddr_storage *out, const char *path) {
+		return 0;
+	}
+
+	bool sendHandle(os::Handle socket, const os::Thread &attached, os::Handle send) {
+		return false;
+	}
+
+	os::Handle receiveHandle(os::Handle socket, const os::Thread &attached) {
+		return os::Handle();
+	}
+
+	bool isListeningSocket(os::Handle socket) {
+		BOOL listening = FALSE;
+		return getSocketOpt(socket, SOL_SOCKET, SO_ACCEPTCONN, &listening, sizeof(listening)) && listening;
+	}
+
 
 #elif defined(POSIX)
 
@@ -332,6 +355,116 @@ namespace storm {
 		return setSocketOpt(socket, level, name, &tv, sizeof(tv));
 	}
 
+	os::Handle createLocalSocket() {
+		return createSocket(AF_UNIX, SOCK_STREAM, 0);
+	}
+
+	socklen_t localSocketAddr(sockaddr_storage *out, const char *path) {
+		sockaddr_un *addr = (sockaddr_un *)out;
+		size_t len = strlen(path);
+		if (len >= sizeof(addr->sun_path))
+			return 0;
+
+		memset(addr, 0, sizeof(sockaddr_un));
+		addr->sun_family = AF_UNIX;
+		memcpy(addr->sun_path, path, len);
+		return socklen_t(offsetof(sockaddr_un, sun_path) + len + 1);
+	}
+
+	// Control message large enough to carry a single file descriptor.
+	union FdControl {
+		char data[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	};
+
+	bool sendHandle(os::Handle socket, const os::Thread &attached, os::Handle send) {
+		// We need to send at least one byte of regular data along with the descriptor.
+		char dummy = 0;
+		struct iovec iov = { &dummy, 1 };
+
+		FdControl control;
+		memset(&control, 0, sizeof(control));
+
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.data;
+		msg.msg_controllen = sizeof(control.data);
+
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		int fd = send.v();
+		memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+		while (true) {
+			if (sendmsg(socket.v(), &msg, MSG_NOSIGNAL) >= 0)
+				return true;
+
+			if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN) {
+				if (!doWait(socket, attached, os::IORequest::write))
+					return false;
+			} else {
+				return false;
+			}
+		}
+	}
+
+	os::Handle receiveHandle(os::Handle socket, const os::Thread &attached) {
+		char dummy = 0;
+		struct iovec iov = { &dummy, 1 };
+
+		FdControl control;
+		memset(&control, 0, sizeof(control));
+
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.data;
+		msg.msg_controllen = sizeof(control.data);
+
+		while (true) {
+			ssize_t r = recvmsg(socket.v(), &msg, MSG_CMSG_CLOEXEC);
+			if (r > 0)
+				break;
+
+			if (r == 0) {
+				// Closed without sending anything.
+				return os::Handle();
+			} else if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN) {
+				if (!doWait(socket, attached, os::IORequest::read))
+					return os::Handle();
+			} else {
+				return os::Handle();
+			}
+		}
+
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+		if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+			return os::Handle();
+
+		int fd = -1;
+		memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+		if (!setNonblocking(fd)) {
+			close(fd);
+			return os::Handle();
+		}
+
+		return os::Handle(fd);
+	}
+
+	bool isListeningSocket(os::Handle socket) {
+		int listening = 0;
+		return getSocketOpt(socket, SOL_SOCKET, SO_ACCEPTCONN, &listening, sizeof(listening)) && listening;
+	}
+
 #else
 #error "Please implement sockets for your platform!"
 #endif
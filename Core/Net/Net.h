@@ -23,6 +23,7 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <sys/un.h>
 
 #else
 
@@ -85,6 +86,25 @@ namespace storm {
 	// Close a socket.
 	void closeSocket(os::Handle socket, const os::Thread &attached);
 
+	// Create a local (AF_UNIX) socket, used to pass handles between processes. Returns an empty
+	// handle on platforms that do not support local sockets.
+	os::Handle createLocalSocket();
+
+	// Fill a sockaddr for a local socket bound to 'path'. Returns the size of the address, or zero if
+	// the path is too long or if local sockets are not supported.
+	socklen_t localSocketAddr(sockaddr_storage *out, const char *path);
+
+	// Send a handle to another process through a connected local socket (SCM_RIGHTS). The handle
+	// is duplicated by the OS, so the caller still owns 'send' afterwards.
+	bool sendHandle(os::Handle socket, const os::Thread &attached, os::Handle send);
+
+	// Receive a handle sent by 'sendHandle'. The new handle is set up for asynchronous operation.
+	// Returns an empty handle on failure.
+	os::Handle receiveHandle(os::Handle socket, const os::Thread &attached);
+
+	// Check if the handle refers to a listening TCP socket. Used to validate inherited sockets.
+	bool isListeningSocket(os::Handle socket);
+
 	// Get the name of the socket (ie. local address bound to the socket).
 	bool getSocketName(os::Handle socket, sockaddr *out, socklen_t size);
 
@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include "Parallel.h"
+#include "OS/ThreadPool.h"
+#include "OS/Future.h"
+
+namespace storm {
+
+	static os::Thread spawnWorkers(Engine &e) {
+		return os::ThreadPool::spawn(0, runtime::threadGroup(e));
+	}
+
+	STORM_DEFINE_THREAD_WAIT(Workers, &spawnWorkers);
+
+	// Maximum number of worker UThreads used for a single operation. The futures for them are
+	// stored on the stack, as they may contain pointers to exceptions that need to be scanned.
+	static const Nat maxWorkers = 64;
+
+	ParallelChunks::ParallelChunks(Nat count, Nat workers, Nat minSize) {
+		minSize = max(minSize, Nat(1));
+		workers = max(workers, Nat(1));
+
+		// Guided scheduling: each chunk is a fraction of the remaining work.
+		Nat at = 0;
+		bounds.push_back(at);
+		while (at < count) {
+			Nat remaining = count - at;
+			Nat size = max(minSize, remaining / (2 * workers));
+			at += min(size, remaining);
+			bounds.push_back(at);
+		}
+	}
+
+	ParallelChunks::ParallelChunks(Nat count, Nat chunks) {
+		chunks = max(Nat(1), min(chunks, count));
+
+		bounds.push_back(0);
+		for (Nat i = 1; i <= chunks; i++)
+			bounds.push_back(Nat(Word(count) * i / chunks));
+	}
+
+	Nat parallelWorkers(Engine &e) {
+		return min(os::ThreadPool::cpuCount(), maxWorkers);
+	}
+
+	/**
+	 * State shared between the workers of a 'parallelRun'.
+	 */
+	struct ParallelState {
+		const ParallelChunks *chunks;
+		ParallelFn fn;
+		void *data;
+
+		// Next chunk to execute.
+		Nat next;
+
+		// Did any chunk fail?
+		Nat failed;
+	};
+
+	static void parallelWorker(ParallelState *state) {
+		Nat count = state->chunks->count();
+		while (atomicRead(state->failed) == 0) {
+			Nat id = atomicIncrement(state->next) - 1;
+			if (id >= count)
+				break;
+
+			try {
+				(*state->fn)(state->data, id, state->chunks->begin(id), state->chunks->end(id));
+			} catch (...) {
+				atomicWrite(state->failed, 1);
+				throw;
+			}
+		}
+	}
+
+	void parallelRun(Engine &e, const ParallelChunks &chunks, ParallelFn fn, void *data) {
+		if (chunks.count() == 0)
+			return;
+
+		ParallelState state = { &chunks, fn, data, 0, 0 };
+
+		// Just run it here if there is only one chunk.
+		if (chunks.count() == 1) {
+			parallelWorker(&state);
+			return;
+		}
+
+		const os::Thread &on = Workers::thread(e)->thread();
+		Nat workers = min(parallelWorkers(e), chunks.count());
+
+		ParallelState *statePtr = &state;
+		os::Future<void> results[maxWorkers];
+		for (Nat i = 0; i < workers; i++) {
+			os::FnCall<void, 1> call = os::fnCall().add(statePtr);
+			os::UThread::spawn(address(&parallelWorker), false, call, results[i], &on);
+		}
+
+		// Wait for all workers before throwing, they refer to 'state'.
+		Nat firstError = workers;
+		for (Nat i = 0; i < workers; i++) {
+			try {
+				results[i].result();
+			} catch (...) {
+				if (firstError == workers)
+					firstError = i;
+			}
+		}
+
+		if (firstError < workers)
+			results[firstError].result();
+	}
+
+	struct ForData {
+		Fn<void, Nat> *body;
+		Nat offset;
+	};
+
+	static void forChunk(void *data, Nat chunk, Nat begin, Nat end) {
+		ForData *d = (ForData *)data;
+		for (Nat i = begin; i < end; i++)
+			d->body->call(i + d->offset);
+	}
+
+	void parallelFor(EnginePtr e, Nat from, Nat to, Fn<void, Nat> *body) {
+		if (from >= to)
+			return;
+
+		ForData data = { body, from };
+		parallelRun(e.v, ParallelChunks(to - from, parallelWorkers(e.v), 1), &forChunk, &data);
+	}
+
+}
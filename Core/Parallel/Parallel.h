@@ -0,0 +1,79 @@
+#pragma once
+#include "Core/Fn.h"
+#include "Core/Thread.h"
+#include "Core/EnginePtr.h"
+
+namespace storm {
+	STORM_PKG(core.parallel);
+
+	/**
+	 * Data-parallel algorithms.
+	 *
+	 * The algorithms here split their work into chunks that are executed by a pool of worker
+	 * threads, one for each CPU in the system (see the 'Workers' thread below). The chunks are
+	 * handed out to the workers as they become idle, and become smaller towards the end of the
+	 * range, so that uneven workloads are balanced across the workers.
+	 *
+	 * Functions supplied to the algorithms are called directly from the worker threads, and any
+	 * data they receive refers to the original data. Nothing is copied. As such, the functions must
+	 * not modify shared data without proper synchronization. Note, however, that functions that are
+	 * bound to a particular thread are executed on that thread as usual, which serializes the
+	 * calls.
+	 *
+	 * The algorithms for arrays are members of Array<T>: 'parallelSort', 'parallelMap' and
+	 * 'parallelReduce'.
+	 */
+
+	/**
+	 * The thread pool used by the algorithms. Created when first used.
+	 */
+	STORM_THREAD(Workers);
+
+	// Call 'body' once for each number in the range [from, to[, using all workers. Returns when
+	// all calls are done. If any call throws an exception, the remaining calls are skipped and the
+	// exception is re-thrown from here.
+	void STORM_FN parallelFor(EnginePtr e, Nat from, Nat to, Fn<void, Nat> *body);
+
+
+	/**
+	 * Low-level interface for C++.
+	 */
+
+	/**
+	 * A range [0, count[, split into chunks.
+	 */
+	class ParallelChunks {
+	public:
+		// Split into chunks suitable for 'workers' workers. No chunk is smaller than 'minSize'
+		// (except for the last one). Chunks are larger in the beginning of the range and smaller
+		// towards the end, so that workers finish at roughly the same time even if some chunks
+		// take longer than others.
+		ParallelChunks(Nat count, Nat workers, Nat minSize);
+
+		// Split into 'chunks' chunks of equal size.
+		ParallelChunks(Nat count, Nat chunks);
+
+		// Number of chunks.
+		inline Nat count() const { return Nat(bounds.size() - 1); }
+
+		// Bounds of a chunk.
+		inline Nat begin(Nat chunk) const { return bounds[chunk]; }
+		inline Nat end(Nat chunk) const { return bounds[chunk + 1]; }
+
+	private:
+		// Chunk 'i' is [bounds[i], bounds[i+1][.
+		vector<Nat> bounds;
+	};
+
+	// Function executed for each chunk. 'data' is passed through from 'parallelRun'.
+	typedef void (*ParallelFn)(void *data, Nat chunk, Nat begin, Nat end);
+
+	// Number of workers.
+	Nat parallelWorkers(Engine &e);
+
+	// Execute 'fn' for all chunks using the workers, and wait for all of them to finish. If 'fn'
+	// throws an exception, the remaining chunks are skipped and the exception is re-thrown once
+	// all workers are done.
+	void parallelRun(Engine &e, const ParallelChunks &chunks, ParallelFn fn, void *data);
+
+}
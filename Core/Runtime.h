@@ -154,6 +154,20 @@ namespace storm {
 		// Create a GcWatch object.
 		GcWatch *createWatch(Engine &e);
 
+		// Are identity hashes unaffected by objects moving? If not, hash containers using
+		// 'identityHash' need a GcWatch.
+		bool stableIdentityHash(Engine &e);
+
+		// Get the identity hash of an object.
+		Nat identityHash(Engine &e, const void *obj);
+
+		// Get the identity hash of an object that is about to be inserted into a container, and
+		// make sure it stays the same if the object is moved.
+		Nat storeIdentityHash(Engine &e, const void *obj);
+
+		// Tell the GC that a container no longer contains 'obj'.
+		void releaseIdentityHash(Engine &e, const void *obj);
+
 		// Post an IO-request for standard in/out/error.
 		void postStdRequest(Engine &e, StdRequest *request);
 
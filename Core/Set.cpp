@@ -35,19 +35,39 @@ namespace storm {
 
 		if (o.watch)
 			watch = o.watch->clone();
+
+		// We contain the same objects as 'o'.
+		storeHashes();
 	}
 
 	void SetBase::deepCopy(CloneEnv *env) {
 		if (keyT.deepCopyFn) {
+			// Copies of keys hashed by their identity have different hashes than the originals.
+			bool identity = keyT.locationHash || keyT.identityHash;
+			if (identity && watch)
+				watch->clear();
+
 			for (size_t i = 0; i < capacity(); i++) {
 				if (info->v[i].status != Info::free) {
+					if (identity)
+						releaseHash(keyPtr(Nat(i)));
 					(*keyT.deepCopyFn)(keyPtr(Nat(i)), env);
+					if (identity)
+						info->v[i].hash = insertHash(keyPtr(Nat(i)), info->v[i].hash);
 				}
 			}
+
+			if (identity && capacity() > 0)
+				rehash(capacity());
 		}
 	}
 
 	void SetBase::clear() {
+		releaseHashes();
+		reset();
+	}
+
+	void SetBase::reset() {
 		size = 0;
 		lastFree = 0;
 		info = null;
@@ -96,6 +116,50 @@ namespace storm {
 		}
 	}
 
+	nat SetBase::insertHash(const void *key, nat hash) {
+		if (watch) {
+			// In case the object moved, we need to re-compute the hash.
+			return newHash(key);
+		} else if (keyT.identityHash) {
+			// Make sure the hash stays the same if the object moves.
+			const void *kPtr = *(const void **)key;
+			if (kPtr)
+				return runtime::storeIdentityHash(engine(), kPtr);
+		}
+		return hash;
+	}
+
+	void SetBase::releaseHash(const void *key) {
+		if (!watch && keyT.identityHash) {
+			const void *kPtr = *(const void **)key;
+			if (kPtr)
+				runtime::releaseIdentityHash(engine(), kPtr);
+		}
+	}
+
+	void SetBase::storeHashes() {
+		if (watch || !keyT.identityHash)
+			return;
+
+		for (nat i = 0; i < capacity(); i++) {
+			if (info->v[i].status == Info::free)
+				continue;
+
+			const void *kPtr = *(const void **)keyPtr(i);
+			if (kPtr)
+				runtime::storeIdentityHash(engine(), kPtr);
+		}
+	}
+
+	void SetBase::releaseHashes() {
+		if (watch || !keyT.identityHash)
+			return;
+
+		for (nat i = 0; i < capacity(); i++)
+			if (info->v[i].status != Info::free)
+				releaseHash(keyPtr(i));
+	}
+
 	bool SetBase::changedHash(const void *key) {
 		if (watch) {
 			const void *kPtr = *(const void **)key;
@@ -109,9 +173,7 @@ namespace storm {
 		nat hash = (*keyT.hashFn)(key);
 		nat old = findSlot(key, hash);
 		if (old == Info::free) {
-			if (watch)
-				// In case the object moved, we need to re-compute the hash.
-				hash = newHash(key);
+			hash = insertHash(key, hash);
 			nat w = Info::free;
 			insert(key, hash, w);
 			return true;
@@ -162,9 +224,7 @@ namespace storm {
 		nat slot = findSlot(key, hash);
 
 		if (slot == Info::free) {
-			if (watch)
-				// In case the object moved, we need to re-compute the hash.
-				hash = newHash(key);
+			hash = insertHash(key, hash);
 			nat w = Info::free;
 			slot = insert(key, hash, w);
 		}
@@ -207,6 +267,7 @@ namespace storm {
 
 				// Destroy the node.
 				info->v[slot].status = Info::free;
+				releaseHash(keyPtr(slot));
 				keyT.safeDestroy(keyPtr(slot));
 
 				if (prev == Info::free && next != Info::end) {
@@ -339,7 +400,7 @@ namespace storm {
 
 			// The Gc will destroy the old arrays and all elements in there later on.
 		} catch (...) {
-			clear();
+			reset();
 
 			// Restore old state.
 			swap(oldSize, size);
@@ -382,7 +443,7 @@ namespace storm {
 			// The Gc will destroy the old arrays and all elements in there later on.
 			return found;
 		} catch (...) {
-			clear();
+			reset();
 
 			// Restore old state.
 			swap(oldSize, size);
@@ -432,7 +493,7 @@ namespace storm {
 			// The Gc will destroy the old arrays and all elements in there later on.
 			return found;
 		} catch (...) {
-			clear();
+			reset();
 
 			// Restore old state.
 			swap(oldSize, size);
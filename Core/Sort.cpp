@@ -11,23 +11,23 @@ namespace storm {
 		if (d.compare)
 			d.compareFn = d.compare->rawCall();
 
-		assert(d.data->filled < d.data->count, L"Sorting requires at least one free element.");
+		assert(d.temp < d.data->count, L"Sorting requires at least one free element.");
 	}
 
 	SortData::SortData(GcArray<byte> *data, const Handle &type) :
-		data(data), type(type), compare(null), begin(0), end(data->filled) { init(*this); }
+		data(data), type(type), compare(null), begin(0), end(data->filled), temp(data->filled) { init(*this); }
 
 	SortData::SortData(GcArray<byte> *data, const Handle &type, FnBase *compare) :
-		data(data), type(type), compare(compare), begin(0), end(data->filled) { init(*this); }
+		data(data), type(type), compare(compare), begin(0), end(data->filled), temp(data->filled) { init(*this); }
 
 	SortData::SortData(GcArray<byte> *data, const Handle &type, size_t begin, size_t end) :
-		data(data), type(type), compare(null), begin(begin), end(end) { init(*this); }
+		data(data), type(type), compare(null), begin(begin), end(end), temp(data->filled) { init(*this); }
 
 	SortData::SortData(GcArray<byte> *data, const Handle &type, FnBase *compare, size_t begin, size_t end) :
-		data(data), type(type), compare(compare), begin(begin), end(end) { init(*this); }
+		data(data), type(type), compare(compare), begin(begin), end(end), temp(data->filled) { init(*this); }
 
 	SortData::SortData(const SortData &src, size_t begin, size_t end) :
-		data(src.data), type(src.type), compare(src.compare), compareFn(src.compareFn), begin(begin), end(end) {}
+		data(src.data), type(src.type), compare(src.compare), compareFn(src.compareFn), begin(begin), end(end), temp(src.temp) {}
 
 	/**
 	 * Convenience operations.
@@ -79,7 +79,7 @@ namespace storm {
 	// Move 'from' to 'to' while keeping 'preserve' intact. Assumes 'from' is not to be preserved.
 	static inline void move(const SortData &d, size_t &preserve, size_t to, size_t from) {
 		if (preserve == to) {
-			preserve = d.data->filled;
+			preserve = d.temp;
 			move(d, preserve, to);
 		}
 
@@ -163,13 +163,13 @@ namespace storm {
 			return;
 
 		// Move the top element out of the way.
-		move(sort, sort.data->filled, sort.begin);
+		move(sort, sort.temp, sort.begin);
 
 		// Update the heap.
 		siftDown(sort, sort.begin, sort.end - 1);
 
 		// Move the extracted element to its proper location.
-		move(sort, sort.end - 1, sort.data->filled);
+		move(sort, sort.end - 1, sort.temp);
 	}
 
 	void heapSort(const SortData &sort) {
@@ -185,7 +185,7 @@ namespace storm {
 	}
 
 	void insertionSort(const SortData &sort) {
-		size_t scratch = sort.data->filled;
+		size_t scratch = sort.temp;
 
 		for (size_t target = sort.begin + 1; target < sort.end; target++) {
 			// Do we need to do anything at all with this element?
@@ -241,7 +241,7 @@ namespace storm {
 
 	static inline size_t partition(const SortData &now, size_t pivot) {
 		// Move the pivot away into temporary storage.
-		size_t temp = now.data->filled;
+		size_t temp = now.temp;
 		move(now, temp, pivot);
 
 		// Make sure 'now.begin' is empty.
@@ -330,4 +330,23 @@ namespace storm {
 		}
 	}
 
+	void merge(const SortData &sort, size_t mid, GcArray<byte> *to) {
+		size_t size = sort.type.size;
+		size_t l = sort.begin;
+		size_t r = mid;
+		size_t out = sort.begin;
+
+		while (l < mid && r < sort.end) {
+			// Take from the right only if it is strictly smaller, so that the merge is stable.
+			size_t from = compare(sort, r, l) ? r++ : l++;
+			memcpy(to->v + (out++)*size, sort.data->v + from*size, size);
+		}
+
+		if (l < mid) {
+			memcpy(to->v + out*size, sort.data->v + l*size, (mid - l)*size);
+		} else if (r < sort.end) {
+			memcpy(to->v + out*size, sort.data->v + r*size, (sort.end - r)*size);
+		}
+	}
+
 }
@@ -39,6 +39,10 @@ namespace storm {
 		// Range to be affected by the current operation.
 		size_t begin;
 		size_t end;
+
+		// Element used as temporary storage. Defaults to 'data->filled'. Sorting disjoint ranges
+		// of the same array in parallel requires a separate element for each range.
+		size_t temp;
 	};
 
 	// Make a max-heap out of the elements in 'data'. Runs in O(n) time.
@@ -59,4 +63,9 @@ namespace storm {
 	// Sort. Using quicksort but falls back to heapsort if necessary.
 	void sort(const SortData &data);
 
+	// Merge the sorted ranges [begin, mid[ and [mid, end[ into the same positions in 'to'. The
+	// elements are moved, so the range in 'data' is to be considered uninitialized afterwards. The
+	// merge is stable.
+	void merge(const SortData &data, size_t mid, GcArray<byte> *to);
+
 }
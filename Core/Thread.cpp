@@ -1,11 +1,15 @@
 #include "stdafx.h"
 #include "Thread.h"
 #include "Hash.h"
+#include "OS/ThreadPool.h"
 
 namespace storm {
 
 	Thread::Thread() : osThread(os::Thread::invalid), create(null) {}
 
+	Thread::Thread(Nat threads)
+		: osThread(os::ThreadPool::spawn(threads, runtime::threadGroup(engine()))), create(null) {}
+
 	Thread::Thread(const os::Thread &thread) : osThread(thread), create(null) {}
 
 	Thread::Thread(DeclThread::CreateFn fn) : osThread(os::Thread::invalid), create(fn) {}
@@ -67,6 +71,30 @@ namespace storm {
 		return osThread.id() == id;
 	}
 
+	Nat Thread::stackSize() {
+		return Nat(thread().threadData()->uState.stackSize());
+	}
+
+	void Thread::stackSize(Nat size) {
+		thread().threadData()->uState.stackSize(size);
+	}
+
+	ThreadStats Thread::stats() {
+		return ThreadStats(thread().stats());
+	}
+
+	Nat defaultStackSize() {
+		return Nat(os::defaultStackSize);
+	}
+
+	Nat smallStackSize() {
+		return Nat(os::smallStackSize);
+	}
+
+	Word stackMemory() {
+		return os::Stack::allocatedMemory();
+	}
+
 	STORM_DEFINE_THREAD(Compiler);
 
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "Object.h"
+#include "ThreadStats.h"
 
 namespace storm {
 	STORM_PKG(core);
@@ -19,6 +20,14 @@ namespace storm {
 		// Create a thread.
 		STORM_CTOR Thread();
 
+		// Create a pool of 'threads' OS threads that behaves as a single thread to Storm. If
+		// 'threads' is zero, one OS thread per CPU is created. UThreads spawned on the pool are
+		// executed by whichever thread in the pool is idle, and may move between the threads
+		// whenever they are suspended. Only use pools for code that does not depend on the OS
+		// thread it is executed by, and be aware that two UThreads on the pool may execute in
+		// parallel, so any data shared between them must be protected by locks.
+		STORM_CTOR Thread(Nat threads);
+
 		// Create from a previously started os::Thread object. This thread must have called the
 		// 'register' function previously.
 		Thread(const os::Thread &thread);
@@ -49,6 +58,17 @@ namespace storm {
 		bool sameAs(const os::Thread &other) const;
 		bool sameAs(size_t id) const;
 
+		// Size of the stacks of UThreads spawned on this thread, in bytes. The default is large
+		// enough to run the compiler. UThreads that mostly wait for I/O, such as handlers for
+		// network connections, can use 'smallStackSize' to reduce memory usage. Stack memory of
+		// exited UThreads is re-used by new UThreads on the same thread.
+		Nat STORM_FN stackSize();
+		void STORM_ASSIGN stackSize(Nat size);
+
+		// Get statistics about the scheduling and I/O activity of this thread. For pools, the
+		// statistics of all threads in the pool are added together.
+		ThreadStats STORM_FN stats();
+
 #ifdef STORM_COMPILER
 		/**
 		 * Allow stand-alone allocation of the first Thread.
@@ -71,6 +91,17 @@ namespace storm {
 	};
 
 
+	// Default size of UThread stacks.
+	Nat STORM_FN defaultStackSize();
+
+	// A smaller size of UThread stacks, suitable for UThreads that mostly wait for I/O.
+	Nat STORM_FN smallStackSize();
+
+	// Total amount of memory allocated for UThread stacks in the process, including memory kept for
+	// re-use.
+	Word STORM_FN stackMemory();
+
+
 	/**
 	 * The main thread of the compiler.
 	 *
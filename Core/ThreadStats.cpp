@@ -0,0 +1,43 @@
+#include "stdafx.h"
+#include "ThreadStats.h"
+#include "StrBuf.h"
+#include "OS/ThreadStats.h"
+
+namespace storm {
+
+	ThreadStats::ThreadStats()
+		: alive(0), ready(0), switches(0), idleWaits(0),
+		  ioRequests(0), ioReads(0), ioWrites(0), crossCalls(0) {}
+
+	ThreadStats::ThreadStats(const os::ThreadStats &s)
+		: alive(Nat(s.alive)), ready(Nat(s.ready)), switches(s.switches), idleWaits(s.idleWaits), idle(Long(s.idleUs)),
+		  ioRequests(s.ioRequests), ioReads(s.ioReads), ioWrites(s.ioWrites),
+		  crossCalls(s.crossCalls), crossCallTime(Long(s.crossCallUs)) {}
+
+	Duration ThreadStats::crossCallLatency() const {
+		if (crossCalls == 0)
+			return Duration();
+		return Duration(crossCallTime.v / Long(crossCalls));
+	}
+
+	void ThreadStats::toS(StrBuf *to) const {
+		*to << S("alive: ") << alive << S(", ready: ") << ready << S(", switches: ") << switches;
+		*to << S(", idle: ") << idle << S(" (") << idleWaits << S(" waits)");
+		*to << S(", I/O: ") << ioRequests << S(" (") << ioReads << S(" reads, ") << ioWrites << S(" writes)");
+		*to << S(", calls: ") << crossCalls << S(" (") << crossCallLatency() << S(" avg)");
+	}
+
+	ThreadStats operator -(ThreadStats a, ThreadStats b) {
+		ThreadStats r = a;
+		r.switches -= b.switches;
+		r.idleWaits -= b.idleWaits;
+		r.idle = a.idle - b.idle;
+		r.ioRequests -= b.ioRequests;
+		r.ioReads -= b.ioReads;
+		r.ioWrites -= b.ioWrites;
+		r.crossCalls -= b.crossCalls;
+		r.crossCallTime = a.crossCallTime - b.crossCallTime;
+		return r;
+	}
+
+}
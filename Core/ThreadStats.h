@@ -0,0 +1,64 @@
+#pragma once
+#include "Timing.h"
+
+namespace os {
+	class ThreadStats;
+}
+
+namespace storm {
+	STORM_PKG(core);
+
+	/**
+	 * Statistics about the scheduling and I/O activity of a thread. Retrieved by calling `stats`
+	 * on a `Thread`.
+	 *
+	 * Apart from `alive` and `ready`, all values are accumulated from when the thread was started.
+	 * Subtract two snapshots to get the activity during a period of time.
+	 */
+	class ThreadStats {
+		STORM_VALUE;
+	public:
+		// Create, all values are zero.
+		STORM_CTOR ThreadStats();
+
+		// Create from OS statistics.
+		ThreadStats(const os::ThreadStats &stats);
+
+		// Number of UThreads alive on the thread.
+		Nat alive;
+
+		// Number of UThreads that are ready to run, i.e. the length of the run queue.
+		Nat ready;
+
+		// Number of context switches between UThreads.
+		Word switches;
+
+		// Number of times the thread had nothing to do and waited for more work or for I/O.
+		Word idleWaits;
+
+		// Total time spent waiting.
+		Duration idle;
+
+		// Number of I/O requests issued. On some systems, the requests are also divided into reads
+		// and writes.
+		Word ioRequests;
+		Word ioReads;
+		Word ioWrites;
+
+		// Number of calls from other threads that were executed by this thread.
+		Word crossCalls;
+
+		// Total time from calls from other threads were made until they completed.
+		Duration crossCallTime;
+
+		// Average time for calls from other threads.
+		Duration STORM_FN crossCallLatency() const;
+
+		// To string.
+		void STORM_FN toS(StrBuf *to) const;
+	};
+
+	// Compute the difference between two snapshots. `alive` and `ready` are taken from `a`.
+	ThreadStats STORM_FN operator -(ThreadStats a, ThreadStats b);
+
+}
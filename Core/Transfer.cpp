@@ -0,0 +1,78 @@
+#include "stdafx.h"
+#include "Transfer.h"
+#include "StrBuf.h"
+#include "Exception.h"
+#include "OS/UThread.h"
+
+namespace storm {
+
+	// States of the slot.
+	static const size_t slotEmpty = 0;
+	static const size_t slotFull = 1;
+	// Another thread is copying an element to or from the slot.
+	static const size_t slotBusy = 2;
+
+	TransferBase::TransferBase(const Handle &type) : handle(type) {
+		slot = runtime::allocArray<byte>(engine(), type.gcArrayType, 1);
+		slot->filled = slotEmpty;
+	}
+
+	TransferBase::TransferBase(const TransferBase &other) : handle(other.handle), slot(other.slot) {}
+
+	void TransferBase::deepCopy(CloneEnv *env) {
+		// Nothing to do, all copies refer to the same slot.
+	}
+
+	Bool TransferBase::any() const {
+		return atomicRead(slot->filled) != slotEmpty;
+	}
+
+	size_t TransferBase::acquire(size_t from) {
+		while (true) {
+			size_t old = atomicCAS(slot->filled, from, slotBusy);
+			if (old != slotBusy)
+				return old;
+
+			// Copying an element is quick, so the other thread is done soon.
+			os::UThread::leave();
+		}
+	}
+
+	void TransferBase::takeRaw(void *to) {
+		if (acquire(slotFull) != slotFull)
+			throw new (this) UsageError(S("Attempted to take the contents of an empty Transfer. ")
+										S("The contents were likely taken by another thread."));
+
+		try {
+			handle.safeCopy(to, slot->v);
+		} catch (...) {
+			atomicWrite(slot->filled, slotFull);
+			throw;
+		}
+		handle.safeDestroy(slot->v);
+		memset(slot->v, 0, handle.size);
+		atomicWrite(slot->filled, slotEmpty);
+	}
+
+	void TransferBase::putRaw(const void *value) {
+		if (acquire(slotEmpty) != slotEmpty)
+			throw new (this) UsageError(S("Attempted to put an element into a Transfer that is not empty. ")
+										S("Take the old element first."));
+
+		try {
+			handle.safeCopy(slot->v, value);
+		} catch (...) {
+			atomicWrite(slot->filled, slotEmpty);
+			throw;
+		}
+		atomicWrite(slot->filled, slotFull);
+	}
+
+	void TransferBase::toS(StrBuf *to) const {
+		if (any())
+			*to << S("Transfer(<full>)");
+		else
+			*to << S("Transfer(<empty>)");
+	}
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "Object.h"
+#include "Handle.h"
+#include "GcArray.h"
+
+namespace storm {
+	STORM_PKG(core);
+
+	/**
+	 * Base class for Transfer<T>.
+	 *
+	 * A Transfer<T> is a slot that holds at most one element, and that is used to pass elements
+	 * between threads without copying them. Parameters to calls between threads are usually deep
+	 * copied, which is expensive for large objects such as arrays or buffers. Like Future and
+	 * Channel, copies of a Transfer<T> refer to the same slot, so a Transfer<T> is passed to other
+	 * threads in constant time regardless of its contents.
+	 *
+	 * The move is explicit: the sender calls 'put' to store an element in the slot, and the
+	 * receiver calls 'take' to remove it. Only one of them owns the element at any time: 'take'
+	 * throws if the slot is empty (e.g. because another thread already took the element), and
+	 * 'put' throws if the slot already contains an element. Copying the Transfer<T> itself (e.g.
+	 * using 'clone') does not affect the element.
+	 *
+	 * Note that the sender must not retain any other references to the element after calling
+	 * 'put', as the two threads would share the element otherwise.
+	 */
+	class TransferBase : public Object {
+		STORM_CLASS;
+	public:
+		// Create an empty instance.
+		TransferBase(const Handle &type);
+
+		// Copy. Refers to the same slot.
+		TransferBase(const TransferBase &other);
+
+		// Deep copy. Does nothing, as all copies refer to the same slot.
+		virtual void STORM_FN deepCopy(CloneEnv *env);
+
+		// Contains an element?
+		Bool STORM_FN any() const;
+
+		// Empty?
+		inline Bool STORM_FN empty() const { return !any(); }
+
+		// Remove the element and copy it to the uninitialized memory at 'to'. Throws if empty.
+		void CODECALL takeRaw(void *to);
+
+		// Store an element. Throws if the slot already contains an element.
+		void CODECALL putRaw(const void *value);
+
+		// To string.
+		virtual void STORM_FN toS(StrBuf *to) const;
+
+	private:
+		// Handle for the contained type.
+		const Handle &handle;
+
+		// The slot. Contains one element. 'filled' of the array is the state of the slot (empty,
+		// full or busy). The state is modified atomically, so that copies of the Transfer may be
+		// used from different threads.
+		GcArray<byte> *slot;
+
+		// Change the state of the slot from 'from' to busy. Returns the state that was found
+		// instead if the state was not 'from'. Waits while another thread keeps the slot busy.
+		size_t acquire(size_t from);
+	};
+
+	// Declare the template in Storm.
+	STORM_TEMPLATE(Transfer, createTransfer);
+
+	/**
+	 * Class used from C++.
+	 */
+	template <class T>
+	class Transfer : public TransferBase {
+		STORM_SPECIAL;
+	public:
+		// Get the Storm type for this object.
+		static Type *stormType(Engine &e) {
+			return runtime::cppTemplate(e, TransferId, 1, StormInfo<T>::id());
+		}
+
+		// Empty.
+		Transfer() : TransferBase(StormInfo<T>::handle(engine())) {
+			runtime::setVTable(this);
+		}
+
+		// Containing 'value'.
+		Transfer(T value) : TransferBase(StormInfo<T>::handle(engine())) {
+			runtime::setVTable(this);
+			putRaw(&value);
+		}
+
+		// Copy.
+		Transfer(const Transfer &o) : TransferBase(o) {
+			runtime::setVTable(this);
+		}
+
+		// Take the contained element.
+		T take() {
+			byte data[sizeof(T)];
+			takeRaw(data);
+			T r = *(T *)data;
+			((T *)data)->~T();
+			return r;
+		}
+
+		// Store an element.
+		void put(T value) {
+			putRaw(&value);
+		}
+	};
+
+}
@@ -2,7 +2,6 @@
 #include "WeakSet.h"
 #include "GcType.h"
 #include "GcWatch.h"
-#include "Hash.h"
 #include "StrBuf.h"
 #include "Utils/Bitwise.h"
 
@@ -19,14 +18,31 @@ namespace storm {
 		{},
 	};
 
-	WeakSetBase::WeakSetBase() : watch(runtime::createWatch(engine())) {}
+	WeakSetBase::WeakSetBase() : watch(newWatch()) {}
 
 	WeakSetBase::WeakSetBase(const WeakSetBase &other) {
 		size = other.size;
 		lastFree = other.lastFree;
 		info = copyArray(other.info);
 		data = copyArray(other.data);
-		watch = other.watch->clone();
+		watch = other.watch ? other.watch->clone() : null;
+
+		// We contain the same objects as 'other'.
+		if (!watch)
+			for (nat i = 0; i < capacity(); i++)
+				if (info->v[i].status != Info::free && data->v[i])
+					runtime::storeIdentityHash(engine(), data->v[i]);
+	}
+
+	GcWatch *WeakSetBase::newWatch() {
+		// We don't need to watch objects if their hashes don't change when they move.
+		if (runtime::stableIdentityHash(engine()))
+			return null;
+		return runtime::createWatch(engine());
+	}
+
+	nat WeakSetBase::hashOf(TObject *key) {
+		return runtime::identityHash(engine(), key);
 	}
 
 	void WeakSetBase::deepCopy(CloneEnv *env) {
@@ -34,11 +50,20 @@ namespace storm {
 	}
 
 	void WeakSetBase::clear() {
+		if (!watch)
+			for (nat i = 0; i < capacity(); i++)
+				if (info->v[i].status != Info::free && data->v[i])
+					runtime::releaseIdentityHash(engine(), data->v[i]);
+		reset();
+	}
+
+	void WeakSetBase::reset() {
 		info = null;
 		data = null;
 		size = 0;
 		lastFree = 0;
-		watch->clear();
+		if (watch)
+			watch->clear();
 	}
 
 	void WeakSetBase::shrink() {
@@ -77,13 +102,16 @@ namespace storm {
 	Bool WeakSetBase::putRaw(TObject *key) {
 		clean();
 
-		nat hash = ptrHash(key);
+		nat hash = hashOf(key);
 		nat old = findSlot(key, hash);
 		if (old == Info::free) {
 			if (watch) {
 				// In case the object moved, we need to re-compute the hash.
 				watch->add(key);
-				hash = ptrHash(key);
+				hash = hashOf(key);
+			} else {
+				// Make sure the hash stays the same if the object moves.
+				hash = runtime::storeIdentityHash(engine(), key);
 			}
 			nat w = Info::free;
 			insert(key, hash, w);
@@ -97,7 +125,7 @@ namespace storm {
 	Bool WeakSetBase::hasRaw(TObject *key) {
 		clean();
 
-		nat hash = ptrHash(key);
+		nat hash = hashOf(key);
 		return findSlot(key, hash) != Info::free;
 	}
 
@@ -119,7 +147,7 @@ namespace storm {
 	}
 
 	bool WeakSetBase::remove(TObject *key) {
-		nat hash = ptrHash(key);
+		nat hash = hashOf(key);
 		nat slot = primarySlot(hash);
 
 		// Not in the map?
@@ -140,6 +168,8 @@ namespace storm {
 				// Destroy the node.
 				info->v[slot].status = Info::free;
 				data->v[slot] = null;
+				if (!watch)
+					runtime::releaseIdentityHash(engine(), key);
 
 				if (prev == Info::free && next != Info::end) {
 					// The removed node was in the primary slot, and we need to move the next one into our slot.
@@ -230,7 +260,7 @@ namespace storm {
 
 		GcArray<Info> *oldInfo = info; info = null;
 		GcWeakArray<TObject> *oldData = data; data = null;
-		GcWatch *oldWatch = watch; watch = runtime::createWatch(engine());
+		GcWatch *oldWatch = watch; watch = newWatch();
 
 		alloc(cap);
 
@@ -247,14 +277,15 @@ namespace storm {
 				if (oldInfo->v[i].status == Info::free || k == null)
 					continue;
 
-				watch->add(k);
-				nat hash = ptrHash(k);
+				if (watch)
+					watch->add(k);
+				nat hash = hashOf(k);
 				insert(k, hash, w);
 			}
 
 			// The Gc will destroy the old arrays and all elements in there later on.
 		} catch (...) {
-			clear();
+			reset();
 
 			// Restore old state.
 			swap(oldSize, size);
@@ -270,7 +301,7 @@ namespace storm {
 
 		GcArray<Info> *oldInfo = info; info = null;
 		GcWeakArray<TObject> *oldData = data; data = null;
-		GcWatch *oldWatch = watch; watch = runtime::createWatch(engine());
+		GcWatch *oldWatch = watch; watch = newWatch();
 
 		allocRehash(cap);
 
@@ -289,8 +320,9 @@ namespace storm {
 					continue;
 
 				// We need to re-hash here, as some objects have moved.
-				watch->add(k);
-				nat hash = ptrHash(k);
+				if (watch)
+					watch->add(k);
+				nat hash = hashOf(k);
 				nat into = insert(k, hash, found);
 
 				// Is this the key we're looking for?
@@ -301,7 +333,7 @@ namespace storm {
 			// The Gc will destroy the old arrays and all elements in there later on.
 			return found;
 		} catch (...) {
-			clear();
+			reset();
 
 			// Restore old state.
 			swap(oldSize, size);
@@ -317,7 +349,7 @@ namespace storm {
 
 		GcArray<Info> *oldInfo = info; info = null;
 		GcWeakArray<TObject> *oldData = data; data = null;
-		GcWatch *oldWatch = watch; watch = runtime::createWatch(engine());
+		GcWatch *oldWatch = watch; watch = newWatch();
 
 		allocRehash(cap);
 
@@ -344,15 +376,16 @@ namespace storm {
 				}
 
 				// We need to re-hash here, as some objects have moved.
-				watch->add(k);
-				nat hash = ptrHash(k);
+				if (watch)
+					watch->add(k);
+				nat hash = hashOf(k);
 				insert(k, hash, w);
 			}
 
 			// The Gc will destroy the old arrays and all elements in there later on.
 			return found;
 		} catch (...) {
-			clear();
+			reset();
 
 			// Restore old state.
 			swap(oldSize, size);
@@ -107,9 +107,15 @@ namespace storm {
 		GcArray<Info> *info;
 		GcWeakArray<TObject> *data;
 
-		// Watch out for moving objects.
+		// Watch out for moving objects. Null if the hashes of objects are not affected by moving them.
 		GcWatch *watch;
 
+		// Create a watch if needed.
+		GcWatch *newWatch();
+
+		// Compute the hash of an object.
+		nat hashOf(TObject *key);
+
 		// Allocate data for a specific capacity. Assumes 'info', 'key' and 'value' are null.
 		void alloc(nat capacity);
 
@@ -154,6 +160,9 @@ namespace storm {
 		// Clean splatted references if needed.
 		void clean();
 
+		// Remove all elements without telling the GC.
+		void reset();
+
 		// Helper for copying arrays.
 		GcArray<Info> *copyArray(const GcArray<Info> *src);
 		GcWeakArray<TObject> *copyArray(const GcWeakArray<TObject> *src);
@@ -0,0 +1,208 @@
+#include "stdafx.h"
+#include "AllocProfiler.h"
+#include "Gc.h"
+#include "Utils/StackInfoSet.h"
+
+namespace storm {
+
+	// Number of bytes until the next sample for the current thread. Zero if not yet initialized.
+	static THREAD size_t untilSample = 0;
+
+	// State of the random number generator for the current thread.
+	static THREAD nat randomState = 0;
+
+	// Pick the distance to the next sample, uniformly in [interval/2, interval*3/2).
+	static size_t nextDistance(size_t interval) {
+		if (randomState == 0)
+			randomState = nat(size_t(&untilSample)) | 1;
+
+		// Xorshift.
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+
+		return interval / 2 + randomState % max(interval, size_t(1)) + 1;
+	}
+
+	/**
+	 * Collect the topmost frames of a stack trace without allocating memory.
+	 */
+	class SampleTrace : public TraceGen {
+	public:
+		SampleTrace() : count(0) {}
+
+		StackFrame frames[AllocProfiler::maxFrames];
+		nat count;
+
+		virtual void init(size_t) {}
+
+		virtual void put(const StackFrame &frame) {
+			if (count < AllocProfiler::maxFrames)
+				frames[count++] = frame;
+		}
+	};
+
+	AllocProfiler::AllocProfiler(Gc &owner)
+		: owner(owner), interval(0), siteData(null), siteTypes(null), typeRoot(null),
+		  siteFrames(null), usedSites(0), siteIndex(null), droppedSamples(0) {}
+
+	AllocProfiler::~AllocProfiler() {
+		destroy();
+	}
+
+	void AllocProfiler::destroy() {
+		stop();
+		clear();
+	}
+
+	void AllocProfiler::start(size_t interval) {
+		if (interval == 0) {
+			stop();
+			return;
+		}
+
+		{
+			util::Lock::L z(lock);
+			if (!siteData) {
+				siteData = new SiteData[maxSites];
+				siteTypes = new Type *[maxSites];
+				siteFrames = new StackFrame[maxSites * maxFrames];
+				siteIndex = new nat[maxSites * 2];
+
+				memset(siteTypes, 0, sizeof(Type *) * maxSites);
+				memset(siteIndex, 0, sizeof(nat) * maxSites * 2);
+				typeRoot = owner.createRoot(siteTypes, maxSites);
+				stackInfo().alloc(siteFrames, maxSites * maxFrames);
+			}
+		}
+
+		atomicWrite(this->interval, interval);
+	}
+
+	void AllocProfiler::stop() {
+		atomicWrite(interval, size_t(0));
+	}
+
+	void AllocProfiler::clear() {
+		util::Lock::L z(lock);
+		if (!siteData)
+			return;
+
+		Gc::destroyRoot(typeRoot);
+		stackInfo().free(siteFrames, maxSites * maxFrames);
+
+		delete []siteData;
+		delete []siteTypes;
+		delete []siteFrames;
+		delete []siteIndex;
+
+		siteData = null;
+		siteTypes = null;
+		siteFrames = null;
+		siteIndex = null;
+		typeRoot = null;
+		usedSites = 0;
+		droppedSamples = 0;
+	}
+
+	void AllocProfiler::count(const GcType *type, size_t size) {
+		size_t now = interval;
+		if (untilSample == 0)
+			untilSample = nextDistance(now);
+
+		if (untilSample > size) {
+			untilSample -= size;
+			return;
+		}
+
+		untilSample = nextDistance(now);
+		sample(type, max(size, now));
+	}
+
+	void AllocProfiler::sample(const GcType *type, size_t bytes) {
+		// Skip 'sample' and 'count'.
+		SampleTrace trace;
+		createStackTrace(trace, 2);
+
+		util::Lock::L z(lock);
+		if (!siteData)
+			return;
+
+		SiteData *site = findSite(type ? type->type : null, trace.frames, trace.count);
+		if (!site) {
+			droppedSamples++;
+			return;
+		}
+
+		site->samples++;
+		site->bytes += bytes;
+	}
+
+	static inline nat mix(nat hash, size_t value) {
+		return (hash ^ nat(value) ^ nat(value >> 16)) * 16777619;
+	}
+
+	AllocProfiler::SiteData *AllocProfiler::findSite(Type *type, const StackFrame *frames, nat count) {
+		nat hash = mix(2166136261u, size_t(type));
+		for (nat i = 0; i < count; i++)
+			hash = mix(mix(hash, size_t(frames[i].fnBase)), frames[i].offset);
+
+		nat mask = maxSites * 2 - 1;
+		nat slot = hash & mask;
+		while (siteIndex[slot]) {
+			nat id = siteIndex[slot] - 1;
+			SiteData &site = siteData[id];
+			if (site.hash == hash && site.frames == count && siteTypes[id] == type) {
+				const StackFrame *other = siteFrames + id * maxFrames;
+				bool same = true;
+				for (nat i = 0; i < count && same; i++)
+					same = other[i].fnBase == frames[i].fnBase && other[i].offset == frames[i].offset;
+				if (same)
+					return &site;
+			}
+			slot = (slot + 1) & mask;
+		}
+
+		if (usedSites >= maxSites)
+			return null;
+
+		nat id = usedSites++;
+		SiteData &site = siteData[id];
+		site.samples = 0;
+		site.bytes = 0;
+		site.frames = count;
+		site.hash = hash;
+		siteTypes[id] = type;
+		for (nat i = 0; i < count; i++)
+			siteFrames[id * maxFrames + i] = frames[i];
+		siteIndex[slot] = id + 1;
+		return &site;
+	}
+
+	nat AllocProfiler::siteCount() {
+		util::Lock::L z(lock);
+		return usedSites;
+	}
+
+	bool AllocProfiler::site(nat id, Site &out) {
+		util::Lock::L z(lock);
+		if (id >= usedSites)
+			return false;
+
+		const SiteData &data = siteData[id];
+		out.type = siteTypes[id];
+		out.frameCount = data.frames;
+		out.samples = data.samples;
+		out.bytes = data.bytes;
+		for (nat i = 0; i < data.frames; i++)
+			out.frames[i] = siteFrames[id * maxFrames + i];
+
+		return true;
+	}
+
+	size_t AllocProfiler::dropped() {
+		util::Lock::L z(lock);
+		return droppedSamples;
+	}
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include "Core/GcType.h"
+#include "Utils/Lock.h"
+#include "Utils/StackTrace.h"
+#include "Root.h"
+
+namespace storm {
+
+	class Gc;
+
+	/**
+	 * Sampling allocation profiler.
+	 *
+	 * When enabled, one allocation is sampled approximately every 'interval' bytes. For each
+	 * sampled allocation, a stack trace is captured and the sample is attributed to the type of
+	 * the allocation and the call site (i.e. the topmost frames of the stack trace). Each sample
+	 * is taken to represent 'interval' bytes of allocations, or the size of the allocation if it
+	 * is larger than that.
+	 *
+	 * The number of bytes until the next sample is kept per thread, so the only cost for
+	 * allocations that are not sampled is decrementing a counter. To avoid bias, the distance
+	 * between samples is varied randomly around 'interval'.
+	 *
+	 * All storage needed is allocated when the profiler is started. The stack frames of the call
+	 * sites are registered with the StackInfo machinery, and the types are stored in a root, so
+	 * that code and types referred to by samples are kept alive while the profiler refers to
+	 * them. If the number of distinct call sites exceeds the storage, additional samples are only
+	 * counted in 'dropped'.
+	 */
+	class AllocProfiler : NoCopy {
+	public:
+		// Create. Disabled initially.
+		AllocProfiler(Gc &owner);
+
+		// Destroy.
+		~AllocProfiler();
+
+		// Max number of call sites remembered.
+		static const nat maxSites = 1024;
+
+		// Max number of frames remembered for each call site.
+		static const nat maxFrames = 12;
+
+		// Is profiling enabled?
+		inline bool enabled() const { return interval != 0; }
+
+		// Start sampling approximately every 'interval' bytes. Keeps any previous samples.
+		void start(size_t interval);
+
+		// Stop sampling. Keeps any samples.
+		void stop();
+
+		// Remove all samples, and release the storage for them.
+		void clear();
+
+		// Called after an allocation of 'size' bytes of type 'type'.
+		inline void allocated(const GcType *type, size_t size) {
+			if (interval)
+				count(type, size);
+		}
+
+		/**
+		 * A call site in the report. Instances of this class contain pointers to GC memory that
+		 * are not scanned exactly, so they should only be stored on the stack.
+		 */
+		class Site {
+		public:
+			// Type of the allocations. May be null if the type is not known.
+			Type *type;
+
+			// Topmost frames of the stack trace of the call site.
+			StackFrame frames[maxFrames];
+			nat frameCount;
+
+			// Number of samples.
+			size_t samples;
+
+			// Estimated number of bytes allocated.
+			size_t bytes;
+		};
+
+		// Get the number of call sites seen so far. Sites are never removed until 'clear' is called.
+		nat siteCount();
+
+		// Get a call site. Returns false if 'id' is out of range.
+		bool site(nat id, Site &out);
+
+		// Number of samples that could not be attributed to a call site due to lack of space.
+		size_t dropped();
+
+		// Dispose of all resources before the GC is destroyed.
+		void destroy();
+
+	private:
+		// Owning GC.
+		Gc &owner;
+
+		// Current interval. Zero if disabled.
+		size_t interval;
+
+		// Lock for the data below.
+		util::Lock lock;
+
+		// Data for a call site.
+		struct SiteData {
+			size_t samples;
+			size_t bytes;
+			nat frames;
+			nat hash;
+		};
+
+		// Call sites. Allocated when profiling starts.
+		SiteData *siteData;
+
+		// Types for each site. Scanned by 'typeRoot'.
+		Type **siteTypes;
+		GcRoot *typeRoot;
+
+		// Frames for all sites. 'maxFrames' entries for each site. Registered with StackInfo.
+		StackFrame *siteFrames;
+
+		// Number of used sites.
+		nat usedSites;
+
+		// Index of sites, to quickly find them. Open addressing, contains indices plus one.
+		nat *siteIndex;
+
+		// Number of dropped samples.
+		size_t droppedSamples;
+
+		// Count an allocation, take a sample if needed.
+		void count(const GcType *type, size_t size);
+
+		// Take a sample.
+		void sample(const GcType *type, size_t size);
+
+		// Find or create a site.
+		SiteData *findSite(Type *type, const StackFrame *frames, nat count);
+	};
+
+}
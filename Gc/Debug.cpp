@@ -3,6 +3,7 @@
 
 #if STORM_GC == STORM_GC_DEBUG
 #include "Gc.h"
+#include "Core/Hash.h"
 #include "Format.h"
 
 namespace storm {
@@ -155,7 +156,7 @@ namespace storm {
 		return false;
 	}
 
-	GcImpl::GcImpl(size_t, nat) {}
+	GcImpl::GcImpl(size_t, nat, const GcParams &) {}
 
 	void GcImpl::destroy() {}
 
@@ -174,6 +175,16 @@ namespace storm {
 		return false;
 	}
 
+	Nat GcImpl::collections() {
+		return 0;
+	}
+
+	GcParams GcImpl::params() {
+		return GcParams();
+	}
+
+	void GcImpl::params(const GcParams &) {}
+
 	GcImpl::ThreadData GcImpl::attachThread() {
 		return 0;
 	}
@@ -270,6 +281,10 @@ namespace storm {
 		// Nothing to do...
 	}
 
+	Bool GcImpl::inHeap(const void *addr) {
+		return false;
+	}
+
 	GcImpl::Root *GcImpl::createRoot(void *data, size_t count, bool ambiguous) {
 		// No roots here!
 		return null;
@@ -293,6 +308,25 @@ namespace storm {
 		return new MallocWatch();
 	}
 
+	Bool GcImpl::stableIdentityHash() {
+		// Objects never move.
+		return true;
+	}
+
+	Nat GcImpl::identityHash(const void *obj) {
+		return ptrHash(obj);
+	}
+
+	Nat GcImpl::storeIdentityHash(const void *obj) {
+		return ptrHash(obj);
+	}
+
+	void GcImpl::releaseIdentityHash(const void *) {}
+
+	GcTelemetry *GcImpl::telemetry() {
+		return null;
+	}
+
 	void GcImpl::checkMemory() {}
 
 	void GcImpl::checkMemory(const void *, bool) {}
@@ -5,6 +5,8 @@
 
 #include "Gc/License.h"
 #include "MemorySummary.h"
+#include "GcParams.h"
+#include "Telemetry.h"
 
 namespace storm {
 
@@ -19,7 +21,7 @@ namespace storm {
 	class GcImpl {
 	public:
 		// Create.
-		GcImpl(size_t initialArenaSize, Nat finalizationInterval);
+		GcImpl(size_t initialArenaSize, Nat finalizationInterval, const GcParams &params);
 
 		// Destroy. This function is always called, but may be called twice.
 		void destroy();
@@ -33,6 +35,13 @@ namespace storm {
 		// Spend approx. 'time' ms on a GC. Return 'true' if there is more work to be done.
 		Bool collect(Nat time);
 
+		// Number of collections performed so far.
+		Nat collections();
+
+		// Get/set tuning parameters.
+		GcParams params();
+		void params(const GcParams &params);
+
 		// Type we use to store data with a thread (we don't care).
 		typedef Nat ThreadData;
 
@@ -93,6 +102,9 @@ namespace storm {
 		typedef void (*WalkCb)(RootObject *inspect, void *param);
 		void walkObjects(WalkCb fn, void *param);
 
+		// Is 'addr' inside memory managed by this GC? Safe to call from inside 'walkObjects'.
+		Bool inHeap(const void *addr);
+
 		struct Root;
 
 		// Create a root object.
@@ -104,6 +116,21 @@ namespace storm {
 		// Create a watch object (on a GC:d heap, no need to destroy it).
 		GcWatch *createWatch();
 
+		// Are identity hashes stable, i.e. unaffected by objects moving?
+		Bool stableIdentityHash();
+
+		// Get the identity hash of an object.
+		Nat identityHash(const void *obj);
+
+		// Get the identity hash of an object, and keep it stable when the object moves.
+		Nat storeIdentityHash(const void *obj);
+
+		// Tell the GC that a container no longer contains 'obj'.
+		void releaseIdentityHash(const void *obj);
+
+		// Get telemetry about collections, or null if not supported.
+		GcTelemetry *telemetry();
+
 		// Check memory consistency. Note: Enable checking in 'Gc.cpp' for this to work.
 		void checkMemory();
 		void checkMemory(const void *object, bool recursive);
@@ -20,14 +20,14 @@ namespace storm {
 	}
 
 	struct ImplWrap : public GcImpl {
-		ImplWrap(Gc &owner, size_t initialArena, nat finalizationInterval)
-			: GcImpl(initialArena, finalizationInterval), owner(owner) {}
+		ImplWrap(Gc &owner, size_t initialArena, nat finalizationInterval, const GcParams &params)
+			: GcImpl(initialArena, finalizationInterval, params), owner(owner) {}
 
 		Gc &owner;
 	};
 
-	Gc::Gc(size_t initialArena, nat finalizationInterval)
-		: impl(new ImplWrap(*this, initialArena, finalizationInterval)), destroyed(false) {
+	Gc::Gc(size_t initialArena, nat finalizationInterval, const GcParams &params)
+		: profiler(*this), impl(new ImplWrap(*this, initialArena, finalizationInterval, params)), destroyed(false) {
 #ifdef STORM_GC_EH_CALLBACK
 		ehCallback = null;
 #endif
@@ -51,6 +51,9 @@ namespace storm {
 			threads.clear();
 		}
 
+		// The profiler owns roots, release them properly.
+		profiler.destroy();
+
 		{
 			// If there are any roots registered now, we destroy them before shutdown as
 			// implementations are a bit picky about having all roots unregistered before
@@ -85,6 +88,18 @@ namespace storm {
 		return impl->collect(time);
 	}
 
+	Nat Gc::collections() {
+		return impl->collections();
+	}
+
+	GcParams Gc::params() {
+		return impl->params();
+	}
+
+	void Gc::params(const GcParams &params) {
+		impl->params(params);
+	}
+
 	void Gc::attachThread() {
 		os::Thread thread = os::Thread::current();
 		util::Lock::L z(threadLock);
@@ -184,6 +199,14 @@ namespace storm {
 		owner.impl->endRamp();
 	}
 
+	void Gc::startRamp() {
+		impl->startRamp();
+	}
+
+	void Gc::endRamp() {
+		impl->endRamp();
+	}
+
 	void Gc::walkObjects(WalkCb fn, void *param) {
 		impl->walkObjects(fn, param);
 	}
@@ -22,6 +22,9 @@
 
 // In case we're included from somewhere other than the Gc module.
 #include "License.h"
+#include "GcParams.h"
+#include "Telemetry.h"
+#include "AllocProfiler.h"
 #include "Format.h" // for fmt::wordAlign
 #include "SampleImpl.h"
 #include "Root.h"
@@ -69,7 +72,8 @@ namespace storm {
 		// 'initialArenaSize' - an initial estimate of the arena size. May be disregarded by the gc if needed.
 		// 'finalizationInterval' - how seldom the gc should check for finalizations. An interval of 500 means
 		//                          every 500 allocations.
-		Gc(size_t initialArenaSize, nat finalizationInterval);
+		// 'params' - tuning parameters for the gc.
+		Gc(size_t initialArenaSize, nat finalizationInterval, const GcParams &params = GcParams());
 
 		// Destroy.
 		~Gc();
@@ -91,6 +95,17 @@ namespace storm {
 		// Spend approx 'time' ms on an incremental collection if possible. Returns true if there is more to do.
 		bool collect(Nat time);
 
+		// Number of collections performed so far. For generational collectors, each collection of
+		// a generation is counted.
+		Nat collections();
+
+		// Get the current tuning parameters. If the sizes of generations are adapted at runtime,
+		// the current sizes are returned.
+		GcParams params();
+
+		// Set tuning parameters. Only the sizes of the existing generations may be changed.
+		void params(const GcParams &params);
+
 		// TODO: Add interface for managing pause times and getting information about allocations.
 
 
@@ -123,7 +138,9 @@ namespace storm {
 				|| type->kind == GcType::tFixedObj,
 				L"Wrong type for calling alloc().");
 
-			return impl->alloc(type);
+			void *result = impl->alloc(type);
+			profiler.allocated(type, type->stride);
+			return result;
 		}
 
 		// Allocate an object of a specific type in a non-moving pool. We assume that non-moving
@@ -134,7 +151,9 @@ namespace storm {
 				|| type->kind == GcType::tFixedObj,
 				L"Wrong type for calling allocStatic().");
 
-			return impl->allocStatic(type);
+			void *result = impl->allocStatic(type);
+			profiler.allocated(type, type->stride);
+			return result;
 		}
 
 		// Allocate a buffer which is not moving nor protected. The memory allocated from here is
@@ -147,7 +166,9 @@ namespace storm {
 		inline void *allocArray(const GcType *type, size_t count) {
 			assert(type->kind == GcType::tArray, L"Wrong type for calling allocArray().");
 
-			return impl->allocArray(type, count);
+			void *result = impl->allocArray(type, count);
+			profiler.allocated(type, type->stride * count);
+			return result;
 		}
 
 		// Allocate an array of objects in response to a stale location dependency that requires us
@@ -155,7 +176,9 @@ namespace storm {
 		inline void *allocArrayRehash(const GcType *type, size_t count) {
 			assert(type->kind == GcType::tArray, L"Wrong type for calling allocArray().");
 
-			return impl->allocArrayRehash(type, count);
+			void *result = impl->allocArrayRehash(type, count);
+			profiler.allocated(type, type->stride * count);
+			return result;
 		}
 
 		// Allocate an array of weak pointers.
@@ -252,6 +275,11 @@ namespace storm {
 			Gc &owner;
 		};
 
+		// Start and end a ramp allocation manually, for callers that can not use RampAlloc (e.g.
+		// Storm code). Calls may be nested, but must be balanced.
+		void startRamp();
+		void endRamp();
+
 
 		/**
 		 * Iterate through all objects on the heap.
@@ -268,6 +296,12 @@ namespace storm {
 		// Walk the heap. This usually incurs a full Gc, so it is not a cheap operation.
 		void walkObjects(WalkCb fn, void *param);
 
+		// Is 'addr' inside memory managed by the GC? May be called from inside the callback of a
+		// heap walk, for example to see if a pointer in an object refers to another allocation.
+		inline Bool inHeap(const void *addr) {
+			return impl->inHeap(addr);
+		}
+
 
 		/**
 		 * Roots.
@@ -317,6 +351,55 @@ namespace storm {
 		}
 
 
+		/**
+		 * Identity hashes.
+		 *
+		 * Hash containers keyed by object identity use these hashes. If 'stableIdentityHash'
+		 * returns false, the hash of an object may change when the object is moved, and containers
+		 * need to use a GcWatch to detect this. Otherwise, containers call 'storeIdentityHash'
+		 * when they insert an object, 'releaseIdentityHash' when they remove it, and
+		 * 'identityHash' for lookups. The hash of an object that
+		 * was never stored may change when it moves, which is fine since it is not in any
+		 * container.
+		 */
+
+		// Are identity hashes unaffected by objects moving?
+		inline Bool stableIdentityHash() {
+			return impl->stableIdentityHash();
+		}
+
+		// Get the identity hash of an object.
+		inline Nat identityHash(const void *obj) {
+			return impl->identityHash(obj);
+		}
+
+		// Get the identity hash of an object, and make sure it does not change when the object
+		// is moved. Returns the same hash as 'identityHash'.
+		inline Nat storeIdentityHash(const void *obj) {
+			return impl->storeIdentityHash(obj);
+		}
+
+		// Tell the GC that a container no longer contains 'obj'. Each call to
+		// 'storeIdentityHash' is balanced by a call to this function, unless the container dies.
+		inline void releaseIdentityHash(const void *obj) {
+			impl->releaseIdentityHash(obj);
+		}
+
+		// Get telemetry about collections, or null if the GC does not provide telemetry.
+		inline GcTelemetry *telemetry() {
+			return impl->telemetry();
+		}
+
+
+		/**
+		 * Allocation profiling.
+		 */
+
+		// Sampling allocation profiler. Allocations made through 'alloc', 'allocStatic' and
+		// 'allocArray' are reported to the profiler. Disabled until started.
+		AllocProfiler profiler;
+
+
 		/**
 		 * Exception handling.
 		 *
@@ -0,0 +1,37 @@
+#pragma once
+
+namespace storm {
+
+	/**
+	 * Parameters for tuning the garbage collector. GC implementations are free to ignore
+	 * parameters they do not support.
+	 */
+	class GcParams {
+	public:
+		// Create, using the defaults of the GC implementation.
+		GcParams() : adaptive(false), pauseTarget(0), workers(0) {}
+
+		// Approximate size of each generation in bytes, starting with the nursery. If empty, the
+		// default generations are used. The number of generations can only be decided when the GC
+		// is created.
+		vector<size_t> generations;
+
+		// Bounds on the number of elements in 'generations'. Collectors may support fewer
+		// generations than 'maxGenerations', but none support more.
+		static const nat minGenerations = 2;
+		static const nat maxGenerations = 16;
+
+		// Adapt the size of generations to the survival rate and the pause time of their
+		// collections.
+		bool adaptive;
+
+		// Target pause time for the adaptive policy, in microseconds. Zero means the default.
+		nat pauseTarget;
+
+		// Maximum number of threads used by each collection, including the collecting
+		// thread. Zero means the default. Note that tracing live objects only uses the
+		// collecting thread.
+		nat workers;
+	};
+
+}
@@ -0,0 +1,176 @@
+#include "stdafx.h"
+#include "HeapSnapshot.h"
+#include "Gc.h"
+
+namespace storm {
+
+	// Initial capacity of the table.
+	static const nat initialCapacity = 1024;
+
+	// Initial number of pointers to arrays.
+	static const size_t initialRefs = 16 * 1024;
+
+	HeapSnapshot::HeapSnapshot(Gc &gc)
+		: gc(gc), types(null), data(null), root(null), capacity(0), used(0), overflow(false),
+		  refs(null), refSlots(null), refRoot(null), refCapacity(0), refCount(0) {
+
+		// Only count reachable objects.
+		gc.collect();
+
+		nat size = initialCapacity;
+		size_t refSize = initialRefs;
+		while (true) {
+			allocTable(size, refSize);
+			gc.walkObjects(&HeapSnapshot::walk, this);
+
+			if (overflow)
+				size *= 2;
+			else if (refCount > refCapacity)
+				// We know how many we need now. Leave some room in case more objects are allocated.
+				refSize = refCount + refCount / 4;
+			else
+				break;
+		}
+
+		resolveRefs();
+
+		// Move all entries to the start of the table, so that they can be accessed by index.
+		nat to = 0;
+		for (nat i = 0; i < capacity; i++) {
+			if (data[i].count == 0)
+				continue;
+
+			types[to] = types[i];
+			data[to] = data[i];
+			to++;
+		}
+	}
+
+	HeapSnapshot::~HeapSnapshot() {
+		freeTable();
+	}
+
+	void HeapSnapshot::allocTable(nat size, size_t refSize) {
+		freeTable();
+
+		capacity = size;
+		used = 0;
+		overflow = false;
+
+		types = new Type *[capacity];
+		data = new Data[capacity];
+		memset(types, 0, sizeof(Type *) * capacity);
+		memset(data, 0, sizeof(Data) * capacity);
+		root = gc.createRoot(types, capacity);
+
+		refCapacity = refSize;
+		refCount = 0;
+		refs = new void *[refCapacity];
+		refSlots = new nat[refCapacity];
+		memset(refs, 0, sizeof(void *) * refCapacity);
+		refRoot = gc.createRoot(refs, refCapacity, true);
+	}
+
+	void HeapSnapshot::freeTable() {
+		Gc::destroyRoot(root);
+		delete []types;
+		delete []data;
+		Gc::destroyRoot(refRoot);
+		delete []refs;
+		delete []refSlots;
+
+		root = null;
+		types = null;
+		data = null;
+		capacity = 0;
+		used = 0;
+		refRoot = null;
+		refs = null;
+		refSlots = null;
+		refCapacity = 0;
+		refCount = 0;
+	}
+
+	void HeapSnapshot::resolveRefs() {
+		for (size_t i = 0; i < refCount; i++) {
+			void *ptr = refs[i];
+			if (!gc.inHeap(ptr))
+				continue;
+
+			const GcType *refType = Gc::typeOf(ptr);
+			if (refType && refType->kind == GcType::tArray)
+				data[refSlots[i]].retained += fmt::sizeArray(refType, ((GcArray<byte> *)ptr)->count);
+		}
+
+		// Release the objects.
+		Gc::destroyRoot(refRoot);
+		refRoot = null;
+	}
+
+	HeapSnapshot::Entry HeapSnapshot::at(nat id) const {
+		Entry result = { null, 0, 0, 0 };
+		if (id >= used)
+			return result;
+
+		result.type = types[id];
+		result.count = data[id].count;
+		result.bytes = data[id].bytes;
+		result.retained = data[id].retained;
+		return result;
+	}
+
+	void HeapSnapshot::walk(RootObject *obj, void *param) {
+		((HeapSnapshot *)param)->add(obj);
+	}
+
+	void HeapSnapshot::add(RootObject *obj) {
+		if (overflow)
+			return;
+
+		const GcType *gcType = Gc::typeOf(obj);
+		if (!gcType)
+			return;
+
+		// Find the slot for this type.
+		Type *type = gcType->type;
+		nat mask = capacity - 1;
+		nat slot = nat((size_t(type) >> 4) ^ (size_t(type) >> 12)) & mask;
+		while (data[slot].count != 0 && types[slot] != type)
+			slot = (slot + 1) & mask;
+
+		if (data[slot].count == 0) {
+			// Keep the load factor at or below 1/2, so that lookups stay fast.
+			if (used >= capacity / 2) {
+				overflow = true;
+				return;
+			}
+
+			used++;
+			types[slot] = type;
+		}
+
+		size_t size = fmt::sizeObj(gcType);
+
+		// Record any objects referred to directly, so that the size of arrays can be added
+		// after the walk. The first offset of tFixedObj and tType does not refer to an
+		// allocation. If we run out of space, we keep counting to know how much we need.
+		size_t first = (gcType->kind == GcType::tFixed) ? 0 : 1;
+		for (size_t i = first; i < gcType->count; i++) {
+			void *ptr = *(void **)((byte *)obj + gcType->offset[i]);
+			if (!ptr)
+				continue;
+
+			if (refCount < refCapacity) {
+				refs[refCount] = ptr;
+				refSlots[refCount] = slot;
+			}
+			refCount++;
+		}
+
+		Data &d = data[slot];
+		d.count++;
+		d.bytes += size;
+		d.retained += size;
+	}
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "Root.h"
+
+namespace storm {
+
+	class Gc;
+	class Type;
+
+	/**
+	 * A snapshot of the live objects in the heap, aggregated per type.
+	 *
+	 * The snapshot is taken by performing a full collection followed by a heap walk. For each type
+	 * the number of objects, and the number of bytes used by the objects themselves is
+	 * recorded. Additionally, an estimate of the retained size is computed. It includes the size
+	 * of all arrays referred to directly by the objects (e.g. the storage of an Array or a Map),
+	 * since these are usually owned by the object. Arrays that are shared between multiple objects
+	 * are counted once for each object.
+	 *
+	 * The heap walk is not allowed to allocate memory, so the table used to aggregate the types is
+	 * allocated beforehand. If it turns out to be too small, the walk is repeated with a larger
+	 * table. The types are stored in a root, so that they are kept up to date during the lifetime
+	 * of the snapshot.
+	 *
+	 * The heap walk may only inspect the object it is currently visiting. Therefore, the pointers
+	 * that may refer to arrays are only recorded during the walk, in an ambiguous root so that
+	 * the objects they refer to stay in place. They are resolved after the walk.
+	 */
+	class HeapSnapshot : NoCopy {
+	public:
+		// Take a snapshot.
+		HeapSnapshot(Gc &gc);
+
+		// Destroy.
+		~HeapSnapshot();
+
+		/**
+		 * Information about a single type. Contains a pointer to GC memory, so it should only be
+		 * stored on the stack.
+		 */
+		class Entry {
+		public:
+			// The type. Null for objects without a type.
+			Type *type;
+
+			// Number of objects.
+			size_t count;
+
+			// Bytes used by the objects.
+			size_t bytes;
+
+			// Estimated retained size.
+			size_t retained;
+		};
+
+		// Number of types in the snapshot.
+		inline nat count() const { return used; }
+
+		// Get an entry.
+		Entry at(nat id) const;
+
+	private:
+		// Owning GC.
+		Gc &gc;
+
+		// Data for each type.
+		struct Data {
+			size_t count;
+			size_t bytes;
+			size_t retained;
+		};
+
+		// Hash table of types and their data. Open addressing, slots where 'count' is zero are
+		// empty. When the snapshot is complete, all entries are moved to the start of the
+		// table. 'types' is scanned by 'root'.
+		Type **types;
+		Data *data;
+		GcRoot *root;
+		nat capacity;
+
+		// Number of used slots.
+		nat used;
+
+		// Did the table overflow during the last walk?
+		bool overflow;
+
+		// Pointers that may refer to arrays retained by objects, and the slot of the type of
+		// the object that refers to them. 'refs' is scanned by 'refRoot'.
+		void **refs;
+		nat *refSlots;
+		GcRoot *refRoot;
+		size_t refCapacity;
+
+		// Number of pointers found during the last walk. May be larger than 'refCapacity'.
+		size_t refCount;
+
+		// Allocate the table.
+		void allocTable(nat capacity, size_t refCapacity);
+
+		// Add the size of arrays in 'refs' to the retained size of their types.
+		void resolveRefs();
+
+		// Free the table.
+		void freeTable();
+
+		// Callback for the heap walk.
+		static void walk(RootObject *obj, void *param);
+
+		// Add an object.
+		void add(RootObject *obj);
+	};
+
+}
@@ -13,6 +13,7 @@
 #include "OS/InlineSet.h"
 #include "Core/GcCode.h"
 #include "Core/Exception.h"
+#include "Core/Hash.h"
 #include "Utils/Memory.h"
 
 // Use debug pools in MPS (behaves slightly differently from the standard and may not trigger errors).
@@ -353,7 +354,8 @@ namespace storm {
 
 #endif
 
-	GcImpl::GcImpl(size_t initialArena, Nat finalizationInterval) : finalizationInterval(finalizationInterval) {
+	GcImpl::GcImpl(size_t initialArena, Nat finalizationInterval, const GcParams &params)
+		: finalizationInterval(finalizationInterval) {
 		// We work under these assumptions.
 		fmt::init();
 		assert(vtable::allocOffset() >= sizeof(void *), L"Invalid vtable offset (initialization failed?)");
@@ -382,10 +384,26 @@ namespace storm {
 		}
 #endif
 
-		// Note: we can use mps_arena_pause_time_set(arena, 0.0) to enforce minimal pause
-		// times. Default is 0.100 s, this should be configurable from Storm somehow.
+		// Note: The default pause time of the MPS is 0.100 s.
+		if (params.pauseTarget)
+			mps_arena_pause_time_set(arena, params.pauseTarget / 1000000.0);
 
-		check(mps_chain_create(&chain, arena, ARRAY_COUNT(generationParams), generationParams),
+		if (params.generations.empty()) {
+			generations.insert(generations.end(), generationParams, generationParams + ARRAY_COUNT(generationParams));
+		} else {
+			// The MPS measures the generations in KB. The mortality is only an initial guess.
+			for (size_t i = 0; i < params.generations.size(); i++) {
+				double mortality = 0.5;
+				if (i == 0)
+					mortality = 0.9;
+				else if (i + 1 == params.generations.size())
+					mortality = 0.1;
+				mps_gen_param_s gen = { max(params.generations[i] / 1024, size_t(1)), mortality };
+				generations.push_back(gen);
+			}
+		}
+
+		check(mps_chain_create(&chain, arena, generations.size(), &generations[0]),
 			S("Failed to set up generations."));
 
 		MPS_ARGS_BEGIN(args) {
@@ -439,7 +457,7 @@ namespace storm {
 		MPS_ARGS_BEGIN(args) {
 			MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
 			// Store types in the last generation, as they are very long-lived.
-			MPS_ARGS_ADD(args, MPS_KEY_GEN, ARRAY_COUNT(generationParams) - 1);
+			MPS_ARGS_ADD(args, MPS_KEY_GEN, generations.size() - 1);
 			MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
 			// We want to support ambiguous references to this pool (eg. from the stack).
 			MPS_ARGS_ADD(args, MPS_KEY_AMS_SUPPORT_AMBIGUOUS, true);
@@ -570,6 +588,34 @@ namespace storm {
 		return mps_arena_step(arena, time / 1000.0, 1) ? true : false;
 	}
 
+	Nat GcImpl::collections() {
+		return Nat(mps_collections(arena));
+	}
+
+	GcParams GcImpl::params() {
+		GcParams result;
+		for (size_t i = 0; i < generations.size(); i++)
+			result.generations.push_back(generations[i].mps_capacity * 1024);
+		result.pauseTarget = Nat(mps_arena_pause_time(arena) * 1000000.0);
+		return result;
+	}
+
+	void GcImpl::params(const GcParams &params) {
+		// The MPS does not allow modifying a chain after it has been created.
+		bool resized = params.generations.size() > generations.size();
+		for (size_t i = 0; i < params.generations.size() && i < generations.size(); i++)
+			resized |= max(params.generations[i] / 1024, size_t(1)) != generations[i].mps_capacity;
+		if (resized)
+			WARNING(L"The MPS can not change the size of generations after startup.");
+
+		if (params.adaptive)
+			WARNING(L"The MPS does not support adaptive generation sizes.");
+
+		// The pause target is the maximum duration of each increment of a collection.
+		if (params.pauseTarget)
+			mps_arena_pause_time_set(arena, params.pauseTarget / 1000000.0);
+	}
+
 	GcThread *GcImpl::attachThread() {
 		// Note: We will leak memory if "check" fails. This is rare enough that we don't care.
 		GcThread *desc = new GcThread;
@@ -1089,6 +1135,10 @@ namespace storm {
 		mps_arena_release(arena);
 	}
 
+	Bool GcImpl::inHeap(const void *addr) {
+		return mps_arena_has_addr(arena, (mps_addr_t)addr) ? true : false;
+	}
+
 	class MpsRoot : public GcRoot {
 	public:
 		mps_root_t root;
@@ -1364,6 +1414,25 @@ namespace storm {
 		return new (alloc(&MpsGcWatch::type)) MpsGcWatch(*this);
 	}
 
+	Bool GcImpl::stableIdentityHash() {
+		// The MPS moves objects, and does not let us keep track of them.
+		return false;
+	}
+
+	Nat GcImpl::identityHash(const void *obj) {
+		return ptrHash(obj);
+	}
+
+	Nat GcImpl::storeIdentityHash(const void *obj) {
+		return ptrHash(obj);
+	}
+
+	void GcImpl::releaseIdentityHash(const void *) {}
+
+	GcTelemetry *GcImpl::telemetry() {
+		return null;
+	}
+
 	static const GcLicense mpsLicense = {
 		S("MPS"),
 		S("BSD 2-clause license"),
@@ -113,6 +113,13 @@ namespace storm {
 				}
 			}
 
+			// Add all addresses in another set, covering the same range of addresses.
+			void add(const AddrSet &other) {
+				dbg_assert(data == other.data, L"Can only merge sets covering the same range.");
+				for (size_t i = 0; i < totalBytes; i++)
+					marked[i] |= other.marked[i];
+			}
+
 			// Test if an address is set.
 			bool has(const void *addr) const { return has(size_t(addr)); }
 			bool has(size_t addr) const {
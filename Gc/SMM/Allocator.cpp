@@ -36,14 +36,24 @@ namespace storm {
 		}
 
 		PendingAlloc Allocator::allocLarge(size_t size) {
-			// TODO: Allocate into a shared buffer inside a higher generation, rather than a single
-			// large buffer. This requires using a lock for that generation's buffer, since we share
-			// it with others.
-
 			Generation *into = owner.next;
 			if (!into)
 				into = &owner;
 
+			// Really large objects get a chunk of their own. Since nobody else uses that chunk,
+			// we don't need to hold a lock while the object is being initialized.
+			if (size >= largeObjectSize) {
+				Block *block = owner.arena.enter(*into, &Generation::allocLarge, size);
+				if (!block)
+					return PendingAlloc();
+
+				PendingAlloc result(block, size);
+				result.large = true;
+				return result;
+			}
+
+			// Other objects are allocated in a shared block inside a higher generation. This
+			// requires using a lock for that generation's block, since we share it with others.
 			into->sharedBlockLock.lock();
 			Block *shared = owner.arena.enter(*into, &Generation::sharedBlock, size);
 			if (!shared)
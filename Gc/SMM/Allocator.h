@@ -18,7 +18,7 @@ namespace storm {
 		class PendingAlloc {
 			friend class Allocator;
 		public:
-			PendingAlloc() : source(null), memory(null) {}
+			PendingAlloc() : source(null), memory(null), release(null), large(false) {}
 
 			// Does this pending allocation contain any memory?
 			operator bool() const {
@@ -44,11 +44,9 @@ namespace storm {
 
 				// Shall we re-try the allocation?
 				if (source->mem(committed) != memory || reserved <= committed) {
-					if (release)
-						release->unlock();
-
 					// Update 'memory' so that the next allocation might work.
 					memory = source->mem(source->committed());
+					finish();
 					return false;
 				}
 
@@ -66,13 +64,13 @@ namespace storm {
 				// 'committed' and this point. Anything happening before we read the two values will
 				// be caught by the condition above.
 				bool ok = source->committedCAS(committed, reserved);
-				if (release)
-					release->unlock();
+				finish();
 				return ok;
 			}
 
 		private:
-			PendingAlloc(Block *source, size_t size, util::Lock *release = null) : source(source), release(release) {
+			PendingAlloc(Block *source, size_t size, util::Lock *release = null)
+				: source(source), release(release), large(false) {
 				// Note: We only need this to be atomic wrt garbage collections, not other threads
 				// using this object or the block concurrently.
 				size_t committed = source->committed();
@@ -88,6 +86,21 @@ namespace storm {
 
 			// Lock we need to release when the allocation is committed (if any).
 			util::Lock *release;
+
+			// Is this a large allocation? Large allocations are alone in their block, so the
+			// block is released as soon as the allocation is committed, regardless of whether it
+			// succeeded or not. A failed allocation is re-tried in a new block.
+			bool large;
+
+			// Release the lock or the block. Note: The block of a large allocation may be
+			// reclaimed by the GC as soon as it is released, so 'source' may not be accessed
+			// after calling 'finish'.
+			void finish() {
+				if (release)
+					release->unlock();
+				if (large)
+					source->clearFlag(Block::fUsed);
+			}
 		};
 
 
@@ -142,7 +155,8 @@ namespace storm {
 			void fill(size_t desiredMin);
 			void fillI(ArenaTicket &entry, size_t desiredMin);
 
-			// Make a large allocation (in a higher-numbered generation).
+			// Make a large allocation (in a higher-numbered generation). Objects larger than
+			// 'largeObjectSize' are placed in a chunk of their own.
 			PendingAlloc allocLarge(size_t size);
 		};
 
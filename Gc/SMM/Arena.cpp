@@ -11,13 +11,16 @@
 #include "Nonmoving.h"
 #include "ArenaTicket.h"
 #include "FinalizerPool.h"
+#include "IdentityHash.h"
+#include "OS/ThreadPool.h"
+#include "OS/ThreadStats.h"
 
 namespace storm {
 	namespace smm {
 
-		// TODO: Make the nursery generation size customizable.
 		Arena::Arena(size_t initialSize, const size_t *genSize, size_t generationCount)
-			: alloc(initialSize), entries(0), rampAttempts(0) {
+			: alloc(initialSize), entries(0), rampAttempts(0),
+			  workers(min(os::ThreadPool::cpuCount(), gcWorkerLimit)) {
 
 			// Check assumptions of the formatting code.
 			fmt::init();
@@ -33,6 +36,9 @@ namespace storm {
 			// Create the finalizer pool.
 			finalizers = new FinalizerPool(*this);
 
+			// Create the table of identity hashes.
+			identityHashes = new IdentityHash(*this);
+
 			// Allocate the individual generations.
 			byte genId = firstFreeIdentifier;
 			generations = vector<Generation *>(generationCount + 1, null);
@@ -41,12 +47,14 @@ namespace storm {
 
 				size_t genSz = roundUp(genSize[i], alloc.pageSize);
 				generations[i] = new Generation(*this, genSz, genId++);
+				generations[i]->number = nat(i);
 			}
 
 			// Duplicate the last generation.
 			{
 				size_t genSz = roundUp(genSize[generationCount - 1], alloc.pageSize);
 				generations[generationCount] = new Generation(*this, genSz, genId++);
+				generations[generationCount]->number = nat(generationCount - 1);
 			}
 
 			// Connect the generations.
@@ -93,6 +101,27 @@ namespace storm {
 
 			delete nonmovingAllocs;
 			nonmovingAllocs = null;
+
+			delete identityHashes;
+			identityHashes = null;
+		}
+
+		nat Arena::identityHash(const void *obj) {
+			nat result;
+			if (identityHashes->tryHash(obj, result))
+				return result;
+			return lock(*identityHashes, &IdentityHash::hash, obj);
+		}
+
+		nat Arena::storeIdentityHash(const void *obj) {
+			return lock(*identityHashes, &IdentityHash::store, obj);
+		}
+
+		void Arena::releaseIdentityHash(const void *obj) {
+			// Objects that never move do not have entries.
+			if (memGeneration((void *)obj) >= nonmovingIdentifier)
+				return;
+			lock(*identityHashes, &IdentityHash::release, obj);
 		}
 
 		Chunk Arena::allocChunk(size_t size, byte identifier) {
@@ -164,6 +193,49 @@ namespace storm {
 			swapLastGens();
 		}
 
+		bool Arena::collect(nat time) {
+			return enter(*this, &Arena::collectStepI, time);
+		}
+
+		bool Arena::collectStepI(ArenaTicket &entry, nat time) {
+			// Incremental collections are just as disruptive as regular ones during ramp mode. We
+			// report that there is nothing more to do, since callers typically call us repeatedly
+			// until we do, and the ramp may last for a long time. Generations that need to be
+			// collected are collected when the ramp ends instead.
+			if (atomicRead(rampAttempts) > 0)
+				return false;
+
+			// Collect one generation at a time, starting with the youngest one, as long as we
+			// expect the collection to finish within the time limit. The time of the previous
+			// collection of each generation is used as an estimate. Since the write barriers keep
+			// track of references between generations, each generation can be collected on its
+			// own at any time.
+			size_t limit = size_t(time) * 1000;
+			int64 start = os::ThreadStats::now();
+			size_t last = generations.size() - 1;
+			for (size_t i = 0; i < last; i++) {
+				Generation *gen = generations[i];
+				if (!gen->wantsCollection())
+					continue;
+
+				if (os::ThreadStats::since(start) + gen->lastCollectionTime > limit)
+					return true;
+
+				// Note: The generation keeps track of the time of each collection.
+				collectI(entry, GenSet(gen->identifier));
+
+				// Collecting one of the last generations swaps them, so we stop here to not get confused.
+				if (i + 2 >= last)
+					break;
+			}
+
+			for (size_t i = 0; i < last; i++)
+				if (generations[i]->wantsCollection())
+					return true;
+
+			return false;
+		}
+
 		// Collect the specified generation, but first see if there is enough free space in the
 		// following generations. Any generations in 'ignore' are assumed to have been collected
 		// already and are ignored.
@@ -213,6 +285,66 @@ namespace storm {
 			return collect;
 		}
 
+		GcParams Arena::params() {
+			return lock(*this, &Arena::getParamsI);
+		}
+
+		GcParams Arena::getParamsI(LockTicket &) {
+			// The last generation is duplicated, and the duplicate is not visible to the user.
+			GcParams result;
+			for (size_t i = 0; i + 1 < generations.size(); i++)
+				result.generations.push_back(generations[i]->baseSize);
+			result.adaptive = generations[0]->adaptive;
+			result.pauseTarget = generations[0]->pauseTarget;
+			result.workers = workers.threads();
+			return result;
+		}
+
+		void Arena::params(const GcParams &params) {
+			lock(*this, &Arena::setParamsI, &params);
+		}
+
+		void Arena::setParamsI(LockTicket &, const GcParams *params) {
+			size_t last = generations.size() - 1;
+			for (size_t i = 0; i < params->generations.size() && i < last; i++) {
+				size_t size = roundUp(params->generations[i], alloc.pageSize);
+				generations[i]->size(size);
+				// Keep the two copies of the last generation in sync.
+				if (i + 1 == last)
+					generations[last]->size(size);
+			}
+
+			// The last two generations are collected into each other. Their sizes only decide
+			// when to collect them, so there is nothing to gain from adapting them.
+			nat pauseTarget = params->pauseTarget ? params->pauseTarget : defaultPauseTarget;
+			for (size_t i = 0; i <= last; i++) {
+				generations[i]->adaptive = params->adaptive && i + 2 <= last;
+				generations[i]->pauseTarget = pauseTarget;
+				if (!generations[i]->adaptive)
+					generations[i]->totalSize = generations[i]->baseSize;
+			}
+
+			workers.threads(params->workers);
+		}
+
+		size_t Arena::collections() {
+			return lock(*this, &Arena::collectionsI);
+		}
+
+		size_t Arena::collectionsI(LockTicket &) {
+			size_t result = 0;
+			for (size_t i = 0; i < generations.size(); i++)
+				result += generations[i]->collections;
+			return result;
+		}
+
+		size_t Arena::usedBytes() const {
+			size_t result = 0;
+			for (size_t i = 0; i < generations.size(); i++)
+				result += generations[i]->currentUsed();
+			return result;
+		}
+
 		void Arena::swapLastGens() {
 			size_t gens = generations.size();
 			swap(generations[gens - 1], generations[gens - 2]);
@@ -235,10 +367,35 @@ namespace storm {
 
 			nonmovingAllocs->fillSummary(summary);
 			finalizers->fillSummary(summary);
+			identityHashes->fillSummary(summary);
 
 			return summary;
 		}
 
+		struct WalkCall {
+			Arena::WalkFn fn;
+			void *param;
+
+			void operator ()(void *obj) const {
+				(*fn)(obj, param);
+			}
+		};
+
+		void Arena::walk(WalkFn fn, void *param) {
+			enter(*this, &Arena::walkI, fn, param);
+		}
+
+		void Arena::walkI(ArenaTicket &entry, WalkFn fn, void *param) {
+			// Threads may be in the middle of allocating objects in blocks we visit.
+			entry.stopThreads();
+
+			WalkCall call = { fn, param };
+			for (size_t i = 0; i < generations.size(); i++)
+				generations[i]->traverse(call);
+
+			nonmovingAllocs->traverse(call);
+		}
+
 		void Arena::startRamp() {
 			atomicIncrement(rampAttempts);
 		}
@@ -273,6 +430,7 @@ namespace storm {
 				generations[i]->dbg_verify();
 
 			nonmovingAllocs->dbg_verify();
+			identityHashes->dbg_verify();
 
 			// TODO: Check finalizer pool as well?
 		}
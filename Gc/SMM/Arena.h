@@ -7,7 +7,10 @@
 #include "InlineSet.h"
 #include "GenSet.h"
 #include "History.h"
+#include "Workers.h"
 #include "Gc/MemorySummary.h"
+#include "Gc/GcParams.h"
+#include "Gc/Telemetry.h"
 #include "Utils/Templates.h"
 
 namespace storm {
@@ -21,6 +24,7 @@ namespace storm {
 		class LockTicket;
 		class ArenaTicket;
 		class FinalizerPool;
+		class IdentityHash;
 
 		/**
 		 * An Arena keeps track of all allocations made by the GC, and represents the entire world
@@ -92,16 +96,50 @@ namespace storm {
 			// Perform a full GC (API will most likely change).
 			void collect();
 
+			// Perform an incremental GC, spending approximately 'time' ms. Returns true if there
+			// is more to do.
+			bool collect(nat time);
+
 			// Begin/end ramp allocations.
 			void startRamp();
 			void endRamp();
 
+			// Get/set parameters for the generations.
+			GcParams params();
+			void params(const GcParams &params);
+
+			// Number of collections performed so far.
+			size_t collections();
+
 			// Object movement history, to allow implementing location dependencies.
 			History history;
 
+			// Telemetry about collections.
+			GcTelemetry telemetry;
+
+			// Number of bytes used by objects in all generations. Only valid while holding the lock.
+			size_t usedBytes() const;
+
+			// Get a hash for an object. The hash does not change when the object is moved if
+			// 'storeIdentityHash' has been called for the object.
+			nat identityHash(const void *obj);
+
+			// Get a hash for an object that does not change when the object is moved.
+			nat storeIdentityHash(const void *obj);
+
+			// Release a hash previously stored by 'storeIdentityHash'.
+			void releaseIdentityHash(const void *obj);
+
 			// Provide a memory summary. This traverses all objects, and is fairly expensive.
 			MemorySummary summary();
 
+			// Callback for 'walk'.
+			typedef void (*WalkFn)(void *obj, void *param);
+
+			// Call 'fn' for each object in the arena, including padding objects. Other threads are
+			// stopped during the walk, so 'fn' may neither take locks nor allocate memory.
+			void walk(WalkFn fn, void *param);
+
 			// Check if an address is managed by this arena. Mostly useful for debugging.
 			// TODO: Should we lock the access to the VMAlloc instance?
 			inline bool has(void *addr) const { return alloc.has(addr); }
@@ -143,6 +181,9 @@ namespace storm {
 			// Pool for storing objects that need finalization.
 			FinalizerPool *finalizers;
 
+			// Identity hashes of objects.
+			IdentityHash *identityHashes;
+
 			// Virtual memory allocations.
 			VMAlloc alloc;
 
@@ -155,17 +196,31 @@ namespace storm {
 			// Inexact roots. We assume there are not too many of these.
 			InlineSet<Root> inexactRoots;
 
+			// Helper threads used during collections.
+			Workers workers;
+
 			// Perform a garbage collection.
 			void collectI(ArenaTicket &e);
 
+			// Perform a part of a garbage collection, limited to approximately 'time' ms.
+			bool collectStepI(ArenaTicket &e, nat time);
+
 			// The ArenaTicket tells us we need to collect certain generations. Returns a GenSet
 			// describing the generations actually collected.
 			GenSet collectI(ArenaTicket &e, GenSet collect);
 
+			// Walk all objects.
+			void walkI(ArenaTicket &e, WalkFn fn, void *param);
+
 			// Swap the last two generations. Should be called after a GC so that the last
 			// generation can be collected the next GC cycle.
 			void swapLastGens();
 
+			// Get/set parameters with the lock held.
+			GcParams getParamsI(LockTicket &ticket);
+			void setParamsI(LockTicket &ticket, const GcParams *params);
+			size_t collectionsI(LockTicket &ticket);
+
 		public:
 			/**
 			 * Enter the arena by acquiring a ticket.
@@ -37,13 +37,19 @@ namespace storm {
 		}
 
 
-		ArenaTicket::ArenaTicket(Arena &owner) : LockTicket(owner), gc(false), threads(false), objectsMoved(false) {}
+		ArenaTicket::ArenaTicket(Arena &owner) : LockTicket(owner), gc(false), threads(false), objectsMoved(false), lastEvent(0) {}
 
 		ArenaTicket::~ArenaTicket() {
 			startThreads();
 			unlock();
 		}
 
+		void ArenaTicket::attachedThreads(vector<Thread *> &out) const {
+			InlineSet<Thread> &threads = owner.threads;
+			for (InlineSet<Thread>::iterator i = threads.begin(); i != threads.end(); ++i)
+				out.push_back(*i);
+		}
+
 		void ArenaTicket::stopThreads() {
 			if (threads)
 				return;
@@ -136,7 +142,14 @@ namespace storm {
 				// other way around, we want to run finalizers for nonmoving objects first.
 				owner.nonmoving().runFinalizers(context);
 				owner.finalizers->finalize(context);
+
+				if (lastEvent)
+					owner.telemetry.finalized(lastEvent, context.count());
 			}
+
+			// Write telemetry to the log, if desired. This can not be done while threads are stopped.
+			if (lastEvent)
+				owner.telemetry.flush();
 		}
 
 
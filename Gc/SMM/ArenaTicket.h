@@ -6,6 +6,7 @@
 #include "Root.h"
 #include "SpilledRegs.h"
 #include "Utils/Templates.h"
+#include "Utils/Lock.h"
 #include <csetjmp>
 
 namespace storm {
@@ -86,6 +87,11 @@ namespace storm {
 			// ticket is destroyed anyway, but an earlier start can sometimes be desired.
 			void startThreads();
 
+			// Tell the ticket that a collection was recorded as 'event' in the telemetry. Any
+			// finalizers executed when the ticket is released are attributed to the latest such
+			// event.
+			void collected(size_t event) { lastEvent = event; }
+
 			// Tell the ArenaTicket that a generation desires to be collected. This will trigger a
 			// collection whenever the system has completed its current action (e.g. when the
 			// ArenaTicket is being released).
@@ -107,26 +113,44 @@ namespace storm {
 				return owner.alloc.anyWrites(chunk);
 			}
 
-			// Note that objects have been moved from the specified range.
+			// Note that objects have been moved from the specified range. May be called from
+			// multiple worker threads at once.
 			inline void objectsMovedFrom(const void *from, size_t size) {
+				util::Lock::L z(movedLock);
 				objectsMoved = true;
 				owner.history.addFrom(*this, size_t(from), size_t(from) + size);
 			}
 			inline void objectsMovedFrom(const void *from, const void *to) {
+				util::Lock::L z(movedLock);
 				objectsMoved = true;
 				owner.history.addFrom(*this, size_t(from), size_t(to));
 			}
 
-			// Note that objects have been moved to the specified range.
+			// Note that objects have been moved to the specified range. May be called from multiple
+			// worker threads at once.
 			inline void objectsMovedTo(const void *to, size_t size) {
+				util::Lock::L z(movedLock);
 				objectsMoved = true;
 				owner.history.addTo(*this, size_t(to), size_t(to) + size);
 			}
 			inline void objectsMovedTo(const void *from, const void *to) {
+				util::Lock::L z(movedLock);
 				objectsMoved = true;
 				owner.history.addTo(*this, size_t(from), size_t(to));
 			}
 
+			// Get the helper threads in the arena. Starts them if possible, i.e. if threads are
+			// not stopped yet.
+			inline Workers &workers() {
+				if (!threads)
+					owner.workers.start();
+				return owner.workers;
+			}
+
+			// Get all threads attached to the arena. Note: allocates memory, so this should be
+			// called before threads are stopped.
+			void attachedThreads(vector<Thread *> &out) const;
+
 			// Get the static object pool. This is considered being a part of all generations, since
 			// it is assumed to contain a very small number of objects.
 			inline Nonmoving &nonmoving() const {
@@ -138,12 +162,22 @@ namespace storm {
 				return *owner.finalizers;
 			}
 
+			// Get the table of identity hashes in the arena.
+			inline IdentityHash &identityHash() const {
+				return *owner.identityHashes;
+			}
+
 			// Get an addrset describing the full range currently reserved by the VM backend.
 			template <class AddrSet>
 			AddrSet reservedSet() const {
 				return owner.alloc.addrSet<AddrSet>();
 			}
 
+			// Move a chunk to another generation by changing its identifier.
+			inline void memGeneration(Chunk chunk, byte identifier) const {
+				owner.alloc.identifier(chunk, identifier);
+			}
+
 			// Get the identifier for a memory address managed, or 0xFF if none exists.
 			inline byte safeIdentifier(void *address) const {
 				return owner.alloc.safeIdentifier(address);
@@ -153,6 +187,11 @@ namespace storm {
 			template <class Scanner>
 			typename Scanner::Result scanInexactRoots(typename Scanner::Source &source);
 
+			// Scan all inexact roots except the stacks of the attached threads. Used when the
+			// threads are scanned separately, see 'attachedThreads'.
+			template <class Scanner>
+			typename Scanner::Result scanInexactRootsNoThreads(typename Scanner::Source &source);
+
 			// Scan exact roots.
 			template <class Scanner>
 			typename Scanner::Result scanExactRoots(typename Scanner::Source &source);
@@ -165,7 +204,9 @@ namespace storm {
 
 			// Scan all blocks, just as above. However, indicate that we're just about done with
 			// garbage collection, and that we might want to take the opportunity to raise memory
-			// barriers now to avoid scanning in the future.
+			// barriers now to avoid scanning in the future. Chunks are scanned in parallel using
+			// the helper threads, so 'source' must be safe to share between threads, and
+			// 'Scanner' may only modify the scanned objects.
 			template <class Scanner>
 			typename Scanner::Result scanGenerationsFinal(typename Scanner::Source &source, GenSet current);
 
@@ -182,6 +223,12 @@ namespace storm {
 			// Did we move any objects?
 			bool objectsMoved;
 
+			// Latest collection recorded in the telemetry, if any.
+			size_t lastEvent;
+
+			// Lock for the history, since objects may be moved from multiple threads.
+			util::Lock movedLock;
+
 			// Called to perform any scheduled tasks, such as collecting certain generations.
 			// Could be called in the destructor, but I'm not comfortable doing that much work there...
 			void finalize();
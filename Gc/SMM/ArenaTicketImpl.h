@@ -25,6 +25,12 @@ namespace storm {
 					return r;
 			}
 
+			return scanInexactRootsNoThreads<Scanner>(source);
+		}
+
+		template <class Scanner>
+		typename Scanner::Result ArenaTicket::scanInexactRootsNoThreads(typename Scanner::Source &source) {
+			typename Scanner::Result r = typename Scanner::Result();
 			InlineSet<Root> &roots = owner.inexactRoots;
 			for (InlineSet<Root>::iterator i = roots.begin(); i != roots.end(); ++i) {
 				r = i->scan<Scanner>(source);
@@ -72,24 +78,69 @@ namespace storm {
 			return r;
 		}
 
+		/**
+		 * Task for scanning chunks in all generations in parallel.
+		 */
 		template <class Scanner>
-		typename Scanner::Result ArenaTicket::scanGenerationsFinal(typename Scanner::Source &source, GenSet current) {
-			typename Scanner::Result r = typename Scanner::Result();
+		class ScanChunksTask {
+		public:
+			typedef typename Scanner::Result Result;
+			typedef typename Scanner::Source Source;
+
+			ScanChunksTask(ArenaTicket &ticket, const vector<Generation *> &gens, GenSet current, Source &source)
+				: result(), ticket(ticket), gens(gens), current(current), source(source) {}
+
+			// Total number of chunks to scan.
+			size_t count() const {
+				size_t r = 0;
+				for (size_t i = 0; i < gens.size(); i++)
+					if (!current.has(gens[i]->identifier))
+						r += gens[i]->chunkCount();
+				return r;
+			}
 
-			for (size_t i = 0; i < owner.generations.size(); i++) {
-				Generation *gen = owner.generations[i];
+			// Scan chunk number 'task', counting the chunks in all generations in order. There are
+			// only a few generations, so we just find the generation each time.
+			void operator ()(nat worker, size_t task) {
+				for (size_t i = 0; i < gens.size(); i++) {
+					Generation *gen = gens[i];
+					if (current.has(gen->identifier))
+						continue;
+
+					if (task >= gen->chunkCount()) {
+						task -= gen->chunkCount();
+						continue;
+					}
+
+					Result r = gen->scanChunkFinal<Scanner>(ticket, task, current, source);
+					if (r != Result()) {
+						util::Lock::L z(lock);
+						if (result == Result())
+							result = r;
+					}
+					return;
+				}
+			}
 
-				// Don't scan the current generations, we want to handle those with more care.
-				if (current.has(gen->identifier))
-					continue;
+			// The first failure, if any.
+			Result result;
 
-				// Scan it, instructing the generation to only scan references to the current generation.
-				r = gen->scanFinal<Scanner>(*this, current, source);
-				if (r != typename Scanner::Result())
-					return r;
-			}
+		private:
+			ArenaTicket &ticket;
+			const vector<Generation *> &gens;
+			GenSet current;
+			Source &source;
+			util::Lock lock;
+		};
 
-			return r;
+		template <class Scanner>
+		typename Scanner::Result ArenaTicket::scanGenerationsFinal(typename Scanner::Source &source, GenSet current) {
+			// Scan all chunks in the other generations, instructing the generation to only scan
+			// references to the current generation. Chunks are independent of each other, so
+			// these are distributed among the helper threads.
+			ScanChunksTask<Scanner> task(*this, owner.generations, current, source);
+			workers().run(task.count(), task);
+			return task.result;
 		}
 
 
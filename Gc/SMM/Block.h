@@ -43,6 +43,10 @@ namespace storm {
 
 				// This block should not be scanned the next time we attempt to.
 				fSkipScan = 0x00000004,
+
+				// This block is the only block in a chunk dedicated to a single large object. See
+				// 'largeObjectSize'.
+				fLarge = 0x00000008,
 			};
 
 			// Modify flags.
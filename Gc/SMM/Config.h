@@ -33,6 +33,36 @@ namespace storm {
 		static const size_t vmAllocBits = 16;
 		static const size_t vmAllocMinSize = 1 << vmAllocBits;
 
+		// Objects of at least this size are allocated in a chunk of their own, and are never moved
+		// by the GC. Instead, they are marked where they are and promoted to the next generation
+		// by changing the identifier of their chunk. The memory at the end of the chunk that is not
+		// used by the object is never touched, and thus does not occupy any physical memory.
+		static const size_t largeObjectSize = vmAllocMinSize / 2;
+
+		// Maximum number of threads used during a collection, including the thread performing the
+		// collection. The actual number is also limited by the number of CPUs in the system. Set to
+		// 1 to perform all collections on a single thread.
+		static const nat gcWorkerLimit = 8;
+
+		// Incremental collections only collect generations that are at least 1/incrementalFraction
+		// full. Collecting generations that are almost empty is not worth the effort.
+		static const size_t incrementalFraction = 4;
+
+		// Generations using adaptive sizing aim to keep the time spent in each of their
+		// collections below 'defaultPauseTarget' microseconds unless told otherwise. Their size
+		// is kept between 1/adaptiveMinFactor and adaptiveMaxFactor times their initial size.
+		static const nat defaultPauseTarget = 5000;
+		static const size_t adaptiveMinFactor = 4;
+		static const size_t adaptiveMaxFactor = 16;
+
+		// Chunks that are modified between 'hotChunkThreshold' consecutive collections are left
+		// without write protection during the following 'hotChunkDuration' collections. Scanning
+		// such chunks during each collection is cheaper than handling a fault for each modified
+		// page every time the barrier is raised. Set 'hotChunkThreshold' to 0 to always use write
+		// protection.
+		static const byte hotChunkThreshold = 3;
+		static const byte hotChunkDuration = 8;
+
 		// Maximum number of bits for use in generation identifiers. Enforced by VMAlloc.h.
 		static const size_t identifierBits = CHAR_BIT - 2;
 		static const byte identifierMaxVal = byte(1) << identifierBits;
@@ -6,7 +6,7 @@
 namespace storm {
 	namespace smm {
 
-		FinalizerContext::FinalizerContext() : shared(null) {}
+		FinalizerContext::FinalizerContext() : finalized(0), shared(null) {}
 
 		FinalizerContext::~FinalizerContext() {
 			// Tell all threads we're done.
@@ -26,6 +26,8 @@ namespace storm {
 		}
 
 		void FinalizerContext::finalize(fmt::Obj *object, const os::Thread &thread) {
+			finalized++;
+
 			Worker *worker;
 			Workers::iterator i = workers.find(thread.id());
 			if (i == workers.end()) {
@@ -27,6 +27,9 @@ namespace storm {
 			// Make sure to run the finalizer for 'obj' on the specified thread.
 			void finalize(fmt::Obj *object, const os::Thread &thread);
 
+			// Number of finalizers scheduled so far.
+			size_t count() const { return finalized; }
+
 			// Called by FinalizerPool to register cleanup.
 			typedef void (FinalizerPool::*FinalizerPoolFn)(void *aux);
 			void cleanup(FinalizerPool *pool, FinalizerPoolFn fn, void *aux);
@@ -54,6 +57,9 @@ namespace storm {
 				void *poolAux;
 			};
 
+			// Number of finalizers scheduled.
+			size_t finalized;
+
 			// Used if no threads were spawned.
 			Finish local;
 
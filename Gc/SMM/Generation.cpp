@@ -11,23 +11,33 @@
 #include "ArenaTicket.h"
 #include "ArenaTicketImpl.h"
 #include "FinalizerPool.h"
+#include "IdentityHash.h"
 #include "UpdateFwd.h"
 #include "Util.h"
+#include "Workers.h"
+#include "OS/ThreadStats.h"
 
 namespace storm {
 	namespace smm {
 
 		// TODO: What is a reasonable block size here?
 		Generation::Generation(Arena &arena, size_t size, byte identifier)
-			: totalSize(size), blockSize(size / 32),
-			  next(null), arena(arena), identifier(identifier),
-			  lastChunk(0), totalAllocBytes(0), totalFreeBytes(0), shared(null) {
+			: next(null), arena(arena), identifier(identifier), number(0),
+			  lastCollectionTime(0), collections(0), adaptive(false), pauseTarget(defaultPauseTarget),
+			  lastChunk(0), totalAllocBytes(0), totalFreeBytes(0), shared(null),
+			  unscannedLarge(0) {
 
-			// Maximum of 32 KB blocks
-			blockSize = min(size_t(1024 * 1024 / 32), blockSize);
+			this->size(size);
 			pinnedSets.push_back(PinnedSet(0, 1));
 		}
 
+		void Generation::size(size_t size) {
+			baseSize = totalSize = size;
+
+			// Maximum of 32 KB blocks
+			blockSize = min(size_t(1024 * 1024 / 32), size / 32);
+		}
+
 		Generation::~Generation() {
 			// Free all blocks we are in charge of.
 			for (size_t i = 0; i < chunks.size(); i++) {
@@ -86,6 +96,71 @@ namespace storm {
 			return shared;
 		}
 
+		Block *Generation::allocLarge(ArenaTicket &ticket, size_t size) {
+			Chunk c = arena.allocChunk(size + sizeof(Block), identifier);
+			if (c.empty())
+				return null;
+
+			size_t pos = insertSorted(chunks, GenChunk(c), ChunkCompare());
+			GenChunk &chunk = chunks[pos];
+			chunk.large = true;
+			chunk.freeBytes = 0;
+
+			while (pinnedSets.size() < chunks.size() + 1)
+				pinnedSets.push_back(PinnedSet(0, 1));
+
+			Block *r = chunk.lastAlloc;
+			r->setFlag(Block::fUsed);
+			r->setFlag(Block::fLarge);
+
+			totalAllocBytes += c.size;
+			if (totalAllocBytes > totalSize)
+				ticket.scheduleCollection(this);
+
+			return r;
+		}
+
+		bool Generation::markLarge(void *obj, void *end) {
+			ChunkList::iterator pos = std::lower_bound(chunks.begin(), chunks.end(), obj, PtrCompare());
+			if (pos == chunks.end() || !pos->large)
+				return false;
+
+			pinnedSets[pos - chunks.begin()].add(obj, end);
+			if (!pos->unscanned) {
+				pos->unscanned = true;
+				unscannedLarge++;
+			}
+			return true;
+		}
+
+		void Generation::promoteLarge(ArenaTicket &ticket) {
+			for (size_t i = chunks.size(); i > 0; i--) {
+				GenChunk &chunk = chunks[i - 1];
+				if (!chunk.large)
+					continue;
+
+				totalAllocBytes -= chunk.memory.size;
+				totalFreeBytes -= chunk.freeBytes;
+				next->adoptLarge(ticket, chunk);
+
+				chunks.erase(chunks.begin() + (i - 1));
+				pinnedSets.erase(pinnedSets.begin() + (i - 1));
+			}
+		}
+
+		void Generation::adoptLarge(ArenaTicket &ticket, const GenChunk &chunk) {
+			// Note: The chunk is not write protected at this point, so it will be scanned and get
+			// a proper summary the next time it is relevant.
+			ticket.memGeneration(chunk.memory, identifier);
+			insertSorted(chunks, chunk, ChunkCompare());
+
+			while (pinnedSets.size() < chunks.size() + 1)
+				pinnedSets.push_back(PinnedSet(0, 1));
+
+			totalAllocBytes += chunk.memory.size;
+			totalFreeBytes += chunk.freeBytes;
+		}
+
 		Block *Generation::allocBlock(ArenaTicket &ticket, size_t minSize, size_t maxSize) {
 			if (minSize > maxSize)
 				return null;
@@ -169,6 +244,64 @@ namespace storm {
 			if (chunks.empty())
 				return;
 
+			size_t before = currentUsed();
+			size_t nextBefore = next->currentUsed();
+			int64 start = os::ThreadStats::now();
+
+			collectI(ticket);
+
+			int64 end = os::ThreadStats::now();
+			lastCollectionTime = size_t(end - start);
+			collections++;
+
+			// Objects that survived are either left here (if they were pinned), or moved to the
+			// next generation.
+			size_t nextAfter = next->currentUsed();
+			size_t copied = nextAfter > nextBefore ? nextAfter - nextBefore : 0;
+			size_t survived = currentUsed() + copied;
+
+			GcTelemetry::Event event;
+			event.start = start;
+			event.end = end;
+			event.generation = number;
+			event.condemned = before;
+			event.copied = copied;
+			event.freed = before > survived ? before - survived : 0;
+			event.heapUsed = arena.usedBytes();
+			ticket.collected(arena.telemetry.record(event));
+
+			if (adaptive)
+				adapt(before, survived, lastCollectionTime);
+		}
+
+		void Generation::adapt(size_t before, size_t survived, size_t time) {
+			totalSize = adaptedSize(totalSize, baseSize, pauseTarget, before, survived, time);
+		}
+
+		size_t Generation::adaptedSize(size_t current, size_t base, nat pauseTarget,
+									size_t before, size_t survived, size_t time) {
+			// Scale the generation so that the next collection takes approximately 'pauseTarget'
+			// us. The time of a collection grows roughly with the size of the generation, but we
+			// scale by the square root to not over-react to a single measurement.
+			double factor = 2.0;
+			if (time > 0)
+				factor = std::sqrt(double(pauseTarget) / double(time));
+			factor = max(0.5, min(2.0, factor));
+
+			// If most objects survive, they are likely long-lived. Collecting them over and over
+			// again in this generation is a waste of time, so shrink the generation to promote
+			// them sooner.
+			double survival = before > 0 ? double(survived) / double(before) : 0.0;
+			if (survival > 0.5)
+				factor = min(factor, 1.5 - survival);
+
+			size_t size = size_t(double(current) * factor);
+			size = max(size, base / adaptiveMinFactor);
+			size = min(size, base * adaptiveMaxFactor);
+			return size;
+		}
+
+		void Generation::collectI(ArenaTicket &ticket) {
 			ticket.gcRunning();
 
 			// GenSet only containing us.
@@ -193,6 +326,11 @@ namespace storm {
 			}
 			pinnedSets[chunks.size()] = nonmoving.addrSet<PinnedSet>();
 
+			// Helper threads for the parallel parts of the collection. These need to be started
+			// before other threads are stopped, as well as any memory we need for them.
+			Workers &workers = ticket.workers();
+			prepareInexactRoots(ticket, workers);
+
 			// We need other threads stopped from here onwards.
 			ticket.stopThreads();
 
@@ -203,7 +341,7 @@ namespace storm {
 
 			// TODO: We might want to do an 'early out' inside the scanning by using
 			// VMAlloc::identifier before attempting to access the sets. We need to measure the benefits of this!
-			ticket.scanInexactRoots<ScanSummaries<PinnedSet>>(pinnedSets);
+			scanInexactRoots(ticket, workers);
 
 			// Keep track of surviving objects inside a ScanState object, which allocates memory
 			// from the next generation.
@@ -230,11 +368,15 @@ namespace storm {
 			ticket.scanExactRoots<GenNoWeakScanner>(scanState);
 
 			// Traverse the newly copied objects in the new block and copy any new references until
-			// no more objects are found.
+			// no more objects are found. Note: This runs on the collecting thread only, see
+			// ScanState. Large objects found along the way are marked rather than
+			// copied, so they need to be scanned separately, which may find more objects to copy.
 			// Note: If we're sure that the scanned objects contain no references to themselves, we
 			// can actually avoid this step entirely. We would, however, tell the ScanState to
 			// release the held Blocks in this case.
-			scanState.scanNew();
+			do {
+				scanState.scanNew();
+			} while (scanLarge<GenNoWeakScanner>(scanState));
 
 			// Grab objects referred to only by old finalizers and keep them alive in the finalizing
 			// generation for the time being. We want to keep objects being finalized intact for as
@@ -276,6 +418,9 @@ namespace storm {
 			for (size_t i = 0; i < chunks.size(); i++)
 				scanPinned<OnlyWeak<UpdateWeakFwd>>(chunks[i], pinnedSets[i], state);
 
+			// The identity hash table refers to objects weakly as well.
+			ticket.identityHash().update(ticket, state);
+
 			// Note: We try to not scan the objects we moved to a new generation immediately at this
 			// point. ScanState sets the flag fSkipScan on all blocks that were empty when they were
 			// allocated, and 'scan' in the generations will then ignore scanning once if that flag
@@ -309,14 +454,16 @@ namespace storm {
 			//   that the new header misses any GcType objects. This means that they are kept alive slightly
 			//   longer than needed, but we mark them with a special header so that they are cleaned the next
 			//   time a similar situation occurs (even though it is fairly unlikely).
+			// Chunks are independent of each other, so they are compacted in parallel.
+			compactChunks(ticket, workers);
+
 			totalAllocBytes = 0;
 			totalFreeBytes = 0;
 			size_t freeLast = chunks.size();
 			for (size_t i = 0; i < chunks.size(); i++) {
 				GenChunk &chunk = chunks[i];
-				PinnedSet &pinned = pinnedSets[i];
 
-				if (chunk.compact(ticket, pinned)) {
+				if (chunk.empty()) {
 					// We know that the first few bytes inside the chunk is a Block header. As such,
 					// we can use that memory to create a linked list of chunk id:s to free later on.
 					*(size_t *)chunk.memory.at = freeLast;
@@ -340,6 +487,70 @@ namespace storm {
 				chunks.erase(chunks.begin() + id);
 				pinnedSets.erase(pinnedSets.begin() + id);
 			}
+
+			// Surviving large objects are moved to the next generation without copying them.
+			promoteLarge(ticket);
+			ticket.identityHash().promoted(ticket, identifier);
+		}
+
+		void Generation::prepareInexactRoots(ArenaTicket &ticket, Workers &workers) {
+			rootThreads.clear();
+			ticket.attachedThreads(rootThreads);
+
+			// All sets are empty at this point, so copying them gives us empty sets with the same range.
+			workerPinnedSets.resize(workers.count());
+			for (size_t i = 0; i < workerPinnedSets.size(); i++)
+				workerPinnedSets[i] = pinnedSets;
+		}
+
+		/**
+		 * Scan the stacks of threads, one thread per task.
+		 */
+		struct ScanThreadsTask {
+			ArenaTicket &ticket;
+			const vector<Thread *> &threads;
+			vector<vector<PinnedSet> > &sets;
+
+			void operator ()(nat worker, size_t task) {
+				threads[task]->scan<ScanSummaries<PinnedSet>>(sets[worker], ticket);
+			}
+		};
+
+		void Generation::scanInexactRoots(ArenaTicket &ticket, Workers &workers) {
+			// Each worker produces its own pinned sets, so that they don't interfere with each other.
+			ScanThreadsTask task = { ticket, rootThreads, workerPinnedSets };
+			workers.run(rootThreads.size(), task);
+
+			for (size_t w = 0; w < workerPinnedSets.size(); w++) {
+				const vector<PinnedSet> &sets = workerPinnedSets[w];
+				for (size_t i = 0; i < sets.size(); i++)
+					pinnedSets[i].add(sets[i]);
+			}
+
+			// The remaining roots are few, so we scan them here.
+			ticket.scanInexactRootsNoThreads<ScanSummaries<PinnedSet>>(pinnedSets);
+		}
+
+		/**
+		 * Compact chunks, one chunk per task.
+		 */
+		struct Generation::CompactTask {
+			ArenaTicket &ticket;
+			ChunkList &chunks;
+			const vector<PinnedSet> &pinned;
+
+			void operator ()(nat worker, size_t task) {
+				GenChunk &chunk = chunks[task];
+				if (chunk.large)
+					chunk.compactLarge(ticket, pinned[task]);
+				else
+					chunk.compact(ticket, pinned[task]);
+			}
+		};
+
+		void Generation::compactChunks(ArenaTicket &ticket, Workers &workers) {
+			CompactTask task = { ticket, chunks, pinnedSets };
+			workers.run(chunks.size(), task);
 		}
 
 		void Generation::runAllFinalizers(FinalizerContext &context) {
@@ -391,7 +602,8 @@ namespace storm {
 		 * A chunk.
 		 */
 
-		Generation::GenChunk::GenChunk(Chunk chunk) : memory(chunk) {
+		Generation::GenChunk::GenChunk(Chunk chunk)
+			: memory(chunk), writtenCount(0), unprotectedCount(0), large(false), unscanned(false) {
 			lastAlloc = new (memory.at) Block(memory.size - sizeof(Block));
 			freeBytes = memory.size - sizeof(Block);
 
@@ -458,6 +670,30 @@ namespace storm {
 			return null;
 		}
 
+		bool Generation::GenChunk::raiseBarrier() {
+			if (hotChunkThreshold == 0)
+				return true;
+
+			if (unprotectedCount > 0) {
+				if (--unprotectedCount > 0)
+					return false;
+
+				// Protect the chunk again to see if it is still modified frequently. If it is, it
+				// will be found to be modified during the next collection, which is enough to make
+				// it hot again.
+				writtenCount = hotChunkThreshold - 1;
+				return true;
+			}
+
+			if (++writtenCount >= hotChunkThreshold) {
+				writtenCount = 0;
+				unprotectedCount = hotChunkDuration;
+				return false;
+			}
+
+			return true;
+		}
+
 		void Generation::GenChunk::releaseBlock(Block *block) {
 			block->clearFlag(Block::fUsed);
 			freeBytes += block->remaining();
@@ -512,6 +748,29 @@ namespace storm {
 			compactFinishBlock(current, (Block *)memory.end());
 
 			// If the compaction resulted in a single empty block that is not marked as used, we're empty.
+			return empty();
+		}
+
+		bool Generation::GenChunk::compactLarge(ArenaTicket &ticket, const PinnedSet &pinned) {
+			Block *block = (Block *)memory.at;
+
+			// Note: We don't touch the header, so that 'fLarge' remains set. If the object is not
+			// committed yet, 'committed' is zero and the allocation will be re-tried, just as for
+			// other blocks.
+			size_t used = block->committed();
+			if (!pinned.has(block->mem(0), block->mem(used))) {
+				if (used > 0)
+					ticket.objectsMovedFrom(block->mem(0), block->mem(used));
+				block->clearFlag(Block::fFinalizers);
+				used = 0;
+			}
+
+			block->committed(used);
+			block->reserved(used);
+			return empty();
+		}
+
+		bool Generation::GenChunk::empty() const {
 			Block *first = (Block *)memory.at;
 			return first->mem(first->size) == memory.end()    // one block
 				&& first->committed() == 0                    // empty
@@ -765,7 +1024,7 @@ namespace storm {
 			while ((byte *)at < (byte *)memory.end()) {
 				assert(memory.has(at), L"Invalid block size detected. Leads to outside the specified chunk!");
 
-				if (!at->hasFlag(Block::fUsed))
+				if (!at->hasFlag(Block::fUsed) && !large)
 					free += at->remaining();
 
 				at->dbg_verify(arena);
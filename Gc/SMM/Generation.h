@@ -14,6 +14,8 @@ namespace storm {
 	namespace smm {
 
 		class ScanState;
+		class Thread;
+		class Workers;
 
 		/**
 		 * A generation is a set of blocks that belong together, and that will be collected
@@ -39,6 +41,10 @@ namespace storm {
 			// Our identifier.
 			const byte identifier;
 
+			// Our number, as seen by the user. The nursery is number 0. Both copies of the last
+			// generation have the same number.
+			nat number;
+
 			// The size of this generation. We strive to keep below this size, but it may
 			// occasionally be broken.
 			size_t totalSize;
@@ -59,6 +65,36 @@ namespace storm {
 			// limit. Returns zero if the limit has already been broken.
 			size_t currentGrace() const { return totalSize - min(totalSize, totalAllocBytes) + totalFreeBytes; }
 
+			// Is this generation full enough to be worth collecting during an incremental collection?
+			bool wantsCollection() const { return currentUsed() >= totalSize / incrementalFraction; }
+
+			// Time spent during the last collection of this generation, in microseconds. Used to
+			// estimate the time needed for incremental collections.
+			size_t lastCollectionTime;
+
+			// Number of collections of this generation so far.
+			size_t collections;
+
+			// The size of this generation as requested by the user. 'totalSize' is adjusted
+			// relative to this size if 'adaptive' is set.
+			size_t baseSize;
+
+			// Adapt 'totalSize' to the survival rate and the duration of collections?
+			bool adaptive;
+
+			// Desired duration of a collection of this generation, in microseconds. Used when
+			// 'adaptive' is set.
+			nat pauseTarget;
+
+			// Set the size of this generation.
+			void size(size_t size);
+
+			// Compute the new size of an adaptive generation after a collection. 'current' is the
+			// current size, 'base' is the size requested by the user, and 'pauseTarget' is the
+			// desired duration of a collection. The remaining parameters are as for 'adapt'.
+			static size_t adaptedSize(size_t current, size_t base, nat pauseTarget,
+									size_t before, size_t survived, size_t time);
+
 			// Allocate a new block in this generation. When the block is full, it should be
 			// finished by calling 'done'. The size of the returned block has at least 'minSize'
 			// free memory. Allocations where 'minSize' is much larger than 'blockSize' may not be
@@ -78,8 +114,14 @@ namespace storm {
 			// memory is needed in the returned block.
 			Block *sharedBlock(ArenaTicket &ticket, size_t freeBytes);
 
+			// Allocate a block for a single large object of 'size' bytes in a chunk of its
+			// own. The block is marked as used, and it is up to the caller to clear the flag when
+			// the allocation is committed. The block is never passed to 'done'.
+			Block *allocLarge(ArenaTicket &ticket, size_t size);
+
 			// Perform a full collection of this generation. We probably want a more fine-grained
-			// API in the future.
+			// API in the future. Also updates the statistics above, and adapts the size of the
+			// generation if desired.
 			void collect(ArenaTicket &ticket);
 
 			// Scan all blocks in this generation with the specified scanner.
@@ -99,6 +141,17 @@ namespace storm {
 											GenSet refsTo,
 											typename Scanner::Source &source);
 
+			// Number of chunks in this generation.
+			inline size_t chunkCount() const { return chunks.size(); }
+
+			// Scan a single chunk, just like 'scanFinal'. Different chunks may be scanned by
+			// different threads concurrently.
+			template <class Scanner>
+			typename Scanner::Result scanChunkFinal(ArenaTicket &ticket,
+													size_t chunk,
+													GenSet refsTo,
+													typename Scanner::Source &source);
+
 			// Run all finalizers in this block. Most likely only called before the entire Arena is
 			// destroyed, so no need for efficiency.
 			void runAllFinalizers(FinalizerContext &context);
@@ -127,6 +180,17 @@ namespace storm {
 					return gen.isPinned(obj, end);
 				}
 
+				// Mark a large object as reachable, causing it to be treated as if it was pinned
+				// from here on. Returns false if the object is not a large object.
+				inline bool markLarge(void *obj, void *end) const {
+					// Large objects are always directly after the header of their block, so we can
+					// rule out most objects without searching for their chunk.
+					Block *block = (Block *)((byte *)fmt::fromClient(obj) - sizeof(Block));
+					if (!block->hasFlag(Block::fLarge))
+						return false;
+					return gen.markLarge(obj, end);
+				}
+
 				// Get the arena.
 				inline Arena &arena() const {
 					return gen.arena;
@@ -140,6 +204,11 @@ namespace storm {
 			// Fill a memory summary with information.
 			void fillSummary(MemorySummary &summary) const;
 
+			// Traverse all objects in this generation. Calls Fn for each object, passing client
+			// pointers to the function. Note that padding objects are also passed to Fn.
+			template <class Fn>
+			void traverse(Fn fn);
+
 			// Verify the integrity of all blocks in this generation.
 			void dbg_verify();
 
@@ -152,6 +221,14 @@ namespace storm {
 			Generation(const Generation &o);
 			Generation &operator =(const Generation &o);
 
+			// Perform the actual collection.
+			void collectI(ArenaTicket &ticket);
+
+			// Adapt 'totalSize' after a collection. 'before' is the number of bytes used before the
+			// collection, 'survived' is the number of bytes that survived it, and 'time' is the
+			// duration of the collection in microseconds.
+			void adapt(size_t before, size_t survived, size_t time);
+
 			/**
 			 * A chunk managed by a generation. Perhaps this should be moved outside of the generation class.
 			 *
@@ -178,6 +255,22 @@ namespace storm {
 				// chunks marked as 'used'.
 				size_t freeBytes;
 
+				// Number of consecutive collections where this chunk was found to be modified, and
+				// the number of collections this chunk is left without write protection.
+				byte writtenCount;
+				byte unprotectedCount;
+
+				// Called when the chunk has been scanned after being modified. Returns true if the
+				// write barrier should be raised again. See 'hotChunkThreshold'.
+				bool raiseBarrier();
+
+				// Does this chunk contain a single large object? The rest of the chunk is never
+				// used for other allocations, so 'freeBytes' is always zero for these chunks.
+				bool large;
+
+				// Was the large object found during the current collection, but not yet scanned?
+				bool unscanned;
+
 				// Allocate a block inside this chunk. Returns null on failure. 'minFragment' states
 				// how small fragments that are acceptable when splitting blocks. Marks the returned
 				// block as 'in use'. Call 'releaseBlock' to remove the mark.
@@ -194,6 +287,13 @@ namespace storm {
 				// system may have pointers to them. They will, however, be emptied if possible.
 				bool compact(ArenaTicket &ticket, const PinnedSet &pinned);
 
+				// Compact a chunk containing a large object. The object is never moved, so this
+				// only empties the chunk if the object is not pinned.
+				bool compactLarge(ArenaTicket &ticket, const PinnedSet &pinned);
+
+				// Is this chunk empty, i.e. is it a single empty block that is not in use?
+				bool empty() const;
+
 				// Run all finalizers in this chunk.
 				void runAllFinalizers(FinalizerContext &context);
 
@@ -291,6 +391,12 @@ namespace storm {
 			// Note: We use the last element here to keep track of shared objects!
 			vector<PinnedSet> pinnedSets;
 
+			// Copies of 'pinnedSets' for each worker thread, and the threads whose stacks are to
+			// be scanned. Kept here so that we don't need to allocate memory while other threads
+			// are stopped.
+			vector<vector<PinnedSet> > workerPinnedSets;
+			vector<Thread *> rootThreads;
+
 			// Get the minimum size we want our blocks to be when we're splitting them.
 			inline size_t minFragment() const { return blockSize >> 2; }
 
@@ -323,6 +429,37 @@ namespace storm {
 			// Check if a particular object is pinned. Only reasonable to call during an ongoing scan.
 			bool isPinned(void *obj, void *end);
 
+			// Number of chunks with the 'unscanned' flag set.
+			size_t unscannedLarge;
+
+			// Mark a large object as reachable by adding it to the pinned set of its chunk, and
+			// remember to scan it later. Returns false if the object is not a large object.
+			bool markLarge(void *obj, void *end);
+
+			// Scan all large objects that have been marked since the last call. Returns false if
+			// there was nothing to scan.
+			template <class Scanner>
+			bool scanLarge(typename Scanner::Source &source);
+
+			// Move all remaining large objects to the next generation by changing the identifier
+			// of their chunks. Called at the end of a collection.
+			void promoteLarge(ArenaTicket &ticket);
+
+			// Take ownership of a chunk containing a large object from another generation.
+			void adoptLarge(ArenaTicket &ticket, const GenChunk &chunk);
+
+			// Prepare 'workerPinnedSets' and 'rootThreads' for scanning inexact roots. Called
+			// before threads are stopped.
+			void prepareInexactRoots(ArenaTicket &ticket, Workers &workers);
+
+			// Scan all inexact roots and fill 'pinnedSets'. The stacks of the threads are scanned
+			// in parallel.
+			void scanInexactRoots(ArenaTicket &ticket, Workers &workers);
+
+			// Compact all chunks in parallel.
+			void compactChunks(ArenaTicket &ticket, Workers &workers);
+			struct CompactTask;
+
 
 			/**
 			 * Scan a particular GenChunk.
@@ -427,6 +564,37 @@ namespace storm {
 		}
 
 
+		template <class Scanner>
+		bool Generation::scanLarge(typename Scanner::Source &source) {
+			if (unscannedLarge == 0)
+				return false;
+
+			// Scanning may mark more large objects, possibly in chunks we have already passed. The
+			// caller calls us again until there is nothing more to do.
+			for (size_t i = 0; i < chunks.size(); i++) {
+				GenChunk &chunk = chunks[i];
+				if (!chunk.unscanned)
+					continue;
+
+				chunk.unscanned = false;
+				unscannedLarge--;
+
+				// TODO: Forward any errors!
+				Block *block = (Block *)chunk.memory.at;
+				block->scan<Scanner>(source);
+			}
+
+			return true;
+		}
+
+		template <class Scanner>
+		typename Scanner::Result Generation::scanChunkFinal(ArenaTicket &ticket,
+															size_t chunk,
+															GenSet toScan,
+															typename Scanner::Source &source) {
+			return scanFinal<Scanner>(ticket, chunks[chunk], toScan, source);
+		}
+
 		template <class Scanner>
 		typename Scanner::Result Generation::scan(GenChunk &chunk, typename Scanner::Source &source) {
 			Block *end = chunk.memory.end();
@@ -469,6 +637,8 @@ namespace storm {
 
 			// Was this block changed since we last prepared our summary?
 			if (!ticket.anyWrites(chunk.memory)) {
+				chunk.writtenCount = 0;
+
 				// No changes, we can ask the summary!
 				if (chunk.summary.has(toScan)) {
 					return scanImpl<Scanner>(ticket, chunk, toScan, source);
@@ -536,7 +706,8 @@ namespace storm {
 
 			// Update memory protection and remember the references.
 			chunk.summary = summary;
-			ticket.watchWrites(chunk.memory);
+			if (chunk.raiseBarrier())
+				ticket.watchWrites(chunk.memory);
 
 			return r;
 		}
@@ -596,6 +767,16 @@ namespace storm {
 			return r;
 		}
 
+		template <class Fn>
+		void Generation::traverse(Fn fn) {
+			for (size_t i = 0; i < chunks.size(); i++) {
+				GenChunk &chunk = chunks[i];
+				for (Block *at = (Block *)chunk.memory.at; at != (Block *)chunk.memory.end(); at = (Block *)at->mem(at->size)) {
+					at->traverse(fn);
+				}
+			}
+		}
+
 	}
 }
 
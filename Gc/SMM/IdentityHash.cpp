@@ -0,0 +1,273 @@
+#include "stdafx.h"
+#include "IdentityHash.h"
+
+#if STORM_GC == STORM_GC_SMM
+
+#include "Arena.h"
+#include "ArenaTicket.h"
+#include "UpdateFwd.h"
+#include "Core/Hash.h"
+
+namespace storm {
+	namespace smm {
+
+		// Initial size of the index.
+		static const size_t initialIndex = 64;
+
+		// Minimum number of stale bits in the filter before we consider re-creating it.
+		static const size_t minFilterStale = 1024;
+
+		IdentityHash::IdentityHash(Arena &arena) : arena(arena), freeList(0), used(0), filterStale(0) {
+			memset(lists, 0, sizeof(lists));
+			memset(filter, 0, sizeof(filter));
+		}
+
+		bool IdentityHash::tryHash(const void *obj, nat &result) const {
+			// Objects that never move can use their address, and so can objects that are not in
+			// the filter.
+			if (arena.memGeneration((void *)obj) >= nonmovingIdentifier || !filterHas(obj)) {
+				result = ptrHash(obj);
+				return true;
+			}
+
+			return false;
+		}
+
+		nat IdentityHash::hash(LockTicket &, const void *obj) {
+			if (index.empty())
+				return ptrHash(obj);
+
+			size_t slot = findSlot(obj);
+			if (index[slot])
+				return entries[index[slot] - 1].hash;
+			return ptrHash(obj);
+		}
+
+		nat IdentityHash::store(LockTicket &, const void *obj) {
+			byte gen = arena.memGeneration((void *)obj);
+			if (gen >= nonmovingIdentifier)
+				return ptrHash(obj);
+
+			if (index.empty())
+				index.resize(initialIndex, 0);
+
+			size_t slot = findSlot(obj);
+			if (index[slot]) {
+				Entry &e = entries[index[slot] - 1];
+				e.refs++;
+				return e.hash;
+			}
+
+			// Add a new entry. This is where we can allocate memory, not in 'update'.
+			size_t id;
+			if (freeList) {
+				id = freeList - 1;
+				freeList = entries[id].next;
+			} else {
+				id = entries.size();
+				entries.push_back(Entry());
+			}
+
+			Entry &e = entries[id];
+			e.obj = (void *)obj;
+			e.hash = ptrHash(obj);
+			e.refs = 1;
+			e.gen = gen;
+			link(id);
+			used++;
+
+			if (used * 2 > index.size()) {
+				index.resize(index.size() * 2);
+				reindex();
+			} else {
+				index[slot] = id + 1;
+			}
+
+			return e.hash;
+		}
+
+		void IdentityHash::release(LockTicket &, const void *obj) {
+			if (index.empty())
+				return;
+
+			size_t slot = findSlot(obj);
+			if (!index[slot])
+				return;
+
+			Entry &e = entries[index[slot] - 1];
+			if (e.refs > 0)
+				e.refs--;
+
+			// If the object has moved since it was stored, removing the entry would change its
+			// hash. 'update' removes the entry the next time the object moves instead.
+			if (e.refs > 0 || e.hash != ptrHash(obj))
+				return;
+
+			// The entry is still linked into the list of its generation, so it is freed by the
+			// next call to 'update' or 'promoted'.
+			removeIndex(obj);
+			e.obj = null;
+			used--;
+		}
+
+		void IdentityHash::update(ArenaTicket &, const Generation::State &state) {
+			byte gen = state.identifier();
+			size_t at = lists[gen];
+			lists[gen] = 0;
+
+			// Treat the objects as weak references. This updates moved objects and sets dead
+			// objects to null. Note: This never allocates memory.
+			UpdateWeakFwd fix(state);
+			while (at) {
+				size_t id = at - 1;
+				Entry &e = entries[id];
+				at = e.next;
+
+				// Released entry?
+				if (!e.obj) {
+					freeEntry(id);
+					continue;
+				}
+
+				void *obj = e.obj;
+				if (fix.fix1(obj))
+					fix.fix2(&obj);
+
+				if (obj != e.obj) {
+					removeIndex(e.obj);
+					if (e.hash != ptrHash(e.obj))
+						filterStale++;
+
+					// Remove the entry if the object died, or if it moved while no container
+					// contained it.
+					if (!obj || e.refs == 0) {
+						e.obj = null;
+						freeEntry(id);
+						used--;
+						continue;
+					}
+
+					e.obj = obj;
+					index[findSlot(obj)] = id + 1;
+					if (e.hash != ptrHash(obj))
+						filterAdd(obj);
+				}
+
+				e.gen = arena.memGeneration(e.obj);
+				link(id);
+			}
+
+			if (filterStale > max(used, minFilterStale))
+				rebuildFilter();
+		}
+
+		void IdentityHash::promoted(ArenaTicket &, byte from) {
+			size_t at = lists[from];
+			lists[from] = 0;
+
+			while (at) {
+				size_t id = at - 1;
+				Entry &e = entries[id];
+				at = e.next;
+
+				if (!e.obj) {
+					freeEntry(id);
+					continue;
+				}
+
+				e.gen = arena.memGeneration(e.obj);
+				link(id);
+			}
+		}
+
+		void IdentityHash::link(size_t entry) {
+			Entry &e = entries[entry];
+			e.next = lists[e.gen];
+			lists[e.gen] = entry + 1;
+		}
+
+		void IdentityHash::freeEntry(size_t entry) {
+			entries[entry].next = freeList;
+			freeList = entry + 1;
+		}
+
+		size_t IdentityHash::findSlot(const void *obj) const {
+			size_t mask = index.size() - 1;
+			size_t slot = ptrHash(obj) & mask;
+			while (index[slot] && entries[index[slot] - 1].obj != obj)
+				slot = (slot + 1) & mask;
+			return slot;
+		}
+
+		void IdentityHash::removeIndex(const void *obj) {
+			size_t mask = index.size() - 1;
+			size_t hole = findSlot(obj);
+			if (!index[hole])
+				return;
+
+			// Shift later entries in the probe sequence backwards, so that no tombstones are needed.
+			index[hole] = 0;
+			for (size_t at = (hole + 1) & mask; index[at]; at = (at + 1) & mask) {
+				size_t home = ptrHash(entries[index[at] - 1].obj) & mask;
+				// Can the entry at 'at' be moved to 'hole'? Only if its home slot is not in ]hole, at].
+				bool stay = (hole < at) ? (home > hole && home <= at) : (home > hole || home <= at);
+				if (stay)
+					continue;
+
+				index[hole] = index[at];
+				index[at] = 0;
+				hole = at;
+			}
+		}
+
+		void IdentityHash::reindex() {
+			std::fill(index.begin(), index.end(), size_t(0));
+			for (size_t i = 0; i < entries.size(); i++)
+				if (entries[i].obj)
+					index[findSlot(entries[i].obj)] = i + 1;
+		}
+
+		bool IdentityHash::filterHas(const void *obj) const {
+			size_t bit = ptrHash(obj) & (filterBits - 1);
+			return (atomicRead(filter[bit / wordBits]) & (size_t(1) << (bit % wordBits))) != 0;
+		}
+
+		void IdentityHash::filterAdd(const void *obj) {
+			size_t bit = ptrHash(obj) & (filterBits - 1);
+			filter[bit / wordBits] |= size_t(1) << (bit % wordBits);
+		}
+
+		void IdentityHash::rebuildFilter() {
+			memset(filter, 0, sizeof(filter));
+			for (size_t i = 0; i < entries.size(); i++) {
+				const Entry &e = entries[i];
+				if (e.obj && e.hash != ptrHash(e.obj))
+					filterAdd(e.obj);
+			}
+			filterStale = 0;
+		}
+
+		void IdentityHash::fillSummary(MemorySummary &summary) const {
+			summary.bookkeeping += entries.capacity() * sizeof(Entry) + index.capacity() * sizeof(size_t);
+		}
+
+		void IdentityHash::dbg_verify() {
+			size_t count = 0;
+			for (size_t i = 0; i < entries.size(); i++) {
+				const Entry &e = entries[i];
+				if (!e.obj)
+					continue;
+
+				count++;
+				assert(arena.memGeneration(e.obj) < nonmovingIdentifier, L"Entry for an object that never moves!");
+				assert(arena.memGeneration(e.obj) == e.gen, L"Entry in the wrong list!");
+				assert(index[findSlot(e.obj)] == i + 1, L"The identity hash index is broken!");
+				assert(e.hash == ptrHash(e.obj) || filterHas(e.obj), L"Moved object not in the filter!");
+			}
+			assert(count == used, L"Wrong number of used entries!");
+		}
+
+	}
+}
+
+#endif
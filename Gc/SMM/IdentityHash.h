@@ -0,0 +1,161 @@
+#pragma once
+
+#if STORM_GC == STORM_GC_SMM
+
+#include "Generation.h"
+#include "Gc/MemorySummary.h"
+
+namespace storm {
+	namespace smm {
+
+		class Arena;
+		class LockTicket;
+		class ArenaTicket;
+
+		/**
+		 * Stable identity hashes for objects in the arena.
+		 *
+		 * The hash of an object is computed from its address. Containers that rely on the hash
+		 * call 'store' when they insert an object, which adds an entry for the object to a side
+		 * table. The entry is keyed by the current location of the object, and remembers the hash
+		 * the object had when it was stored. Entries count the containers that contain the object,
+		 * and containers call 'release' when they remove it. When no container contains an object,
+		 * its entry is removed, either immediately if the object has not moved since it was stored,
+		 * or the next time the object moves. This way, the hash of an object only ever changes when
+		 * the object moves, which lets users of unstored hashes rely on a GcWatch. Containers that
+		 * die without removing their elements leave entries until the objects die. The collector treats the keys in the table as weak
+		 * references: entries of objects that were moved are updated to the new location, and
+		 * entries of objects that died are removed. As such, the table only contains objects that
+		 * have been stored at some point and are still alive. Objects that were never stored are
+		 * not in any container, so their hash only needs to be valid until they move.
+		 *
+		 * The hash of most objects is still the hash of their current address, either because
+		 * they never moved or because they were never stored. To avoid taking the arena lock in
+		 * that case, the table keeps a filter of the addresses of objects whose hash differs from
+		 * their address. The filter is only modified while other threads are stopped, so 'tryHash'
+		 * reads it without a lock. An object that is being hashed is referred to from the stack of
+		 * the hashing thread, and is thereby pinned while the hash is computed.
+		 *
+		 * Objects that never move (i.e. nonmoving objects and memory outside of the arena) are
+		 * hashed by their address directly, without entries in the table.
+		 *
+		 * The entries are linked into one list for each generation, so that a collection only
+		 * needs to visit the entries of the generation being collected. 'index' is an
+		 * open-addressed hash table of indices into 'entries'. This lets the collector update the
+		 * table without allocating memory while other threads are stopped.
+		 */
+		class IdentityHash {
+		public:
+			// Create.
+			IdentityHash(Arena &arena);
+
+			// Get the hash of an object without taking the lock, if possible. Returns false if
+			// 'hash' needs to be called.
+			bool tryHash(const void *obj, nat &result) const;
+
+			// Get the hash of an object. Does not add an entry for the object.
+			nat hash(LockTicket &ticket, const void *obj);
+
+			// Get the hash of an object, and make sure it does not change when the object is
+			// moved.
+			nat store(LockTicket &ticket, const void *obj);
+
+			// Balance a call to 'store' when a container no longer contains 'obj'.
+			void release(LockTicket &ticket, const void *obj);
+
+			// Update the table after the generation described by 'state' has been collected. Must
+			// be called while forwarders are still intact, i.e. before the generation is compacted.
+			void update(ArenaTicket &ticket, const Generation::State &state);
+
+			// Move entries for objects that were moved from the generation 'from' to another
+			// generation without changing their address (i.e. large objects).
+			void promoted(ArenaTicket &ticket, byte from);
+
+			// Fill memory summary.
+			void fillSummary(MemorySummary &summary) const;
+
+			// Verify the table.
+			void dbg_verify();
+
+		private:
+			// No copying!
+			IdentityHash(const IdentityHash &o);
+			IdentityHash &operator =(const IdentityHash &o);
+
+			// The arena.
+			Arena &arena;
+
+			// An entry in the table.
+			struct Entry {
+				// The object. Null if the entry is free, or if it was released but is still linked
+				// into the list of its generation.
+				void *obj;
+
+				// Its hash.
+				nat hash;
+
+				// Number of containers that contain the object.
+				nat refs;
+
+				// Generation of the object, as of the last time the entry was updated.
+				byte gen;
+
+				// Next entry in the same list, plus one. Zero means the end of the list.
+				size_t next;
+			};
+
+			// All entries. Free entries are linked together, starting at 'freeList'.
+			vector<Entry> entries;
+
+			// First free entry in 'entries', plus one.
+			size_t freeList;
+
+			// Number of used entries.
+			size_t used;
+
+			// First entry for each generation, plus one.
+			size_t lists[identifierMaxVal];
+
+			// Index into 'entries', plus one. Zero means that the slot is empty. The size is
+			// always a power of two, and at least twice the number of used entries.
+			vector<size_t> index;
+
+			// Size of the filter, in bits.
+			static const size_t filterBits = size_t(1) << 16;
+			static const size_t wordBits = sizeof(size_t) * CHAR_BIT;
+
+			// Filter of addresses of objects whose hash is not the hash of their address. Bits
+			// are never cleared individually, so the filter may contain bits for objects that
+			// have died or moved.
+			size_t filter[filterBits / wordBits];
+
+			// Number of bits set in 'filter' that are no longer needed.
+			size_t filterStale;
+
+			// Find the slot in 'index' for 'obj', or the empty slot where it should be inserted.
+			size_t findSlot(const void *obj) const;
+
+			// Remove 'obj' from 'index'.
+			void removeIndex(const void *obj);
+
+			// Re-create 'index' from 'entries'.
+			void reindex();
+
+			// Add 'entry' to the list of its generation.
+			void link(size_t entry);
+
+			// Add 'entry' to the free list. Assumes it is not in any other list.
+			void freeEntry(size_t entry);
+
+			// Check/set the bit for 'obj' in the filter.
+			bool filterHas(const void *obj) const;
+			void filterAdd(const void *obj);
+
+			// Re-create the filter from 'entries'.
+			void rebuildFilter();
+		};
+
+	}
+}
+
+#endif
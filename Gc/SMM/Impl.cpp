@@ -24,11 +24,33 @@ namespace storm {
 		MB(100), // Persistent generation.
 	};
 
-	GcImpl::GcImpl(size_t initialArenaSize, Nat finalizationInterval)
-		: arena(initialArenaSize, generations, ARRAY_COUNT(generations)) {
+	// Use the generations in 'params'?
+	static bool useGenerations(const GcParams &params) {
+		size_t count = params.generations.size();
+		return count >= GcParams::minGenerations && count <= GcParams::maxGenerations;
+	}
+
+	// Pick the generations to use.
+	static const size_t *genSizes(const GcParams &params) {
+		if (useGenerations(params))
+			return &params.generations[0];
+		return generations;
+	}
+
+	static size_t genCount(const GcParams &params) {
+		if (useGenerations(params))
+			return params.generations.size();
+		return ARRAY_COUNT(generations);
+	}
+
+	GcImpl::GcImpl(size_t initialArenaSize, Nat finalizationInterval, const GcParams &params)
+		: arena(initialArenaSize, genSizes(params), genCount(params)) {
 #ifdef STORM_GC_EH_CALLBACK
 #error "SMM does not support EH callbacks as needed by this platform!"
 #endif
+		if (!params.generations.empty() && !useGenerations(params))
+			WARNING(L"Ignoring " << params.generations.size() << L" generation sizes, using the defaults instead.");
+		arena.params(params);
 	}
 
 	void GcImpl::destroy() {
@@ -44,7 +66,19 @@ namespace storm {
 	}
 
 	Bool GcImpl::collect(Nat time) {
-		return false;
+		return arena.collect(time);
+	}
+
+	Nat GcImpl::collections() {
+		return Nat(arena.collections());
+	}
+
+	GcParams GcImpl::params() {
+		return arena.params();
+	}
+
+	void GcImpl::params(const GcParams &params) {
+		arena.params(params);
 	}
 
 	void GcImpl::throwError(const wchar *message) {
@@ -288,8 +322,40 @@ namespace storm {
 		// arena.endRamp();
 	}
 
+	struct WalkData {
+		GcImpl::WalkCb fn;
+		void *data;
+	};
+
+	static void walkFn(void *addr, void *p) {
+		WalkData *d = (WalkData *)p;
+		if (fmt::objIsSpecial(fmt::fromClient(addr)))
+			return;
+
+		const GcType *type = GcImpl::typeOf(addr);
+		if (!type)
+			return;
+
+		switch (type->kind) {
+		case GcType::tFixed:
+		case GcType::tFixedObj:
+		case GcType::tType:
+			// Objects, let them through!
+			(*d->fn)((RootObject *)addr, d->data);
+			break;
+		}
+	}
+
 	void GcImpl::walkObjects(WalkCb fn, void *param) {
-		assert(false, L"Walking objects is not yet supported!");
+		WalkData d = {
+			fn,
+			param
+		};
+		arena.walk(&walkFn, &d);
+	}
+
+	Bool GcImpl::inHeap(const void *addr) {
+		return arena.has((void *)addr);
 	}
 
 	class SmmRoot : public GcRoot {
@@ -376,6 +442,26 @@ namespace storm {
 		return new (alloc(&SMMWatch::type)) SMMWatch(*this);
 	}
 
+	Bool GcImpl::stableIdentityHash() {
+		return true;
+	}
+
+	Nat GcImpl::identityHash(const void *obj) {
+		return arena.identityHash(obj);
+	}
+
+	Nat GcImpl::storeIdentityHash(const void *obj) {
+		return arena.storeIdentityHash(obj);
+	}
+
+	void GcImpl::releaseIdentityHash(const void *obj) {
+		arena.releaseIdentityHash(obj);
+	}
+
+	GcTelemetry *GcImpl::telemetry() {
+		return &arena.telemetry;
+	}
+
 	void GcImpl::checkMemory() {
 		arena.dbg_verify();
 	}
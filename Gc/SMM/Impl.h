@@ -7,6 +7,8 @@
 #include "Allocator.h"
 #include "Gc/License.h"
 #include "Gc/Root.h"
+#include "Gc/GcParams.h"
+#include "Gc/Telemetry.h"
 
 namespace storm {
 
@@ -20,7 +22,7 @@ namespace storm {
 	class GcImpl {
 	public:
 		// Create.
-		GcImpl(size_t initialArenaSize, Nat finalizationInterval);
+		GcImpl(size_t initialArenaSize, Nat finalizationInterval, const GcParams &params);
 
 		// Destroy. This function is always called, but may be called twice.
 		void destroy();
@@ -34,6 +36,13 @@ namespace storm {
 		// Spend approx. 'time' ms on a GC. Return 'true' if there is more work to be done.
 		Bool collect(Nat time);
 
+		// Number of collections performed so far.
+		Nat collections();
+
+		// Get/set tuning parameters.
+		GcParams params();
+		void params(const GcParams &params);
+
 		// Type we use to store data with a thread.
 		typedef smm::Thread *ThreadData;
 
@@ -94,6 +103,9 @@ namespace storm {
 		typedef void (*WalkCb)(RootObject *inspect, void *param);
 		void walkObjects(WalkCb fn, void *param);
 
+		// Is 'addr' inside memory managed by this GC? Safe to call from inside 'walkObjects'.
+		Bool inHeap(const void *addr);
+
 		typedef GcRoot Root;
 
 		// Create a root object.
@@ -105,6 +117,21 @@ namespace storm {
 		// Create a watch object (on a GC:d heap, no need to destroy it).
 		GcWatch *createWatch();
 
+		// Are identity hashes stable, i.e. unaffected by objects moving?
+		Bool stableIdentityHash();
+
+		// Get the identity hash of an object.
+		Nat identityHash(const void *obj);
+
+		// Get the identity hash of an object, and keep it stable when the object moves.
+		Nat storeIdentityHash(const void *obj);
+
+		// Tell the GC that a container no longer contains 'obj'.
+		void releaseIdentityHash(const void *obj);
+
+		// Get telemetry about collections, or null if not supported.
+		GcTelemetry *telemetry();
+
 		// Check memory consistency. Note: Enable checking in 'Gc.cpp' for this to work.
 		void checkMemory();
 		void checkMemory(const void *object, bool recursive);
@@ -13,13 +13,25 @@ namespace storm {
 		 * Nonmoving.
 		 */
 
-		Nonmoving::Nonmoving(Arena &arena) : arena(arena), lastChunk(0), memMin(0), memMax(1), toFinalize(null) {}
+		Nonmoving::Nonmoving(Arena &arena) : arena(arena), toFinalize(null), memMin(0), memMax(1) {
+			for (nat i = 0; i < classCount; i++) {
+				partial[i] = null;
+				spare[i] = null;
+			}
+		}
 
 		Nonmoving::~Nonmoving() {
 			for (size_t i = 0; i < chunks.size(); i++)
 				arena.freeChunk(chunks[i]->chunk());
 		}
 
+		nat Nonmoving::findClass(size_t size) {
+			for (nat i = 0; i < classCount; i++)
+				if (classSize(i) >= size)
+					return i;
+			return classCount;
+		}
+
 		void *Nonmoving::alloc(LockTicket &ticket, const GcType *type) {
 			bool finalizer = type->finalizer != null;
 			size_t size = fmt::sizeObj(type);
@@ -27,6 +39,9 @@ namespace storm {
 			// If the object has a finalizer, we might want to allocate a bit of extra memory at the
 			// end, so that we can make a list of objects in need of finalization!
 			void *mem = allocMem(finalizer ? (size + sizeof(void *)) : size);
+			if (!mem)
+				return null;
+
 			void *result = fmt::initObj(mem, type, size);
 
 			if (finalizer)
@@ -35,49 +50,72 @@ namespace storm {
 		}
 
 		void *Nonmoving::allocMem(size_t size) {
+			nat sizeClass = findClass(size + sizeof(Header));
+
 			// Disallow large allocations. We won't do well with them!
-			if (size > vmAllocMinSize / 2) {
+			if (size > vmAllocMinSize / 2 || sizeClass >= classCount) {
 				dbg_assert(false, L"Trying to allocate a too large object as a non-moving object.");
 				return null;
 			}
 
-			if (lastChunk >= chunks.size())
-				lastChunk = 0;
-
-			for (size_t i = 0; i < chunks.size(); i++) {
-				Chunk *chunk = chunks[lastChunk];
-				if (void *alloc = chunk->alloc(size))
-					return alloc;
-
-				if (++lastChunk >= chunks.size())
-					lastChunk = 0;
+			Chunk *chunk = partial[sizeClass];
+			if (!chunk) {
+				// Use the spare chunk if we have one.
+				chunk = spare[sizeClass];
+				if (chunk) {
+					spare[sizeClass] = null;
+					link(chunk);
+				} else {
+					chunk = allocChunk(sizeClass);
+					if (!chunk)
+						return null;
+				}
 			}
 
-			size_t newChunk = allocChunk();
-			if (newChunk >= chunks.size())
-				return null;
-
-			lastChunk = newChunk;
-			if (void *alloc = chunks[newChunk]->alloc(size))
-				return alloc;
-
-			return null;
+			fmt::Obj *result = chunk->alloc();
+			if (chunk->full())
+				unlink(chunk);
+			return result;
 		}
 
-		size_t Nonmoving::allocChunk() {
+		Nonmoving::Chunk *Nonmoving::allocChunk(nat sizeClass) {
 			smm::Chunk alloc = arena.allocChunk(vmAllocMinSize, nonmovingIdentifier);
 			if (alloc.empty())
-				return chunks.size();
+				return null;
 
-			size_t pos = insertSorted(chunks, Chunk::create(alloc), PtrCompare());
-			lastChunk = pos;
+			dbg_assert(alloc.size == vmAllocMinSize, L"Expected chunks to be exactly one piece.");
+
+			Chunk *chunk = new (alloc.at) Chunk(sizeClass);
+			chunks.push_back(chunk);
+			link(chunk);
 
 			// Update address range.
-			{
-				size_t low = size_t(alloc.at);
-				size_t high = size_t(alloc.end());
+			size_t low = size_t(alloc.at);
+			size_t high = size_t(alloc.end());
+			if (chunks.size() == 1) {
+				memMin = low;
+				memMax = high;
+			} else {
+				memMin = min(memMin, low);
+				memMax = max(memMax, high);
+			}
+
+			return chunk;
+		}
 
-				if (chunks.size() == 1) {
+		void Nonmoving::freeChunk(Chunk *chunk) {
+			ChunkList::iterator pos = std::find(chunks.begin(), chunks.end(), chunk);
+			dbg_assert(pos != chunks.end(), L"Trying to free a chunk we don't own!");
+			chunks.erase(pos);
+			arena.freeChunk(chunk->chunk());
+
+			// Update address range.
+			memMin = 0;
+			memMax = 1;
+			for (size_t i = 0; i < chunks.size(); i++) {
+				size_t low = size_t(chunks[i]);
+				size_t high = low + vmAllocMinSize;
+				if (i == 0) {
 					memMin = low;
 					memMax = high;
 				} else {
@@ -85,21 +123,66 @@ namespace storm {
 					memMax = max(memMax, high);
 				}
 			}
+		}
 
-			// TODO: Update range of objects, or other metadata?
+		void Nonmoving::link(Chunk *chunk) {
+			Chunk *&head = partial[chunk->sizeClass];
+			chunk->prev = null;
+			chunk->next = head;
+			if (head)
+				head->prev = chunk;
+			head = chunk;
+			chunk->listed = true;
+		}
+
+		void Nonmoving::unlink(Chunk *chunk) {
+			if (chunk->prev)
+				chunk->prev->next = chunk->next;
+			else
+				partial[chunk->sizeClass] = chunk->next;
+			if (chunk->next)
+				chunk->next->prev = chunk->prev;
+
+			chunk->prev = null;
+			chunk->next = null;
+			chunk->listed = false;
+		}
+
+		bool Nonmoving::update(Chunk *chunk) {
+			nat sizeClass = chunk->sizeClass;
+
+			// Nothing to do for the spare chunk.
+			if (chunk == spare[sizeClass])
+				return false;
+
+			if (chunk->empty()) {
+				if (chunk->listed)
+					unlink(chunk);
+
+				// Keep it as a spare if we don't have one already.
+				if (!spare[sizeClass]) {
+					spare[sizeClass] = chunk;
+					return false;
+				}
+
+				freeChunk(chunk);
+				return true;
+			}
 
-			return pos;
+			if (!chunk->full() && !chunk->listed)
+				link(chunk);
+			return false;
 		}
 
 		void Nonmoving::free(LockTicket &, void *mem) {
-			ChunkList::iterator pos = std::lower_bound(chunks.begin(), chunks.end(), mem, PtrCompare());
-			if (pos != chunks.end()) {
-				(*pos)->free(this, fmt::fromClient(mem));
-			} else {
+			if (arena.memGeneration(mem) != nonmovingIdentifier) {
 				dbg_assert(false, L"Trying to 'free' nonmoving memory from a different pool!");
+				return;
 			}
 
-			// TODO: We would like to reclaim memory at some point! Remember to update 'memMin' and 'memMax'!
+			Chunk *chunk = chunkOf(mem);
+			if (chunk->free(this, fmt::fromClient(mem)))
+				update(chunk);
 		}
 
 		void Nonmoving::runFinalizers(FinalizerContext &context) {
@@ -148,24 +231,15 @@ namespace storm {
 				chunks[i]->runFinalizers(context);
 		}
 
-		struct Sweeper {
-			Nonmoving &owner;
-			ArenaTicket &ticket;
-
-			Sweeper(Nonmoving &owner, ArenaTicket &ticket) : owner(owner), ticket(ticket) {}
+		void Nonmoving::sweep(ArenaTicket &ticket) {
+			for (size_t i = 0; i < chunks.size(); i++) {
+				Chunk *chunk = chunks[i];
+				chunk->sweep(this);
 
-			void operator ()(void *obj) const {
-				Nonmoving::Header *header = Nonmoving::Header::fromClient(obj);
-				if (!header->hasFlag(Nonmoving::Header::fMarked)) {
-					// Note: This is fine, since it will not break any headers.
-					owner.free(ticket, obj);
-				}
+				// Note: 'update' removes the chunk from 'chunks' if it is freed.
+				if (update(chunk))
+					i--;
 			}
-		};
-
-		void Nonmoving::sweep(ArenaTicket &ticket) {
-			// Just call 'free' on all allocations that should be freed!
-			traverse(Sweeper(*this, ticket));
 		}
 
 		void Nonmoving::fillSummary(MemorySummary &summary) const {
@@ -174,8 +248,23 @@ namespace storm {
 		}
 
 		void Nonmoving::dbg_verify() {
-			for (size_t i = 0; i < chunks.size(); i++)
-				chunks[i]->dbg_verify();
+			for (size_t i = 0; i < chunks.size(); i++) {
+				Chunk *chunk = chunks[i];
+				chunk->dbg_verify();
+
+				assert(chunkOf(chunk->header(chunk->slots - 1)) == chunk, L"Chunk lookup is broken!");
+				assert(size_t(chunk) >= memMin && size_t(chunk) + vmAllocMinSize <= memMax, L"Chunk outside of the address range!");
+
+				bool shouldList = !chunk->full() && chunk != spare[chunk->sizeClass];
+				assert(chunk->listed == shouldList, L"Chunk is not properly linked into the partial list!");
+			}
+
+			for (nat i = 0; i < classCount; i++) {
+				for (Chunk *at = partial[i]; at; at = at->next)
+					assert(at->sizeClass == i && at->listed, L"Partial list contains invalid chunks!");
+				if (spare[i])
+					assert(spare[i]->empty(), L"The spare chunk is not empty!");
+			}
 		}
 
 		void Nonmoving::dbg_dump() {
@@ -191,49 +280,32 @@ namespace storm {
 		 * Chunk.
 		 */
 
-		Nonmoving::Chunk::Chunk(size_t size) : size(size), lastAlloc(0) {
-			Header *first = header(0);
-			first->makeFree(size - sizeof(Header));
-		}
+		Nonmoving::Chunk::Chunk(nat sizeClass)
+			: sizeClass(sizeClass), slotSize(classSize(sizeClass)), used(0), firstFree(null),
+			  prev(null), next(null), listed(false) {
 
-		fmt::Obj *Nonmoving::Chunk::alloc(size_t size) {
-			if (fmt::Obj *r = allocRange(size, lastAlloc, this->size))
-				return r;
-			if (fmt::Obj *r = allocRange(size, 0, lastAlloc))
-				return r;
+			slots = (vmAllocMinSize - sizeof(Chunk)) / slotSize;
 
-			return null;
+			// Link all slots together, with the first one first.
+			for (size_t i = slots; i > 0; i--) {
+				Header *h = header(i - 1);
+				h->makeFree(slotSize - sizeof(Header));
+				*(Header **)h->object() = firstFree;
+				firstFree = h;
+			}
 		}
 
-		fmt::Obj *Nonmoving::Chunk::allocRange(size_t size, size_t from, size_t to) {
-			size_t at = from;
-			while (at < to) {
-				Header *o = header(at);
-
-				if (o->hasFlag(Header::fFree)) {
-					// Since we might not have done so previously, merge with future free blocks!
-					mergeFree(o);
-
-					size_t free = o->size();
-
-					if (free >= size) {
-						// Split it?
-						if (free > size + sizeof(Header) * 3) { // Note: the '3' is a bit arbitrary.
-							Header *newObj = header(at + size + sizeof(Header));
-							newObj->makeFree(free - size - sizeof(Header));
-							o->size(size);
-						}
-
-						lastAlloc = at;
-						o->clearFlag(Header::fFree);
-						return o->object();
-					}
-				}
+		fmt::Obj *Nonmoving::Chunk::alloc() {
+			Header *h = firstFree;
+			if (!h)
+				return null;
 
-				at += o->size() + sizeof(Header);
-			}
+			firstFree = *(Header **)h->object();
+			used++;
 
-			return null;
+			h->data = 0;
+			h->size(slotSize - sizeof(Header));
+			return h->object();
 		}
 
 		bool Nonmoving::Chunk::free(Nonmoving *owner, fmt::Obj *obj) {
@@ -251,31 +323,31 @@ namespace storm {
 				return false;
 			} else {
 				// Nothing more needs to be done. We can just free it now.
-				h->setFlag(Header::fFree);
-
-				// Merge any free blocks that follow us!
-				mergeFree(h);
+				h->makeFree(slotSize - sizeof(Header));
+				*(Header **)h->object() = firstFree;
+				firstFree = h;
+				used--;
 
 				return true;
 			}
 		}
 
-		void Nonmoving::Chunk::mergeFree(Header *first) {
-			size_t at = offset(first);
-			do {
-				// Skip ahead to the next one.
-				at += header(at)->size() + sizeof(Header);
-				// Until the end of the chunk, or until we find a non-free chunk.
-			} while (at < size && header(at)->hasFlag(Header::fFree));
+		void Nonmoving::Chunk::sweep(Nonmoving *owner) {
+			for (size_t i = 0; i < slots; i++) {
+				Header *h = header(i);
+				if (h->hasFlag(Header::fFree | Header::fFinalize))
+					continue;
 
-			first->makeFree(at - offset(first) - sizeof(Header));
+				if (!h->hasFlag(Header::fMarked))
+					free(owner, h->object());
+			}
 		}
 
 		void Nonmoving::Chunk::runFinalizers(FinalizerContext &context) {
 			os::Thread thread = os::Thread::invalid;
 
-			for (size_t at = 0; at < size; at += header(at)->size() + sizeof(Header)) {
-				Header *h = header(at);
+			for (size_t i = 0; i < slots; i++) {
+				Header *h = header(i);
 				if (h->hasFlag(Header::fFree))
 					continue;
 
@@ -291,13 +363,13 @@ namespace storm {
 		}
 
 		void Nonmoving::Chunk::fillSummary(MemorySummary &summary) const {
+			size_t size = vmAllocMinSize - sizeof(Chunk);
 			summary.allocated += size;
-			summary.bookkeeping += sizeof(Chunk);
-
-			for (size_t at = 0; at < size; at += header(at)->size() + sizeof(Header)) {
-				summary.bookkeeping += sizeof(Header);
+			summary.bookkeeping += sizeof(Chunk) + slots*sizeof(Header);
+			summary.fragmented += size - slots*slotSize;
 
-				const Header *h = header(at);
+			for (size_t i = 0; i < slots; i++) {
+				const Header *h = header(i);
 				if (h->hasFlag(Header::fFree))
 					summary.free += h->size();
 				else
@@ -306,39 +378,36 @@ namespace storm {
 		}
 
 		void Nonmoving::Chunk::dbg_verify() {
-			bool lastFound = false;
-			size_t at = 0;
-			while (at < size) {
-				Header *h = header(at);
-				assert(h->size() > 0, L"Blocks with size zero should not exist!");
+			size_t free = 0;
+			for (size_t i = 0; i < slots; i++) {
+				Header *h = header(i);
+				assert(h->size() == slotSize - sizeof(Header), L"Slots of incorrect size found!");
 
-				if (!h->hasFlag(Header::fFree))
+				if (h->hasFlag(Header::fFree))
+					free++;
+				else
 					assert(h->size() >= fmt::objSize(h->object()), L"Not enough space is allocated for an object!");
+			}
 
-				lastFound |= lastAlloc == at;
-
-				at += h->size() + sizeof(Header);
+			size_t listed = 0;
+			for (Header *at = firstFree; at; at = *(Header **)at->object()) {
+				assert(at->hasFlag(Header::fFree), L"The free list contains an allocated slot!");
+				listed++;
 			}
 
-			assert(at == size, L"A chunk is overfilled!");
-			assert(lastFound, L"lastAlloc does not refer to a valid object!");
+			assert(free == slots - used, L"The number of used slots is incorrect!");
+			assert(listed == free, L"Not all free slots are in the free list!");
 		}
 
 		void Nonmoving::Chunk::dbg_dump() {
-			PLN(L"Chunk at " << (void *)this << L", " << size << L" bytes:");
-			for (size_t at = 0; at < size; at += header(at)->size() + sizeof(Header)) {
-				if (at == lastAlloc)
-					PNN(L"-> ");
-				else
-					PNN(L"   ");
+			PLN(L"Chunk at " << (void *)this << L", " << slots << L" slots of " << slotSize
+				<< L" bytes, " << used << L" used:");
+			for (size_t i = 0; i < slots; i++) {
+				Header *h = header(i);
+				if (h->hasFlag(Header::fFree))
+					continue;
 
-				Header *h = header(at);
-				PNN((void *)h << L", " << h->size() << L" bytes, ");
-				if (h->hasFlag(Header::fFree)) {
-					PLN(L"free");
-				} else {
-					PLN(L"allocated");
-				}
+				PLN(L"   " << (void *)h << L", " << fmt::objSize(h->object()) << L" bytes");
 			}
 		}
 
@@ -27,6 +27,11 @@ namespace storm {
 		 * allocations in order to store necessary book-keeping information, and they require a
 		 * slower allocation protocol compared to regular allocations.
 		 *
+		 * Allocations are divided into size classes, and each chunk only contains objects from a
+		 * single size class. This means that objects in a chunk are placed in fixed-size slots, so
+		 * that freed memory is easily re-used by later allocations of a similar size, and chunks
+		 * that become empty are returned to the VMAlloc.
+		 *
 		 * Finally, we don't support "too large" allocations. We only request memory in the chunk
 		 * size supported by the underlying VMAlloc, and don't attempt to accommodate space for
 		 * allocations larger than that. Large allocations would require additional effort in order
@@ -91,15 +96,12 @@ namespace storm {
 				return result;
 			}
 
-			// Scan all pinned objects.
+			// Scan all pinned objects. Note: Also clears the marks of objects that are not pinned.
 			template <class Scanner>
 			typename Scanner::Result scanPinned(const PinnedSet &pinned, typename Scanner::Source &source) {
 				typename Scanner::Result result = typename Scanner::Result();
 				for (size_t i = 0; i < chunks.size(); i++) {
 					Chunk *chunk = chunks[i];
-					if (!pinned.has(chunk, chunk->mem(chunk->size)))
-						break;
-
 					result = chunk->scanPinned<Scanner>(pinned, source);
 					if (result != typename Scanner::Result())
 						break;
@@ -112,7 +114,13 @@ namespace storm {
 			typename Scanner::Result scanSweep(typename Scanner::Source &source) {
 				typename Scanner::Result result = typename Scanner::Result();
 				for (size_t i = 0; i < chunks.size(); i++) {
-					result = chunks[i]->scanSweep<Scanner>(this, source);
+					Chunk *chunk = chunks[i];
+					result = chunk->scanSweep<Scanner>(this, source);
+
+					// Note: 'update' removes the chunk from 'chunks' if it is freed.
+					if (update(chunk))
+						i--;
+
 					if (result != typename Scanner::Result())
 						break;
 				}
@@ -211,64 +219,60 @@ namespace storm {
 				// 'fFinalize' is set.
 				inline Header *next() const {
 					const byte *me = (const byte *)this;
-					return *(Header *const*)(me + size() - sizeof(void *));
+					return *(Header *const*)(me + sizeof(Header) + size() - sizeof(void *));
 				}
 				inline void next(Header *v) {
 					byte *me = (byte *)this;
-					*(Header **)(me + size() - sizeof(void *)) = v;
+					*(Header **)(me + sizeof(Header) + size() - sizeof(void *)) = v;
 				}
 			};
 
 		private:
-			// A chunk of nonmoving allocations. Allocated as a header in the actual allocation.
+			// A chunk of nonmoving allocations. Allocated as a header in the actual allocation. Each
+			// chunk is exactly one piece from the VMAlloc, and is divided into slots of equal
+			// size. Each slot starts with a Header, and free slots are linked together through the
+			// memory that would otherwise contain the object.
 			class Chunk {
 			public:
-				// Create, with a given size. The size excludes the header.
-				Chunk(size_t size);
+				// Create, for a given size class.
+				Chunk(nat sizeClass);
 
-				// The size of this chunk, excluding the header.
-				const size_t size;
+				// Size class and size of each slot in this chunk, including the header.
+				const nat sizeClass;
+				const size_t slotSize;
 
-				// Last allocation (offset). We continue searching from here to avoid having to
-				// traverse the entire chunk each time.
-				size_t lastAlloc;
+				// Number of slots in this chunk, and the number of slots that are in use.
+				size_t slots;
+				size_t used;
 
-				// Get a smm::Chunk describing this chunk. Useful for deallocation!
-				inline smm::Chunk chunk() {
-					return smm::Chunk(this, size + sizeof(Chunk));
-				}
+				// First free slot.
+				Header *firstFree;
 
-				// Create a new chunk from an smm::Chunk.
-				static inline Chunk *create(smm::Chunk chunk) {
-					return new (chunk.at) Chunk(chunk.size - sizeof(Chunk));
-				}
+				// Previous and next chunk in the list of partially used chunks of the same size
+				// class. Only valid if 'listed' is true.
+				Chunk *prev;
+				Chunk *next;
+				bool listed;
 
-				// Get a particular byte.
-				void *mem(size_t offset) {
-					return (byte *)this + sizeof(Chunk) + offset;
-				}
-				const void *mem(size_t offset) const {
-					return (const byte *)this + sizeof(Chunk) + offset;
+				// Get a smm::Chunk describing this chunk. Useful for deallocation!
+				inline smm::Chunk chunk() {
+					return smm::Chunk(this, vmAllocMinSize);
 				}
 
-				// Get a Header at a specific offset.
-				Header *header(size_t offset) {
-					return (Header *)mem(offset);
+				// Get the header of a particular slot.
+				inline Header *header(size_t slot) {
+					return (Header *)((byte *)this + sizeof(Chunk) + slot*slotSize);
 				}
-				const Header *header(size_t offset) const {
-					return (const Header *)mem(offset);
+				inline const Header *header(size_t slot) const {
+					return (const Header *)((const byte *)this + sizeof(Chunk) + slot*slotSize);
 				}
 
-				// Compute the offset of a header.
-				size_t offset(Header *header) {
-					byte *q = (byte *)header;
-					byte *start = (byte *)this + sizeof(Chunk);
-					return q - start;
-				}
+				// Full or empty?
+				inline bool full() const { return used == slots; }
+				inline bool empty() const { return used == 0; }
 
-				// Allocate memory in this chunk. Assumes 'lock' is held, and arranges for it to be
-				// released if the reservation succeeds.
-				fmt::Obj *alloc(size_t size);
+				// Allocate a slot in this chunk. Returns null if the chunk is full.
+				fmt::Obj *alloc();
 
 				// Free memory from this chunk. Assumes that the pointer was previously allocated
 				// with 'alloc'. Expected to be called from inside the GC, and not explicitly from
@@ -278,6 +282,9 @@ namespace storm {
 				// finalization.
 				bool free(Nonmoving *owner, fmt::Obj *obj);
 
+				// Free all unmarked objects.
+				void sweep(Nonmoving *owner);
+
 				// Run all finalizers in this block.
 				void runFinalizers(FinalizerContext &context);
 
@@ -305,36 +312,31 @@ namespace storm {
 
 				// Output a summary of this chunk.
 				void dbg_dump();
-
-			private:
-				// Reserve an object inside the specified address range.
-				fmt::Obj *allocRange(size_t size, size_t from, size_t to);
-
-				// Merge this block, which is assumed to be free, with any free blocks directly ahead of it.
-				void mergeFree(Header *start);
 			};
 
-			// Note: Compares with the *end* of chunks, so that lower_bound returns the interesting
-			// element directly, rather than us having to step back one step each time.
-			struct PtrCompare {
-				inline bool operator ()(const Chunk *a, const void *ptr) const {
-					return size_t(a->mem(a->size)) < size_t(ptr);
-				}
-
-				inline bool operator ()(const Chunk *a, const Chunk *b) const {
-					return size_t(a) < size_t(b);
-				}
+			// Number of size classes, and the size of the slots (including the header) in each
+			// class. The sizes increase by a factor of 1.5 or 1.33, starting at 32 bytes.
+			enum { classCount = 22 };
+			static inline size_t classSize(nat sizeClass) {
+				return size_t((sizeClass & 0x1) ? 48 : 32) << (sizeClass >> 1);
+			}
 
-			};
+			// Find the smallest size class with slots of at least 'size' bytes. Returns
+			// 'classCount' if the size is too large.
+			static nat findClass(size_t size);
 
-			// All chunks managed by us. Each one is generally the size of one page from VMAlloc,
-			// but don't assume that. Sorted by addresses of the chunks.
+			// All chunks managed by us, in no particular order. Only used for traversal. Use
+			// 'chunkOf' to find the chunk of a particular object.
 			typedef vector<Chunk *> ChunkList;
 			ChunkList chunks;
 
-			// Last chunk used. The next allocation will be re-tried there since it is likely to fit
-			// the next allocation as well!
-			size_t lastChunk;
+			// Partially used chunks in each size class. These are the chunks we allocate from.
+			Chunk *partial[classCount];
+
+			// An empty chunk in each size class that we keep around rather than returning it to
+			// the VMAlloc immediately, so that a few allocations that come and go do not cause us
+			// to allocate and free chunks all the time.
+			Chunk *spare[classCount];
 
 			// List of finalizers ready to be executed. Accessed from outside the arena lock, so
 			// care needs to be taken when manipulating this!
@@ -343,12 +345,30 @@ namespace storm {
 			// Min- and max addresses.
 			size_t memMin, memMax;
 
+			// Find the chunk containing an object. All chunks are aligned to the pieces of the
+			// VMAlloc, and 'memMin' is the start of one of them, so this only requires some
+			// arithmetic.
+			inline Chunk *chunkOf(void *ptr) const {
+				size_t offset = (size_t(ptr) - memMin) & ~(vmAllocMinSize - 1);
+				return (Chunk *)(memMin + offset);
+			}
+
 			// Allocate memory for an allocation, but don't initialize it. Returns 'null' on failure.
 			void *allocMem(size_t size);
 
-			// Allocate another chunk. Returns the ID of the newly allocated chunk, or an non-valid
-			// ID if the allocation failed.
-			size_t allocChunk();
+			// Allocate another chunk for the given size class. Returns null on failure.
+			Chunk *allocChunk(nat sizeClass);
+
+			// Return a chunk to the VMAlloc.
+			void freeChunk(Chunk *chunk);
+
+			// Add and remove chunks from the partial lists.
+			void link(Chunk *chunk);
+			void unlink(Chunk *chunk);
+
+			// Update the state of a chunk after objects have been freed from it. Returns 'true' if
+			// the chunk was empty and returned to the VMAlloc.
+			bool update(Chunk *chunk);
 
 			// Free a range of linked allocations.
 			void freeChain(LockTicket &ticket, Header *first);
@@ -357,7 +377,7 @@ namespace storm {
 
 		template <class Fn>
 		void Nonmoving::Chunk::traverse(Fn fn) {
-			for (size_t i = 0; i < size; i += header(i)->size() + sizeof(Header)) {
+			for (size_t i = 0; i < slots; i++) {
 				Header *h = header(i);
 				if (h->hasFlag(Header::fFree | Header::fFinalize))
 					continue;
@@ -369,7 +389,7 @@ namespace storm {
 		template <class Scanner>
 		typename Scanner::Result Nonmoving::Chunk::scan(typename Scanner::Source &source) {
 			typename Scanner::Result result = typename Scanner::Result();
-			for (size_t i = 0; i < size; i += header(i)->size() + sizeof(Header)) {
+			for (size_t i = 0; i < slots; i++) {
 				Header *h = header(i);
 				if (h->hasFlag(Header::fFree | Header::fFinalize))
 					continue;
@@ -385,7 +405,7 @@ namespace storm {
 		template <class Scanner>
 		typename Scanner::Result Nonmoving::Chunk::scanPinned(const PinnedSet &pinned, typename Scanner::Source &source) {
 			typename Scanner::Result result = typename Scanner::Result();
-			for (size_t i = 0; i < size; i += header(i)->size() + sizeof(Header)) {
+			for (size_t i = 0; i < slots; i++) {
 				Header *h = header(i);
 				if (h->hasFlag(Header::fFree | Header::fFinalize))
 					continue;
@@ -410,7 +430,7 @@ namespace storm {
 		template <class Scanner>
 		typename Scanner::Result Nonmoving::Chunk::scanSweep(Nonmoving *owner, typename Scanner::Source &source) {
 			typename Scanner::Result result = typename Scanner::Result();
-			for (size_t i = 0; i < size; i += header(i)->size() + sizeof(Header)) {
+			for (size_t i = 0; i < slots; i++) {
 				Header *h = header(i);
 				if (h->hasFlag(Header::fFree))
 					continue;
@@ -429,7 +449,6 @@ namespace storm {
 			return result;
 		}
 
-
 		/**
 		 * Amend another scanner with the ability to detect and correctly handle nonmoving objects.
 		 *
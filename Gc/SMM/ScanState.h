@@ -17,6 +17,13 @@ namespace storm {
 		 * generation, that have been recently been moved to a new generation but have not yet been
 		 * scanned themselves. Basically, this class keeps track of the set of gray objects during a
 		 * scan in a tri-color garbage collecting scheme.
+		 *
+		 * A scan state is only used by one thread at a time. Objects are forwarded by overwriting
+		 * their headers without atomic operations, and all copies are allocated from the same
+		 * blocks in the 'to' generation. Because of this, tracing and copying objects is the part
+		 * of a collection that does not use the helper threads in Workers. Doing that in parallel
+		 * would need atomic forwarding, per-worker allocation buffers and a 'scanNew' that
+		 * distributes gray objects between workers. None of these are implemented yet.
 		 */
 		class ScanState {
 		public:
@@ -177,6 +184,10 @@ namespace storm {
 				if (fmt::isFwd(obj, ptr))
 					return 0;
 
+				// Large objects are marked and scanned later rather than copied.
+				if (state.sourceGen.markLarge(obj, end))
+					return 0;
+
 				// TODO: Forward any errors!
 				*ptr = state.move(obj);
 				return 0;
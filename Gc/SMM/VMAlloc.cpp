@@ -360,6 +360,16 @@ namespace storm {
 			vm->decommit(chunk.at, chunk.size);
 		}
 
+		void VMAlloc::identifier(Chunk chunk, byte identifier) {
+			byte packedIdentifier = (identifier & 0x3F) << 2;
+			dbg_assert(infoData(packedIdentifier) == identifier, L"Identifier too large!");
+
+			size_t first = infoOffset(chunk.at);
+			size_t pieces = chunk.size / vmAllocMinSize;
+			for (size_t i = first; i < first + pieces; i++)
+				info[i] = (info[i] & 0x03) | packedIdentifier;
+		}
+
 		void VMAlloc::watchWrites(Chunk chunk) {
 			size_t first = infoOffset(chunk.at);
 			size_t pieces = (size_t(chunk.end()) - size_t(infoPtr(first)) + vmAllocMinSize - 1) / vmAllocMinSize;
@@ -50,6 +50,9 @@ namespace storm {
 				return infoData(info[infoOffset(addr)]);
 			}
 
+			// Change the identifier of an allocation. The state of the write barrier is preserved.
+			void identifier(Chunk chunk, byte id);
+
 			// Get the identifier for an allocation safely. Returns 0xFF on failure.
 			inline byte safeIdentifier(void *addr) const {
 				size_t a = size_t(addr);
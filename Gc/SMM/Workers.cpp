@@ -0,0 +1,94 @@
+#include "stdafx.h"
+#include "Workers.h"
+
+#if STORM_GC == STORM_GC_SMM
+
+#include "OS/Thread.h"
+
+namespace storm {
+	namespace smm {
+
+		Workers::Workers(nat limit)
+			: limit(max(limit, nat(1))), helpers(0), use(this->limit), started(0), startSema(0), doneSema(0),
+			  stop(0), fn(null), data(null), tasks(0), next(0) {}
+
+		Workers::~Workers() {
+			atomicWrite(stop, 1);
+			for (nat i = 0; i < helpers; i++)
+				startSema.up();
+
+			group.join();
+		}
+
+		void Workers::start() {
+			if (helpers > 0 || limit <= 1)
+				return;
+
+			helpers = limit - 1;
+			for (nat i = 0; i < helpers; i++)
+				os::Thread::spawn(util::Fn<void, void>(this, &Workers::main), group);
+		}
+
+		nat Workers::threads() const {
+			return use;
+		}
+
+		void Workers::threads(nat count) {
+			use = count ? min(count, limit) : limit;
+		}
+
+		void Workers::run(size_t tasks, TaskFn fn, void *data) {
+			if (tasks == 0)
+				return;
+
+			// Not worth waking the other threads?
+			nat available = min(helpers, use - 1);
+			if (available == 0 || tasks == 1) {
+				for (size_t i = 0; i < tasks; i++)
+					(*fn)(data, 0, i);
+				return;
+			}
+
+			this->fn = fn;
+			this->data = data;
+			this->tasks = tasks;
+			atomicWrite(next, 0);
+
+			// No need to wake more threads than there are tasks.
+			nat wake = nat(min(size_t(available), tasks - 1));
+			for (nat i = 0; i < wake; i++)
+				startSema.up();
+
+			work(0);
+
+			for (nat i = 0; i < wake; i++)
+				doneSema.down();
+		}
+
+		void Workers::main() {
+			nat id = atomicIncrement(started);
+
+			while (true) {
+				startSema.down();
+				if (atomicRead(stop))
+					break;
+
+				work(id);
+				doneSema.up();
+			}
+		}
+
+		void Workers::work(nat worker) {
+			while (true) {
+				size_t task = atomicIncrement(next) - 1;
+				if (task >= tasks)
+					break;
+
+				(*fn)(data, worker, task);
+			}
+		}
+
+	}
+}
+
+#endif
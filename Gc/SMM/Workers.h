@@ -0,0 +1,110 @@
+#pragma once
+
+#if STORM_GC == STORM_GC_SMM
+
+#include "OS/ThreadGroup.h"
+#include "Utils/Semaphore.h"
+
+namespace storm {
+	namespace smm {
+
+		/**
+		 * A pool of helper threads used to execute independent parts of a collection in parallel.
+		 *
+		 * The threads currently scan the stacks of attached threads, update references in other
+		 * generations after objects were moved, and compact chunks. Tracing and copying live
+		 * objects is still done by the collecting thread alone (see ScanState). Pause times
+		 * therefore do not scale with the number of threads for heaps that contain a lot of live
+		 * data.
+		 *
+		 * The helper threads are not attached to the arena. As such, they are not stopped during
+		 * collections, and they never touch memory in the arena unless they are told to by
+		 * 'run'. The threads are created lazily, since creating threads may require locks that
+		 * are held by stopped threads. Therefore, 'start' must be called before other threads are
+		 * stopped. If the threads are not started, 'run' executes all tasks on the calling thread.
+		 */
+		class Workers {
+		public:
+			// Create. At most 'limit' threads are used, including the thread calling 'run'.
+			Workers(nat limit);
+
+			// Destroy, stops all threads.
+			~Workers();
+
+			// Function called for each task. 'worker' is a number in the range [0, count()[ that
+			// is unique to each thread while 'run' is executing. The calling thread is worker 0.
+			typedef void (*TaskFn)(void *data, nat worker, size_t task);
+
+			// Start the helper threads if they are not already started.
+			void start();
+
+			// Number of threads used by 'run', including the calling thread.
+			inline nat count() const { return helpers + 1; }
+
+			// Get/set the maximum number of threads used by 'run', including the calling
+			// thread. Zero means the limit passed to the constructor. Used to compare
+			// collections with and without helpers.
+			nat threads() const;
+			void threads(nat count);
+
+			// Call 'fn' once for each task in [0, tasks[, and distribute the calls between all
+			// threads. Returns when all tasks are completed.
+			void run(size_t tasks, TaskFn fn, void *data);
+
+			// Call 'body(worker, task)' for each task.
+			template <class Body>
+			void run(size_t tasks, Body &body) {
+				run(tasks, &callBody<Body>, &body);
+			}
+
+		private:
+			Workers(const Workers &o);
+			Workers &operator =(const Workers &o);
+
+			// Maximum number of threads.
+			nat limit;
+
+			// Number of started helper threads.
+			nat helpers;
+
+			// Maximum number of threads to use, as set by 'threads'.
+			nat use;
+
+			// Number of helper threads that have picked an identifier.
+			volatile nat started;
+
+			// Group of all helper threads.
+			os::ThreadGroup group;
+
+			// Signaled once for each helper when there is work to do.
+			Semaphore startSema;
+
+			// Signaled by each helper when it is done with its work.
+			Semaphore doneSema;
+
+			// Are we shutting down?
+			volatile nat stop;
+
+			// The current job.
+			TaskFn fn;
+			void *data;
+			size_t tasks;
+			volatile size_t next;
+
+			// Main function for the helper threads.
+			void main();
+
+			// Execute tasks until there are no more tasks.
+			void work(nat worker);
+
+			// Call a 'body'.
+			template <class Body>
+			static void callBody(void *data, nat worker, size_t task) {
+				(*(Body *)data)(worker, task);
+			}
+		};
+
+	}
+}
+
+#endif
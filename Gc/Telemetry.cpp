@@ -0,0 +1,170 @@
+#include "stdafx.h"
+#include "Telemetry.h"
+#include "Utils/FileStream.h"
+
+namespace storm {
+
+	GcPauseHistogram::GcPauseHistogram() {
+		for (nat i = 0; i < buckets; i++)
+			counts[i] = 0;
+	}
+
+	void GcPauseHistogram::add(int64 time) {
+		nat bucket = 0;
+		while (bucket < buckets - 1 && time >= upperBound(bucket))
+			bucket++;
+		atomicIncrement(counts[bucket]);
+	}
+
+	size_t GcPauseHistogram::count(nat bucket) const {
+		if (bucket >= buckets)
+			return 0;
+		return atomicRead(counts[bucket]);
+	}
+
+	size_t GcPauseHistogram::total() const {
+		size_t result = 0;
+		for (nat i = 0; i < buckets; i++)
+			result += atomicRead(counts[i]);
+		return result;
+	}
+
+	int64 GcPauseHistogram::upperBound(nat bucket) {
+		return int64(1) << bucket;
+	}
+
+	int64 GcPauseHistogram::percentile(double percentile) const {
+		size_t copy[buckets];
+		size_t sum = 0;
+		for (nat i = 0; i < buckets; i++)
+			sum += copy[i] = atomicRead(counts[i]);
+
+		if (sum == 0)
+			return 0;
+
+		double limit = sum * min(max(percentile, 0.0), 100.0) / 100.0;
+		size_t seen = 0;
+		for (nat i = 0; i < buckets; i++) {
+			seen += copy[i];
+			if (seen > 0 && double(seen) >= limit)
+				return upperBound(i);
+		}
+		return upperBound(buckets - 1);
+	}
+
+
+	GcTelemetry::Event::Event()
+		: id(0), start(0), end(0), generation(0), condemned(0), copied(0), freed(0), heapUsed(0), finalizers(0) {}
+
+	GcTelemetry::GcTelemetry() : recorded(0), version(0), logFile(null), logged(0) {}
+
+	GcTelemetry::~GcTelemetry() {
+		log(null);
+	}
+
+	size_t GcTelemetry::record(Event event) {
+		event.id = recorded + 1;
+		pauses.add(event.pause());
+
+		atomicIncrement(version);
+		ring[event.id % capacity] = event;
+		atomicWrite(recorded, event.id);
+		atomicIncrement(version);
+
+		return event.id;
+	}
+
+	void GcTelemetry::finalized(size_t id, size_t count) {
+		if (count == 0)
+			return;
+
+		// The slot may be reused by a newer event at any time, so we check the id first. This
+		// might add the count to the wrong event if the buffer wraps around in between, but that
+		// requires 'capacity' collections during this function call.
+		Event &e = ring[id % capacity];
+		if (atomicRead(e.id) != id)
+			return;
+
+		size_t old;
+		do {
+			old = atomicRead(e.finalizers);
+		} while (atomicCAS(e.finalizers, old, old + count) != old);
+	}
+
+	vector<GcTelemetry::Event> GcTelemetry::events(size_t after) const {
+		vector<Event> result;
+		size_t old;
+		do {
+			result.clear();
+			do {
+				old = atomicRead(version);
+			} while (old & 1);
+
+			size_t last = atomicRead(recorded);
+			size_t first = after + 1;
+			if (last >= capacity)
+				first = max(first, last - capacity + 1);
+
+			for (size_t i = first; i <= last; i++)
+				result.push_back(ring[i % capacity]);
+
+		} while (old != atomicRead(version));
+
+		return result;
+	}
+
+	bool GcTelemetry::log(const wchar *file) {
+		util::Lock::L z(logLock);
+
+		if (logFile) {
+			delete logFile;
+			logFile = null;
+		}
+
+		if (!file)
+			return true;
+
+		logFile = new FileStream(Path(String(file)), Stream::mWrite);
+		if (!logFile->valid()) {
+			delete logFile;
+			logFile = null;
+			return false;
+		}
+
+		// Only events that happen from now on are logged.
+		logged = atomicRead(recorded);
+		return true;
+	}
+
+	void GcTelemetry::flush() {
+		util::Lock::L z(logLock);
+		if (!logFile)
+			return;
+
+		vector<Event> found = events(logged);
+		if (found.empty())
+			return;
+
+		std::ostringstream out;
+		for (size_t i = 0; i < found.size(); i++) {
+			const Event &e = found[i];
+			out << "{\"id\":" << e.id
+				<< ",\"start\":" << e.start
+				<< ",\"end\":" << e.end
+				<< ",\"pause\":" << e.pause()
+				<< ",\"generation\":" << e.generation
+				<< ",\"condemned\":" << e.condemned
+				<< ",\"copied\":" << e.copied
+				<< ",\"freed\":" << e.freed
+				<< ",\"heapUsed\":" << e.heapUsed
+				<< ",\"finalizers\":" << e.finalizers
+				<< "}\n";
+		}
+
+		std::string data = out.str();
+		logFile->write(nat(data.size()), data.c_str());
+		logFile->flush();
+		logged = found.back().id;
+	}
+
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include "Utils/Lock.h"
+
+class FileStream;
+
+namespace storm {
+
+	/**
+	 * Histogram of pause times of the garbage collector. Bucket 'i' counts pauses shorter than
+	 * 2^i microseconds that did not fit in the previous bucket. The last bucket also counts all
+	 * longer pauses.
+	 *
+	 * The counters are updated with atomic operations, so the histogram may be read at any time
+	 * without synchronization.
+	 */
+	class GcPauseHistogram {
+	public:
+		// Number of buckets.
+		static const nat buckets = 32;
+
+		// Create an empty histogram.
+		GcPauseHistogram();
+
+		// Add a pause, in microseconds.
+		void add(int64 time);
+
+		// Get the number of pauses in a bucket.
+		size_t count(nat bucket) const;
+
+		// Get the total number of pauses.
+		size_t total() const;
+
+		// Get the upper bound of a bucket, in microseconds.
+		static int64 upperBound(nat bucket);
+
+		// Get an approximation of the given percentile (0-100) of the pauses, in
+		// microseconds. The approximation is the upper bound of the bucket containing the
+		// percentile. Returns zero if no pauses have been recorded.
+		int64 percentile(double percentile) const;
+
+	private:
+		// Counters.
+		size_t counts[buckets];
+	};
+
+
+	/**
+	 * Telemetry about the collections performed by the garbage collector.
+	 *
+	 * The GC implementation records an event for each collection. Events are recorded by one thread
+	 * at a time (i.e. while holding the arena lock), possibly while other threads are stopped. As
+	 * such, recording an event never allocates memory and never acquires locks. The most recent
+	 * events are kept in a ring buffer that can be read from other threads at any time. Just as
+	 * with HistorySummary in SMM, a version number is used to detect when the buffer was modified
+	 * while it was being read.
+	 *
+	 * Events can also be written to a file, one JSON object per line. Since writing the file
+	 * requires locks and memory allocations, this is done in 'flush', which the GC implementation
+	 * calls when other threads are running.
+	 */
+	class GcTelemetry {
+	public:
+		// Create.
+		GcTelemetry();
+
+		// Destroy. Closes the log, if any.
+		~GcTelemetry();
+
+		/**
+		 * Information about a single collection.
+		 */
+		class Event {
+		public:
+			Event();
+
+			// Sequence number of the event. The first event is number 1.
+			size_t id;
+
+			// Start and end of the collection, in microseconds. Uses the same clock as
+			// os::ThreadStats::now.
+			int64 start;
+			int64 end;
+
+			// The collected generation. Zero is the nursery.
+			nat generation;
+
+			// Number of bytes in the collected generation when the collection started.
+			size_t condemned;
+
+			// Number of bytes moved to the next generation.
+			size_t copied;
+
+			// Number of bytes freed.
+			size_t freed;
+
+			// Number of bytes in use in the heap after the collection.
+			size_t heapUsed;
+
+			// Number of finalizers scheduled as a result of the collection.
+			size_t finalizers;
+
+			// Duration of the collection, in microseconds.
+			inline int64 pause() const { return end - start; }
+		};
+
+		// Number of events kept in the ring buffer.
+		static const nat capacity = 1024;
+
+		// Record an event. Assigns 'id' and returns the id.
+		size_t record(Event event);
+
+		// Add finalizers to a previously recorded event. Does nothing if the event is no longer
+		// present in the ring buffer. May be called without holding the arena lock.
+		void finalized(size_t id, size_t count);
+
+		// Get all events in the ring buffer that are newer than 'after'.
+		vector<Event> events(size_t after) const;
+
+		// Histogram of all pauses so far.
+		GcPauseHistogram pauses;
+
+		// Start writing events to 'file', or stop writing events if 'file' is null. Returns false
+		// if the file could not be opened.
+		bool log(const wchar *file);
+
+		// Write any events that are not yet written to the log.
+		void flush();
+
+	private:
+		// No copying!
+		GcTelemetry(const GcTelemetry &o);
+		GcTelemetry &operator =(const GcTelemetry &o);
+
+		// Ring buffer of events.
+		Event ring[capacity];
+
+		// Number of events recorded so far. This is also the id of the latest event.
+		size_t recorded;
+
+		// Version of the ring buffer. Odd while an event is being written.
+		size_t version;
+
+		// Lock for the log.
+		util::Lock logLock;
+
+		// Log file, if any.
+		FileStream *logFile;
+
+		// Last event written to the log.
+		size_t logged;
+	};
+
+}
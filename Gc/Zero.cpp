@@ -3,6 +3,7 @@
 
 #if STORM_GC == STORM_GC_ZERO
 #include "Gc.h"
+#include "Core/Hash.h"
 
 #ifdef POSIX
 #include <sys/mman.h>
@@ -47,7 +48,7 @@ namespace storm {
 		return result;
 	}
 
-	GcImpl::GcImpl(size_t, nat) : allocStart(null), allocEnd(null) {}
+	GcImpl::GcImpl(size_t, nat, const GcParams &) : allocStart(null), allocEnd(null) {}
 
 	void GcImpl::destroy() {}
 
@@ -64,6 +65,16 @@ namespace storm {
 		return false;
 	}
 
+	Nat GcImpl::collections() {
+		return 0;
+	}
+
+	GcParams GcImpl::params() {
+		return GcParams();
+	}
+
+	void GcImpl::params(const GcParams &) {}
+
 	GcImpl::ThreadData GcImpl::attachThread() {
 		return 0;
 	}
@@ -196,6 +207,10 @@ namespace storm {
 		// Nothing to do...
 	}
 
+	Bool GcImpl::inHeap(const void *addr) {
+		return false;
+	}
+
 	GcImpl::Root *GcImpl::createRoot(void *data, size_t count, bool ambiguous) {
 		// No roots here!
 		return null;
@@ -219,6 +234,25 @@ namespace storm {
 		return new MallocWatch();
 	}
 
+	Bool GcImpl::stableIdentityHash() {
+		// Objects never move.
+		return true;
+	}
+
+	Nat GcImpl::identityHash(const void *obj) {
+		return ptrHash(obj);
+	}
+
+	Nat GcImpl::storeIdentityHash(const void *obj) {
+		return ptrHash(obj);
+	}
+
+	void GcImpl::releaseIdentityHash(const void *) {}
+
+	GcTelemetry *GcImpl::telemetry() {
+		return null;
+	}
+
 	void GcImpl::checkMemory() {}
 
 	void GcImpl::checkMemory(const void *object, bool recursive) {
@@ -375,7 +375,7 @@ int stormMain(int argc, const wchar_t *argv[]) {
 			root = Path::cwd() + root;
 	}
 
-	Engine e(root, Engine::reuseMain, &argv);
+	Engine e(root, Engine::reuseMain, &argv, p.gc);
 	Moment end;
 
 	try {
@@ -1,5 +1,7 @@
 #include "stdafx.h"
 #include "Params.h"
+#include <cerrno>
+#include <limits>
 
 struct StatePtr;
 typedef StatePtr (*State)(const wchar_t *, Params &);
@@ -87,6 +89,84 @@ static StatePtr replLang(const wchar_t *arg, Params &result) {
 	return &start;
 }
 
+// Parse a size, possibly with a suffix (K, M or G). Returns 0 on failure, or if the size does not
+// fit in a size_t.
+static size_t parseSize(const wchar_t *str, const wchar_t **end) {
+	// Note: 'wcstoul' accepts signs and leading whitespace.
+	if (*str < '0' || *str > '9')
+		return 0;
+
+	wchar_t *e = null;
+	errno = 0;
+	unsigned long value = wcstoul(str, &e, 10);
+	if (e == str || errno == ERANGE || value > std::numeric_limits<size_t>::max())
+		return 0;
+
+	size_t multiplier = 1;
+	switch (*e) {
+	case 'k':
+	case 'K':
+		multiplier = 1024;
+		e++;
+		break;
+	case 'm':
+	case 'M':
+		multiplier = 1024 * 1024;
+		e++;
+		break;
+	case 'g':
+	case 'G':
+		multiplier = 1024 * 1024 * 1024;
+		e++;
+		break;
+	}
+
+	size_t result = size_t(value);
+	if (result > std::numeric_limits<size_t>::max() / multiplier)
+		return 0;
+
+	*end = e;
+	return result * multiplier;
+}
+
+static StatePtr gcGenerations(const wchar_t *arg, Params &result) {
+	EXPECT_MORE(L"Missing generation sizes.");
+	result.gc.generations.clear();
+	while (true) {
+		size_t size = parseSize(arg, &arg);
+		if (size == 0) {
+			PARSE_ERROR(L"Invalid generation sizes.");
+		}
+		result.gc.generations.push_back(size);
+
+		if (*arg == 0)
+			break;
+		if (*arg++ != ',') {
+			PARSE_ERROR(L"Invalid generation sizes.");
+		}
+	}
+
+	if (result.gc.generations.size() < GcParams::minGenerations) {
+		PARSE_ERROR(L"At least two generation sizes are required.");
+	}
+	if (result.gc.generations.size() > GcParams::maxGenerations) {
+		PARSE_ERROR(L"Too many generation sizes.");
+	}
+	return &start;
+}
+
+static StatePtr gcPause(const wchar_t *arg, Params &result) {
+	EXPECT_MORE(L"Missing pause time.");
+	wchar_t *end = null;
+	unsigned long ms = wcstoul(arg, &end, 10);
+	if (end == arg || *end != 0 || ms == 0) {
+		PARSE_ERROR(L"Invalid pause time.");
+	}
+	result.gc.adaptive = true;
+	result.gc.pauseTarget = nat(ms * 1000);
+	return &start;
+}
+
 static StatePtr consumeArgv(const wchar_t *arg, Params &result) {
 	if (arg == null)
 		return StatePtr();
@@ -130,6 +210,13 @@ static StatePtr start(const wchar_t *arg, Params &result) {
 	} else if (wcscmp(arg, L"--noconsole") == 0) {
 		result.noConsole = true;
 		return &start;
+	} else if (wcscmp(arg, L"--gc-generations") == 0) {
+		return &gcGenerations;
+	} else if (wcscmp(arg, L"--gc-adaptive") == 0) {
+		result.gc.adaptive = true;
+		return &start;
+	} else if (wcscmp(arg, L"--gc-pause") == 0) {
+		return &gcPause;
 	} else if (wcscmp(arg, L"--") == 0) {
 		return &consumeArgv;
 	} else {
@@ -186,5 +273,8 @@ void help(const wchar_t *cmd) {
 	wcout << cmd << L" --version        - print the current version and exit." << endl;
 	wcout << cmd << L" --server         - start the language server." << endl;
 	wcout << cmd << L" --noconsole      - on Windows: deallocate the console window during startup." << endl;
+	wcout << cmd << L" --gc-generations <sizes> - use generations of the specified sizes (e.g. 1M,10M,100M)." << endl;
+	wcout << cmd << L" --gc-adaptive    - adapt the size of generations to the behavior of the program." << endl;
+	wcout << cmd << L" --gc-pause <ms>  - like --gc-adaptive, but aim for collections that take <ms> milliseconds." << endl;
 	wcout << cmd << L" -- <arguments>   - interpret remaining arguments as parameters to the program." << endl;
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include "Gc/GcParams.h"
 
 /**
  * Import external packages.
@@ -55,6 +56,9 @@ public:
 
 	// Deallocate the console window?
 	bool noConsole;
+
+	// Parameters to the garbage collector.
+	storm::GcParams gc;
 };
 
 void help(const wchar_t *cmd);
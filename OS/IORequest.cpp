@@ -16,6 +16,7 @@ namespace os {
 		Pointer = NULL;
 		hEvent = NULL;
 		thread.threadData()->ioComplete.attach();
+		ThreadStats::addShared(thread.threadData()->counters.ioRequests);
 
 		if (timeout) {
 			sleep.until = UThreadState::sleepTarget(timeout);
@@ -59,6 +60,11 @@ namespace os {
 		: type(type), closed(false), timeout(false), handle(handle), thread(thread) {
 
 		thread.threadData()->ioComplete.attach(handle, this);
+
+		ThreadStats &stats = thread.threadData()->counters;
+		ThreadStats::addShared(stats.ioRequests);
+		ThreadStats::addShared(type == read ? stats.ioReads : stats.ioWrites);
+
 		if (timeout) {
 			sleep.until = UThreadState::sleepTarget(timeout);
 			sleep.request = this;
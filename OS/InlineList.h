@@ -56,6 +56,37 @@ namespace os {
 			return r;
 		}
 
+		// Find the first element for which 'pred' returns true. Returns null if no such element
+		// exists.
+		T *find(bool (*pred)(T *)) const {
+			for (T *at = head; at != end; at = at->next)
+				if ((*pred)(at))
+					return at;
+			return null;
+		}
+
+		// Remove 'e' from the list. Returns false if 'e' was not in the list.
+		bool remove(T *e) {
+			T *prev = null;
+			for (T *at = head; at != end; prev = at, at = at->next) {
+				if (at != e)
+					continue;
+
+				if (prev)
+					prev->next = at->next;
+				else
+					head = at->next;
+
+				if (tail == at)
+					tail = prev ? prev : end;
+
+				at->next = null;
+				return true;
+			}
+
+			return false;
+		}
+
 		// Empty?
 		bool empty() const {
 			return head == end;
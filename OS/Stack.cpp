@@ -10,6 +10,17 @@
 
 namespace os {
 
+	// Total amount of memory allocated for stacks.
+	static size_t allocatedBytes = 0;
+
+	// Update 'allocatedBytes'.
+	static void addAllocated(size_t add, size_t sub) {
+		size_t old;
+		do {
+			old = atomicRead(allocatedBytes);
+		} while (atomicCAS(allocatedBytes, old, old + add - sub) != old);
+	}
+
 	Stack::Stack(size_t size) : desc(null), detourActive(0), detourTo(null), alloc(null), size(0) {
 		allocate(size);
 		initDesc();
@@ -53,6 +64,7 @@ namespace os {
 			// TODO: What to do in this case?
 			throw ThreadError(L"Out of memory when spawning a thread.");
 		}
+		addAllocated(size, 0);
 
 		DWORD oldProt;
 		VirtualProtect(mem, 1, PAGE_READONLY | PAGE_GUARD, &oldProt);
@@ -66,6 +78,7 @@ namespace os {
 		byte *mem = (byte *)alloc;
 		mem -= pageSize();
 		VirtualFree(mem, 0, MEM_RELEASE);
+		addAllocated(0, size + pageSize());
 	}
 
 	void Stack::initDesc() {
@@ -97,10 +110,11 @@ namespace os {
 		size += pageSz; // We want a guard page.
 
 		byte *mem = (byte *)mmap(null, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-		if (mem == null) {
+		if (mem == (byte *)MAP_FAILED) {
 			// TODO: What to do in this case?
 			throw ThreadError(L"Out of memory when spawning a thread.");
 		}
+		addAllocated(size, 0);
 
 		mprotect(mem, 1, PROT_NONE); // no special guard-page it seems...
 
@@ -114,6 +128,7 @@ namespace os {
 		size_t pageSz = pageSize();
 		mem -= pageSz;
 		munmap(mem, size + pageSz);
+		addAllocated(0, size + pageSz);
 	}
 
 	void Stack::initDesc() {
@@ -130,4 +145,81 @@ namespace os {
 
 #endif
 
+	Stack::Stack(size_t size, StackCache &cache) : desc(null), detourActive(0), detourTo(null), alloc(null), size(0) {
+		size = roundUp(size, pageSize());
+		alloc = cache.pop(size);
+		if (alloc)
+			this->size = size;
+		else
+			allocate(size);
+		initDesc();
+	}
+
+	void Stack::recycle(StackCache &cache) {
+		if (size == 0)
+			return;
+
+		// If the cache is full, we free the memory immediately rather than in the destructor.
+		if (!cache.push(alloc, size))
+			free();
+
+		alloc = null;
+		size = 0;
+		desc = null;
+	}
+
+	size_t Stack::allocatedMemory() {
+		return atomicRead(allocatedBytes);
+	}
+
+
+	/**
+	 * Stack cache.
+	 */
+
+	const size_t StackCache::defaultLimit = 16 * 1024 * 1024;
+
+	StackCache::StackCache(size_t limit) : first(null), limit(limit), size(0) {}
+
+	StackCache::~StackCache() {
+		while (first) {
+			Entry *e = first;
+			first = e->next;
+
+			// Let a temporary stack free the memory for us.
+			Stack s((void *)null);
+			s.alloc = e;
+			s.size = e->size;
+		}
+	}
+
+	void *StackCache::pop(size_t size) {
+		util::Lock::L z(lock);
+
+		for (Entry **at = &first; *at; at = &(*at)->next) {
+			Entry *e = *at;
+			if (e->size != size)
+				continue;
+
+			*at = e->next;
+			this->size -= size;
+			return e;
+		}
+
+		return null;
+	}
+
+	bool StackCache::push(void *alloc, size_t size) {
+		util::Lock::L z(lock);
+		if (this->size + size > limit)
+			return false;
+
+		Entry *e = (Entry *)alloc;
+		e->next = first;
+		e->size = size;
+		first = e;
+		this->size += size;
+		return true;
+	}
+
 }
@@ -1,8 +1,11 @@
 #pragma once
 #include "InlineSet.h"
+#include "Utils/Lock.h"
 
 namespace os {
 
+	class StackCache;
+
 	/**
 	 * Stack description used by the UThread stack scheduler.
 	 *
@@ -25,6 +28,9 @@ namespace os {
 		// Allocate a stack with the given size.
 		explicit Stack(size_t size);
 
+		// Allocate a stack with the given size, re-using memory from 'cache' if possible.
+		Stack(size_t size, StackCache &cache);
+
 		// Create a stack that represents a OS-allocated stack. It is assumed to be running at the
 		// moment. The parameter provided is the address of the "base" of the stack, i.e. somewhere
 		// near the bottom of the stack. Typically the address of a local variable near "main".
@@ -74,6 +80,13 @@ namespace os {
 		// allocated, and not an OS stack.
 		void clear();
 
+		// Give the memory of this stack to 'cache' so that it can be re-used by another stack. After
+		// this call, the stack no longer refers to any memory. Assumes the stack is not in use.
+		void recycle(StackCache &cache);
+
+		// Total amount of memory allocated for stacks in the process, including memory in caches.
+		static size_t allocatedMemory();
+
 		// Get the low and high address of the allocated memory (if any). These are independent of
 		// the current CPU architecture.
 		inline void *low() const { return alloc; }
@@ -83,6 +96,8 @@ namespace os {
 		inline bool allocated() const { return size > 0; }
 
 	private:
+		friend class StackCache;
+
 		// The low address of the stack. If we represent an OS allocated stack, this is the limit.
 		void *alloc;
 
@@ -99,4 +114,51 @@ namespace os {
 		void initDesc();
 	};
 
+
+	/**
+	 * A cache of memory for stacks that are no longer in use. Allows re-using the memory of stacks
+	 * from exited UThreads without returning it to the OS, which makes spawning UThreads cheaper.
+	 *
+	 * Stacks in the cache keep their guard page. The cache is limited to a fixed amount of memory,
+	 * stacks that do not fit are returned to the OS immediately. Safe to use from multiple threads.
+	 */
+	class StackCache : NoCopy {
+	public:
+		// Create, keeping at most 'limit' bytes of memory.
+		explicit StackCache(size_t limit = defaultLimit);
+
+		// Free all cached memory.
+		~StackCache();
+
+		// Default limit.
+		static const size_t defaultLimit;
+
+	private:
+		friend class Stack;
+
+		// A cached stack. Stored at the low end of the stack memory.
+		struct Entry {
+			Entry *next;
+			size_t size;
+		};
+
+		// Lock for the list.
+		util::Lock lock;
+
+		// Cached stacks.
+		Entry *first;
+
+		// Maximum number of bytes to keep.
+		size_t limit;
+
+		// Number of bytes currently in the cache.
+		size_t size;
+
+		// Find and remove a stack of size 'size'. Returns null if none exists.
+		void *pop(size_t size);
+
+		// Add a stack to the cache. Returns false if the cache is full.
+		bool push(void *alloc, size_t size);
+	};
+
 }
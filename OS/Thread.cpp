@@ -2,6 +2,7 @@
 #include "Thread.h"
 #include "UThread.h"
 #include "ThreadGroup.h"
+#include "ThreadPool.h"
 #include "Shared.h"
 
 #ifdef WINDOWS
@@ -137,6 +138,12 @@ namespace os {
 		return data->uState.stacks;
 	}
 
+	ThreadStats Thread::stats() const {
+		if (ThreadPool *pool = data->uState.pool())
+			return pool->stats();
+		return data->stats();
+	}
+
 	Thread Thread::spawn(ThreadGroup &group) {
 		return spawn(util::Fn<void>(), group);
 	}
@@ -250,6 +257,9 @@ namespace os {
 			d.waitForWork();
 		}
 
+		// Stop taking work from other threads.
+		d.uState.leavePool();
+
 		// Now, no one has any knowledge of our existence, we can safely delete the 'wait' now.
 		delete wait;
 
@@ -272,10 +282,24 @@ namespace os {
 			wait->signal();
 	}
 
+	ThreadStats ThreadData::stats() const {
+		ThreadStats r = counters;
+		r.alive = uState.aliveThreads();
+		r.ready = uState.readyThreads();
+		return r;
+	}
+
 	bool ThreadData::waitForWork() {
 		bool result = false;
 		checkIo();
 
+		int64 idleStart = ThreadStats::now();
+
+		// Let the pool know that we are available to take work from other threads.
+		ThreadPool *pool = uState.pool();
+		if (pool)
+			pool->idle(&uState, true);
+
 		nat sleepFor = 0;
 		if (uState.nextWake(sleepFor)) {
 			if (sleepFor > 0) {
@@ -303,6 +327,12 @@ namespace os {
 			}
 		}
 
+		if (pool)
+			pool->idle(&uState, false);
+
+		ThreadStats::add(counters.idleWaits);
+		ThreadStats::add(counters.idleUs, ThreadStats::since(idleStart));
+
 		checkIo();
 		return result;
 	}
@@ -5,6 +5,7 @@
 #include "IOHandle.h"
 #include "UThread.h"
 #include "InlineSet.h"
+#include "ThreadStats.h"
 
 namespace os {
 
@@ -62,6 +63,10 @@ namespace os {
 		// Get a list of UThreads running on this thread. Note that access to this list is not thread safe.
 		const InlineSet<Stack> &stacks() const;
 
+		// Get statistics about the scheduling and I/O of this thread. If the thread is the first
+		// thread of a pool, the statistics of all threads in the pool are added together.
+		ThreadStats stats() const;
+
 		// Start a thread.
 		static Thread spawn(ThreadGroup &group);
 		static Thread spawn(const util::Fn<void, void> &start, ThreadGroup &group);
@@ -107,6 +112,12 @@ namespace os {
 		// from the thread this ThreadData is representing.
 		UThreadState uState;
 
+		// Statistics for this thread. Mostly updated by 'uState'.
+		ThreadStats counters;
+
+		// Get a copy of the statistics, including the current state of the scheduler.
+		ThreadStats stats() const;
+
 		// Create.
 		ThreadData(void *stackBase, void *osThreadData);
 
@@ -0,0 +1,158 @@
+#include "stdafx.h"
+#include "ThreadPool.h"
+#include "UThread.h"
+
+#ifdef POSIX
+#include <unistd.h>
+#endif
+
+namespace os {
+
+	Thread ThreadPool::spawn(nat threads, ThreadGroup &group) {
+		if (threads == 0)
+			threads = cpuCount();
+
+		// Our reference keeps the pool alive until all threads have joined.
+		ThreadPool *pool = new ThreadPool();
+
+		Thread first = Thread::spawn(group);
+		vector<Thread> others;
+		for (nat i = 1; i < threads; i++)
+			others.push_back(Thread::spawn(group));
+
+		{
+			util::Lock::L z(pool->lock);
+			pool->first = &first.threadData()->uState;
+			pool->others = others;
+		}
+
+		first.threadData()->uState.joinPool(pool);
+		for (size_t i = 0; i < others.size(); i++)
+			others[i].threadData()->uState.joinPool(pool);
+
+		pool->release();
+		return first;
+	}
+
+	ThreadPool::ThreadPool() : references(1), idleCount(0), nextVictim(0), first(null) {}
+
+	ThreadPool::~ThreadPool() {}
+
+	void ThreadPool::add(UThreadState *state) {
+		addRef();
+
+		util::Lock::L z(lock);
+		Member m = { state, false };
+		members.push_back(m);
+	}
+
+	void ThreadPool::remove(UThreadState *state) {
+		// Release the other threads outside of the lock.
+		vector<Thread> stop;
+
+		{
+			util::Lock::L z(lock);
+			for (size_t i = 0; i < members.size(); i++) {
+				if (members[i].state != state)
+					continue;
+
+				if (members[i].idle)
+					atomicDecrement(idleCount);
+				members.erase(members.begin() + i);
+				break;
+			}
+
+			if (state == first) {
+				first = null;
+				stop.swap(others);
+			}
+		}
+
+		stop.clear();
+		release();
+	}
+
+	UThreadData *ThreadPool::steal(UThreadState *thief) {
+		util::Lock::L z(lock);
+
+		// Start at a different thread each time, so that we do not drain one thread at a time.
+		size_t count = members.size();
+		for (size_t i = 0; i < count; i++) {
+			size_t id = (nextVictim + i) % count;
+			UThreadState *victim = members[id].state;
+			if (victim == thief)
+				continue;
+
+			if (UThreadData *found = thief->stealFrom(victim)) {
+				nextVictim = nat(id + 1);
+				return found;
+			}
+		}
+
+		return null;
+	}
+
+	void ThreadPool::notify(UThreadState *from) {
+		// Common case: everyone is busy.
+		if (atomicRead(idleCount) == 0)
+			return;
+
+		// Note: It is possible that a thread goes idle just after we checked 'idleCount'. In that
+		// case the new UThread is simply executed by 'from' as usual.
+		util::Lock::L z(lock);
+		for (size_t i = 0; i < members.size(); i++) {
+			if (members[i].idle && members[i].state != from) {
+				members[i].state->owner->reportWake();
+				break;
+			}
+		}
+	}
+
+	ThreadStats ThreadPool::stats() {
+		ThreadStats r;
+
+		util::Lock::L z(lock);
+		for (size_t i = 0; i < members.size(); i++)
+			r += members[i].state->owner->stats();
+
+		return r;
+	}
+
+	void ThreadPool::idle(UThreadState *state, bool idle) {
+		util::Lock::L z(lock);
+		for (size_t i = 0; i < members.size(); i++) {
+			Member &m = members[i];
+			if (m.state != state)
+				continue;
+
+			if (m.idle != idle) {
+				m.idle = idle;
+				if (idle)
+					atomicIncrement(idleCount);
+				else
+					atomicDecrement(idleCount);
+			}
+			break;
+		}
+	}
+
+#if defined(WINDOWS)
+
+	nat ThreadPool::cpuCount() {
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return max(nat(info.dwNumberOfProcessors), nat(1));
+	}
+
+#elif defined(POSIX)
+
+	nat ThreadPool::cpuCount() {
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+		if (count < 1)
+			return 1;
+		return nat(count);
+	}
+
+#endif
+
+}
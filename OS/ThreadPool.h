@@ -0,0 +1,100 @@
+#pragma once
+#include "Thread.h"
+#include "ThreadGroup.h"
+#include "Utils/Lock.h"
+
+namespace os {
+
+	/**
+	 * A pool of OS threads that share their UThreads.
+	 *
+	 * Each thread in the pool has its own ready queue, just like any other thread. When a thread
+	 * in the pool runs out of work, it steals ready UThreads from the other threads in the
+	 * pool. Because of this, a UThread spawned on the pool may be executed by any of the threads
+	 * in the pool, and it may move to another thread whenever it is suspended. Only use the pool
+	 * for UThreads that do not rely on thread-affine state, such as thread local variables,
+	 * handles attached to a particular thread, or exclusive access to data that is otherwise
+	 * protected by being accessed from a single thread.
+	 *
+	 * The pool is represented by its first thread, and UThreads are usually spawned there. The
+	 * other threads in the pool steal them as they become idle. The other threads are kept alive
+	 * for as long as the first thread is alive.
+	 */
+	class ThreadPool : NoCopy {
+	public:
+		// Create a pool of 'threads' threads in 'group', and return the first thread in the
+		// pool. If 'threads' is zero, one thread is created for each CPU in the system.
+		static Thread spawn(nat threads, ThreadGroup &group);
+
+		// Number of CPUs in the system.
+		static nat cpuCount();
+
+		// Add a reference.
+		inline void addRef() {
+			atomicIncrement(references);
+		}
+
+		// Release a reference.
+		inline void release() {
+			if (atomicDecrement(references) == 0)
+				delete this;
+		}
+
+		// Add a thread to the pool. Called by UThreadState when it joins the pool.
+		void add(UThreadState *state);
+
+		// Remove a thread from the pool. Called by UThreadState when it leaves the pool, before
+		// the thread terminates.
+		void remove(UThreadState *state);
+
+		// Steal a ready UThread from some other thread in the pool, and make it belong to
+		// 'thief'. Returns null if no UThread could be stolen. Called from the thread owning 'thief'.
+		UThreadData *steal(UThreadState *thief);
+
+		// Notify the pool that 'from' has a new UThread that is ready to run. Wakes an idle thread
+		// in the pool, if any, so that it may steal it.
+		void notify(UThreadState *from);
+
+		// Report that the thread owning 'state' is about to wait for work, or that it is done
+		// waiting.
+		void idle(UThreadState *state, bool idle);
+
+		// Get the sum of the statistics of all threads in the pool.
+		ThreadStats stats();
+
+	private:
+		// Create.
+		ThreadPool();
+
+		// Destroy.
+		~ThreadPool();
+
+		// A thread in the pool.
+		struct Member {
+			UThreadState *state;
+			bool idle;
+		};
+
+		// Number of references.
+		nat references;
+
+		// Number of idle threads. Read without holding the lock.
+		nat idleCount;
+
+		// Where to start looking for work the next time.
+		nat nextVictim;
+
+		// Lock for the members below.
+		util::Lock lock;
+
+		// All threads in the pool.
+		vector<Member> members;
+
+		// The first thread in the pool.
+		UThreadState *first;
+
+		// References to the other threads. Released when the first thread leaves the pool.
+		vector<Thread> others;
+	};
+
+}
@@ -0,0 +1,77 @@
+#include "stdafx.h"
+#include "ThreadStats.h"
+
+namespace os {
+
+	ThreadStats::ThreadStats()
+		: alive(0), ready(0), switches(0), idleWaits(0), idleUs(0),
+		  ioRequests(0), ioReads(0), ioWrites(0), crossCalls(0), crossCallUs(0) {}
+
+	ThreadStats::ThreadStats(const ThreadStats &o) {
+		*this = o;
+	}
+
+	ThreadStats &ThreadStats::operator =(const ThreadStats &o) {
+		alive = atomicRead(o.alive);
+		ready = atomicRead(o.ready);
+		switches = atomicRead(o.switches);
+		idleWaits = atomicRead(o.idleWaits);
+		idleUs = atomicRead(o.idleUs);
+		ioRequests = atomicRead(o.ioRequests);
+		ioReads = atomicRead(o.ioReads);
+		ioWrites = atomicRead(o.ioWrites);
+		crossCalls = atomicRead(o.crossCalls);
+		crossCallUs = atomicRead(o.crossCallUs);
+		return *this;
+	}
+
+	ThreadStats &ThreadStats::operator +=(const ThreadStats &o) {
+		alive += o.alive;
+		ready += o.ready;
+		switches += o.switches;
+		idleWaits += o.idleWaits;
+		idleUs += o.idleUs;
+		ioRequests += o.ioRequests;
+		ioReads += o.ioReads;
+		ioWrites += o.ioWrites;
+		crossCalls += o.crossCalls;
+		crossCallUs += o.crossCallUs;
+		return *this;
+	}
+
+#if defined(WINDOWS)
+
+	int64 ThreadStats::now() {
+		static int64 frequency = 0;
+		if (frequency == 0) {
+			LARGE_INTEGER f;
+			QueryPerformanceFrequency(&f);
+			frequency = f.QuadPart;
+		}
+
+		LARGE_INTEGER v;
+		QueryPerformanceCounter(&v);
+
+		// Avoid overflow when multiplying large values.
+		int64 seconds = v.QuadPart / frequency;
+		int64 remaining = v.QuadPart % frequency;
+		return seconds * 1000000 + (remaining * 1000000) / frequency;
+	}
+
+#elif defined(POSIX)
+
+	int64 ThreadStats::now() {
+		struct timespec time = {0, 0};
+		clock_gettime(CLOCK_MONOTONIC, &time);
+
+		int64 r = time.tv_sec;
+		r *= 1000 * 1000;
+		r += time.tv_nsec / 1000;
+		return r;
+	}
+
+#else
+#error "Implement ThreadStats::now for your platform!"
+#endif
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+namespace os {
+
+	/**
+	 * Statistics about the scheduling and I/O activity of a single OS thread. Maintained by the
+	 * UThreadState and ThreadData of the thread, and retrieved through Thread::stats.
+	 *
+	 * Most counters are only modified by the OS thread they describe. These are updated with plain
+	 * reads and writes rather than locked instructions, so that updating them is cheap. Other
+	 * threads may read the counters at any time, but there is no guarantee that the values are
+	 * consistent with each other.
+	 */
+	class ThreadStats {
+	public:
+		// Create, all counters are zero.
+		ThreadStats();
+
+		// Copy. Reads each counter atomically.
+		ThreadStats(const ThreadStats &o);
+		ThreadStats &operator =(const ThreadStats &o);
+
+		// Number of UThreads alive on the thread.
+		size_t alive;
+
+		// Number of UThreads in the ready queue.
+		size_t ready;
+
+		// Number of context switches between UThreads.
+		size_t switches;
+
+		// Number of times the thread waited for work, and the total time spent waiting, in
+		// microseconds.
+		size_t idleWaits;
+		size_t idleUs;
+
+		// Number of I/O requests issued, in total and per type. The type of I/O requests is not
+		// known on all platforms, so 'ioRequests' may be larger than 'ioReads + ioWrites'. Modified
+		// from any thread.
+		size_t ioRequests;
+		size_t ioReads;
+		size_t ioWrites;
+
+		// Number of calls from other threads that were executed, and the total time from the calls
+		// were made until they completed, in microseconds.
+		size_t crossCalls;
+		size_t crossCallUs;
+
+		// Add the counters in another object.
+		ThreadStats &operator +=(const ThreadStats &o);
+
+		// Update a counter that is only modified by the owning thread.
+		static inline void add(volatile size_t &counter, size_t value = 1) {
+			atomicWrite(counter, atomicRead(counter) + value);
+		}
+
+		// Update a counter that may be modified by any thread.
+		static inline void addShared(volatile size_t &counter) {
+			atomicIncrement(counter);
+		}
+
+		// Current time in microseconds, measured from some unspecified point in time.
+		static int64 now();
+
+		// Time spent since 'start', as returned from 'now'.
+		static inline size_t since(int64 start) {
+			int64 d = now() - start;
+			return d > 0 ? size_t(d) : 0;
+		}
+	};
+
+}
@@ -0,0 +1,271 @@
+#pragma once
+#include <limits>
+
+namespace os {
+
+	/**
+	 * A hierarchical timer wheel. Keeps track of elements that expire at some point in time, and
+	 * allows inserting and removing elements in constant time regardless of the number of
+	 * elements in the wheel.
+	 *
+	 * Time is divided into ticks of a fixed length. The wheel consists of a number of levels, each
+	 * with 64 slots. Each slot in the first level corresponds to a single tick, each slot in the
+	 * second level corresponds to 64 ticks, and so on. Elements are placed in the lowest level
+	 * that is able to represent their deadline, and are moved to lower levels as the wheel
+	 * advances past the slot they are stored in. Elements that are too far into the future are
+	 * stored in a separate list that is examined whenever the highest level wraps around.
+	 *
+	 * T must have the members 'T *next', 'T *prev', 'int64 until', and 'nat slot'. 'next' and
+	 * 'prev' must be initialized to null, and 'slot' to zero. 'until' is the deadline of the
+	 * element, expressed in the same unit as the times passed to the wheel. Elements are never
+	 * returned before their deadline, but may be returned up to one tick after it.
+	 */
+	template <class T>
+	class TimerWheel : NoCopy {
+	public:
+		// Create. 'tick' is the length of a tick, and 'now' is the current time.
+		TimerWheel(int64 tick, int64 now) : tick(max(tick, int64(1))), current(now / this->tick), size(0) {
+			for (nat i = 0; i < slotCount; i++)
+				heads[i] = null;
+			for (nat i = 0; i <= levels; i++)
+				counts[i] = 0;
+		}
+
+		// Empty the wheel.
+		~TimerWheel() {
+			for (nat i = 0; i < slotCount; i++) {
+				while (T *t = heads[i]) {
+					heads[i] = t->next;
+					t->next = null;
+					t->prev = null;
+				}
+			}
+		}
+
+		// Add an element.
+		void push(T *elem) {
+			assert(elem->next == null && elem->prev == null,
+				L"Can not push an element into more than one list.");
+
+			size++;
+			place(elem);
+		}
+
+		// Remove an element. Does nothing if the element is not in the wheel.
+		void erase(T *elem) {
+			if (elem->slot >= slotCount)
+				return;
+			if (!elem->prev && heads[elem->slot] != elem)
+				return;
+
+			unlink(elem);
+			size--;
+		}
+
+		// Remove and return an element whose deadline is at or before 'now'. Returns null if no
+		// such element exists.
+		T *pop(int64 now) {
+			if (!heads[expiredSlot])
+				advance(now / tick);
+
+			T *r = heads[expiredSlot];
+			if (r) {
+				unlink(r);
+				size--;
+			}
+			return r;
+		}
+
+		// Find the time when the wheel should be examined next, i.e. the earliest possible
+		// deadline of the elements in the wheel. Returns false if the wheel is empty.
+		bool next(int64 &time) const {
+			if (size == 0)
+				return false;
+
+			if (heads[expiredSlot])
+				time = current * tick;
+			else
+				time = nextTick() * tick;
+			return true;
+		}
+
+		// Empty?
+		bool empty() const {
+			return size == 0;
+		}
+
+		// Any?
+		bool any() const {
+			return size != 0;
+		}
+
+	private:
+		// Size of each level.
+		enum {
+			bits = 6,
+			slots = 1 << bits,
+			mask = slots - 1,
+			levels = 4,
+			// Slot for elements that do not fit in any level.
+			overflowSlot = levels * slots,
+			// Slot for elements whose deadline has passed.
+			expiredSlot = overflowSlot + 1,
+			slotCount = expiredSlot + 1,
+		};
+
+		// Length of a tick.
+		int64 tick;
+
+		// Current tick. All slots up to, and including, this tick have been processed.
+		int64 current;
+
+		// Number of elements in the wheel.
+		nat size;
+
+		// Heads of the lists in each slot.
+		T *heads[slotCount];
+
+		// Number of elements in each level. The last element is the overflow list.
+		nat counts[levels + 1];
+
+		// Place an element in the appropriate slot, based on its deadline.
+		void place(T *elem) {
+			// Round up, so that we never return elements too early.
+			int64 at = (elem->until + tick - 1) / tick;
+			int64 delta = at - current;
+
+			nat slot = overflowSlot;
+			if (delta <= 0) {
+				slot = expiredSlot;
+			} else {
+				for (nat l = 0; l < levels; l++) {
+					if (delta < (int64(1) << (bits * (l + 1)))) {
+						slot = l*slots + nat((at >> (bits * l)) & mask);
+						break;
+					}
+				}
+			}
+
+			link(slot, elem);
+		}
+
+		// Add an element to the list in 'slot'.
+		void link(nat slot, T *elem) {
+			elem->slot = slot;
+			elem->prev = null;
+			elem->next = heads[slot];
+			if (elem->next)
+				elem->next->prev = elem;
+			heads[slot] = elem;
+
+			if (slot < expiredSlot)
+				counts[slot / slots]++;
+		}
+
+		// Remove an element from its list.
+		void unlink(T *elem) {
+			if (elem->prev)
+				elem->prev->next = elem->next;
+			else
+				heads[elem->slot] = elem->next;
+			if (elem->next)
+				elem->next->prev = elem->prev;
+
+			if (elem->slot < expiredSlot)
+				counts[elem->slot / slots]--;
+
+			elem->next = null;
+			elem->prev = null;
+		}
+
+		// Find the next tick when something needs to be done. For the first level, this is the
+		// exact deadline of the first element. For the other levels, it is the time when the first
+		// non-empty slot is moved to a lower level.
+		int64 nextTick() const {
+			int64 first = std::numeric_limits<int64>::max();
+
+			for (nat l = 0; l < levels; l++) {
+				if (counts[l] == 0)
+					continue;
+
+				nat shift = bits * l;
+				int64 base = current >> shift;
+				for (nat k = 1; k <= slots; k++) {
+					if (heads[l*slots + nat((base + k) & mask)]) {
+						first = min(first, (base + k) << shift);
+						break;
+					}
+				}
+			}
+
+			if (counts[levels] > 0)
+				first = min(first, ((current >> (bits * levels)) + 1) << (bits * levels));
+
+			return first;
+		}
+
+		// Re-distribute all elements in 'slot'. Elements in the overflow slot may end up in the
+		// same slot again, so we detach the entire list first.
+		void cascade(nat slot) {
+			T *at = heads[slot];
+			heads[slot] = null;
+
+			while (at) {
+				T *next = at->next;
+				at->next = null;
+				at->prev = null;
+				counts[slot / slots]--;
+				place(at);
+				at = next;
+			}
+		}
+
+		// Advance the wheel to 'target'.
+		void advance(int64 target) {
+			if (size == 0) {
+				current = max(current, target);
+				return;
+			}
+
+			// Stop as soon as something expired, so that elements are returned in order.
+			while (current < target && !heads[expiredSlot]) {
+				if (counts[0] == 0) {
+					// Nothing in the first level, so we can skip ahead to the next time a slot in
+					// a higher level needs to be examined.
+					int64 to = nextTick();
+					if (to > target) {
+						current = target;
+						break;
+					}
+					current = to;
+				} else {
+					current++;
+				}
+
+				step();
+			}
+		}
+
+		// Process the slots for 'current'.
+		void step() {
+			// Move elements from higher levels, starting from the top, so that elements may move
+			// more than one level down.
+			if ((current & ((int64(1) << (bits * levels)) - 1)) == 0)
+				cascade(overflowSlot);
+
+			for (nat l = levels - 1; l > 0; l--) {
+				nat shift = bits * l;
+				if ((current & ((int64(1) << shift) - 1)) == 0)
+					cascade(l*slots + nat((current >> shift) & mask));
+			}
+
+			// All elements in the current slot in the first level have expired.
+			nat slot = nat(current & mask);
+			while (T *t = heads[slot]) {
+				unlink(t);
+				link(expiredSlot, t);
+			}
+		}
+	};
+
+}
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "UThread.h"
 #include "Thread.h"
+#include "ThreadPool.h"
 #include "FnCall.h"
 #include "Shared.h"
 #include "Sync.h"
@@ -22,9 +23,14 @@ namespace os {
 
 	// Stack size. (we need about 30k on Windows to do cout).
 	// 40k is too small to run the compiler well.
-    // TODO: Make compiler UThreads larger somehow? Maybe smaller stacks are enough in release builds...
 	// TOOD: On Windows, we want allocations to be 64k-aligned, as that is the allocation granularity there.
-	static nat stackSize = 400 * 1024;
+	const size_t defaultStackSize = 400 * 1024;
+
+	// Small stacks. Enough for I/O and moderate amounts of other work, but not for the compiler.
+	const size_t smallStackSize = 64 * 1024;
+
+	// Smallest stack size we allow.
+	static const size_t minStackSize = 16 * 1024;
 
 	// Switch the currently running threads. *oldEsp is set to the old esp.
 	// This returns as another thread, which may mean that it returns to the
@@ -159,15 +165,41 @@ namespace os {
 		// Only valid when using futures.
 		void *target;
 		FutureBase *future;
+
+		// Time when a call from another thread was made. Zero if the call was made from the same
+		// thread.
+		int64 called;
 	};
 
+	// Find the time to store in 'called'.
+	static int64 callTime(ThreadData *target) {
+		if (target == UThreadState::current()->owner)
+			return 0;
+		return ThreadStats::now();
+	}
+
+	// Record that a call made at 'called' has completed.
+	static void callDone(int64 called) {
+		if (called == 0)
+			return;
+
+		// Note: We may have been moved to another thread in a pool, so we can not cache the thread.
+		ThreadStats &stats = UThreadState::current()->owner->counters;
+		ThreadStats::add(stats.crossCalls);
+		ThreadStats::add(stats.crossCallUs, ThreadStats::since(called));
+	}
+
 	static void spawnCall(SpawnParams *params) {
+		int64 called = params->called;
+
 		try {
 			(*params->thunk)(endDetourFn(params->memberFn), params->memberFn, params->params, params->first, null);
 		} catch (...) {
 			onUncaughtException();
 		}
 
+		callDone(called);
+
 		// Terminate.
 		exitUThread();
 	}
@@ -176,11 +208,14 @@ namespace os {
 		// We need to save a local copy of 'future' since 'params' reside on the stack of the
 		// caller, which will continue as soon as we try to call the function.
 		FutureBase *future = params->future;
+		int64 called = params->called;
 
 		try {
 			(*params->thunk)(endDetourFn(params->memberFn), params->memberFn, params->params, params->first, params->target);
+			callDone(called);
 			future->posted();
 		} catch (...) {
+			callDone(called);
 			future->error();
 		}
 
@@ -217,7 +252,8 @@ namespace os {
 			call.params(),
 			call.thunk,
 			null,
-			null
+			null,
+			callTime(thread)
 		};
 		UThreadData *t = spawnHelper(&spawnCall, fn, thread, &params);
 		return insert(t, thread);
@@ -233,7 +269,8 @@ namespace os {
 			call.params(),
 			call.thunk,
 			target,
-			&result
+			&result,
+			callTime(thread)
 		};
 		UThreadData *t = spawnHelper(&spawnCallFuture, fn, thread, &params);
 		return insert(t, thread);
@@ -289,7 +326,7 @@ namespace os {
 	 */
 
 	UThreadData::UThreadData(UThreadState *state, size_t size)
-		: references(0), next(null), myOwner(null), stack(size),
+		: references(0), next(null), myOwner(null), stack(size, state->stackCache),
 		  detourOrigin(null), detourResult(null) {
 
 		initStack();
@@ -313,7 +350,11 @@ namespace os {
 	}
 
 	UThreadData *UThreadData::create(UThreadState *thread) {
-		return new UThreadData(thread, os::stackSize);
+		return new UThreadData(thread, thread->stackSize());
+	}
+
+	UThreadData *UThreadData::create(UThreadState *thread, size_t stackSize) {
+		return new UThreadData(thread, stackSize);
 	}
 
 	UThreadData::~UThreadData() {}
@@ -327,11 +368,33 @@ namespace os {
 		doSwitch(&to->stack.desc, &stack.desc);
 	}
 
+	void UThreadData::move(UThreadState *from, UThreadState *to) {
+		// It is not possible to move the stack between the sets atomically. Instead, we use the
+		// same approach as detours: first, we make the stack reachable from the UThread currently
+		// running on 'to', and mark it as a detour so that it is not scanned as a part of
+		// 'from'. Then we move it between the sets, and remove the markers in the reverse order.
+		Stack *last = &to->runningThread()->stack;
+		while (Stack *next = atomicRead(last->detourTo))
+			last = next;
+
+		atomicWrite(last->detourTo, &stack);
+		atomicWrite(stack.detourActive, 1);
+
+		from->removeStack(this);
+		to->newStack(this);
+
+		atomicWrite(stack.detourActive, 0);
+		atomicWrite(last->detourTo, (Stack *)null);
+
+		setOwner(to);
+	}
+
 	/**
 	 * UThread state.
 	 */
 
-	UThreadState::UThreadState(ThreadData *owner, void *stackBase) : owner(owner) {
+	UThreadState::UThreadState(ThreadData *owner, void *stackBase)
+		: owner(owner), readyCount(0), sleeping(msInTimestamp(1), timestamp()), myPool(null), myStackSize(defaultStackSize) {
 		currentUThreadState(this);
 
 		running = UThreadData::createFirst(this, stackBase);
@@ -358,6 +421,73 @@ namespace os {
 		stacks.insert(&v->stack);
 	}
 
+	void UThreadState::removeStack(UThreadData *v) {
+		util::Lock::L z(lock);
+		stacks.erase(&v->stack);
+	}
+
+	void UThreadState::stackSize(size_t size) {
+		atomicWrite(myStackSize, max(size, minStackSize));
+	}
+
+	void UThreadState::joinPool(ThreadPool *pool) {
+		pool->add(this);
+		atomicWrite(myPool, pool);
+	}
+
+	void UThreadState::leavePool() {
+		ThreadPool *pool = myPool;
+		if (!pool)
+			return;
+
+		atomicWrite(myPool, (ThreadPool *)null);
+		pool->remove(this);
+	}
+
+	UThreadData *UThreadState::steal() {
+		if (ThreadPool *pool = this->pool())
+			return pool->steal(this);
+		return null;
+	}
+
+	bool UThreadState::stealable(UThreadData *data) {
+		// Only UThreads whose state is completely saved (i.e. 'desc' is set) may be moved. A
+		// UThread may be in the ready queue while it is still running if it was woken before it
+		// had time to go to sleep. We also leave the first UThread of each thread alone, as well
+		// as anything involved in detours.
+		Stack &s = data->stack;
+		return s.allocated()
+			&& atomicRead(s.desc) != null
+			&& atomicRead(s.detourActive) == 0
+			&& atomicRead(s.detourTo) == null
+			&& data->detourOrigin == null;
+	}
+
+	UThreadData *UThreadState::stealFrom(UThreadState *from) {
+		// We need to be able to make the stolen UThread reachable from the running UThread while
+		// moving it. That is not possible if the running UThread is a part of a detour.
+		if (running->detourOrigin || atomicRead(running->stack.detourActive))
+			return null;
+
+		UThreadData *data = null;
+		{
+			util::Lock::L z(from->lock);
+			data = from->ready.find(&UThreadState::stealable);
+			if (data) {
+				from->ready.remove(data);
+				atomicWrite(from->readyCount, from->readyCount - 1);
+			}
+		}
+
+		if (!data)
+			return null;
+
+		data->move(from, this);
+		atomicIncrement(aliveCount);
+		atomicDecrement(from->aliveCount);
+		return data;
+	}
+
 	vector<UThread> UThreadState::idleThreads() {
 		vector<UThread> result;
 
@@ -392,22 +522,37 @@ namespace os {
 		reap();
 
 		UThreadData *prev = running;
+		UThreadData *next = null;
 		{
 			util::Lock::L z(lock);
-			UThreadData *next = ready.pop();
+			// Note: The size of the queue does not change here.
+			next = ready.pop();
+			if (next)
+				ready.push(running);
+		}
+
+		if (!next) {
+			// Nothing to do here. Perhaps some other thread in our pool has work for us?
+			next = steal();
 			if (!next)
 				return false;
-			ready.push(running);
-			running = next;
+
+			util::Lock::L z(lock);
+			pushReady(running);
 		}
 
+		running = next;
+
 		// Any IO messages for this thread?
 		owner->checkIo();
 
+		ThreadStats::add(owner->counters.switches);
+
 		// NOTE: This does not always return directly. Consider this when writing code after this statement.
 		prev->switchTo(running);
 
-		reap();
+		// Note: We may have been moved to another thread in the meantime.
+		UThreadState::current()->reap();
 		return true;
 	}
 
@@ -446,11 +591,11 @@ namespace os {
 
 	bool UThreadState::nextWake(nat &time) {
 		util::Lock::L z(sleepingLock);
-		SleepData *first = sleeping.peek();
-		if (!first)
+		int64 first = 0;
+		if (!sleeping.next(first))
 			return false;
 
-		time = remainingMs(first->until);
+		time = remainingMs(first);
 		return true;
 	}
 
@@ -460,15 +605,8 @@ namespace os {
 
 	void UThreadState::wakeThreads(int64 time) {
 		util::Lock::L z(sleepingLock);
-		while (sleeping.any()) {
-			SleepData *first = sleeping.peek();
-			if (time >= first->until) {
-				sleeping.pop();
-				first->signal();
-			} else {
-				break;
-			}
-		}
+		while (SleepData *first = sleeping.pop(time))
+			first->signal();
 	}
 
 	void UThreadState::exit() {
@@ -479,9 +617,12 @@ namespace os {
 		while (true) {
 			{
 				util::Lock::L z(lock);
-				next = ready.pop();
+				next = popReady();
 			}
 
+			if (!next)
+				next = steal();
+
 			if (next)
 				break;
 
@@ -497,6 +638,7 @@ namespace os {
 		atomicDecrement(aliveCount);
 		exited.push(prev);
 		running = next;
+		ThreadStats::add(owner->counters.switches);
 		prev->switchTo(running);
 
 		// Should not return.
@@ -520,12 +662,16 @@ namespace os {
 
 		{
 			util::Lock::L z(lock);
-			ready.push(data);
+			pushReady(data);
 			data->addRef();
 		}
 
 		// Notify that we need to wake up now!
 		owner->reportWake();
+
+		// Let an idle thread in the pool steal it, if we are busy.
+		if (ThreadPool *pool = this->pool())
+			pool->notify(this);
 	}
 
 	void UThreadState::wait() {
@@ -535,15 +681,19 @@ namespace os {
 		while (true) {
 			{
 				util::Lock::L z(lock);
-				next = ready.pop();
+				next = popReady();
 			}
 
+			if (!next)
+				next = steal();
+
 			if (next == prev) {
 				// May happen if we are the only UThread running and someone managed to wake the
 				// thread before we had time to sleep.
 				break;
 			} else if (next) {
 				running = next;
+				ThreadStats::add(owner->counters.switches);
 				prev->switchTo(running);
 				break;
 			}
@@ -552,27 +702,48 @@ namespace os {
 			owner->waitForWork();
 		}
 
-		reap();
+		// Note: We may have been moved to another thread in the meantime.
+		UThreadState::current()->reap();
 	}
 
 	void UThreadState::wake(UThreadData *data) {
 		{
 			util::Lock::L z(lock);
-			ready.push(data);
+			pushReady(data);
 		}
 
 		// Make sure we're not waiting for something that has already happened.
 		owner->reportWake();
+
+		if (ThreadPool *pool = this->pool())
+			pool->notify(this);
 	}
 
 	void UThreadState::reap() {
-		while (UThreadData *d = exited.pop())
+		while (UThreadData *d = exited.pop()) {
+			// If the 'exited' list holds the last reference, nothing else can reach the stack
+			// anymore, and we can keep its memory for the next UThread.
+			if (atomicRead(d->references) == 1)
+				d->stack.recycle(stackCache);
 			d->release();
+		}
 
 		wakeThreads(timestamp());
 		owner->checkIo();
 	}
 
+	void UThreadState::pushReady(UThreadData *data) {
+		ready.push(data);
+		atomicWrite(readyCount, readyCount + 1);
+	}
+
+	UThreadData *UThreadState::popReady() {
+		UThreadData *r = ready.pop();
+		if (r)
+			atomicWrite(readyCount, readyCount - 1);
+		return r;
+	}
+
 	void *UThreadState::startDetour(UThreadData *to) {
 		assert(to->owner() == null, L"The UThread is already associated with a thread, can not use it for detour.");
 
@@ -599,6 +770,7 @@ namespace os {
 
 		// Switch threads.
 		running = to;
+		ThreadStats::add(owner->counters.switches);
 		prev->switchTo(running);
 
 		// Since we returned here from 'switchTo', we know that 'endDetour' was called. Thus, we have
@@ -627,6 +799,7 @@ namespace os {
 		prev->setOwner(null);
 
 		// Switch threads.
+		ThreadStats::add(owner->counters.switches);
 		prev->switchTo(running);
 
 		// When we're back, we're in a different thread. Thus, call "reap" to clean up lingering threads.
@@ -658,9 +831,10 @@ namespace os {
 		if (target <= now)
 			return 0;
 
+		// Round up, so that we do not wake too early.
 		LARGE_INTEGER v;
 		QueryPerformanceFrequency(&v);
-		return nat((1000 * (target - now)) / v.QuadPart);
+		return nat((1000 * (target - now) + v.QuadPart - 1) / v.QuadPart);
 	}
 
 #elif defined(POSIX)
@@ -684,8 +858,9 @@ namespace os {
 		if (target <= now)
 			return 0;
 
+		// Round up, so that we do not wake too early.
 		int64 remaining = target - now;
-		return nat(remaining / 1000);
+		return nat((remaining + 999) / 1000);
 	}
 
 #endif
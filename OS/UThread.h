@@ -1,7 +1,7 @@
 #pragma once
 #include "FnCall.h"
 #include "InlineList.h"
-#include "SortedInlineList.h"
+#include "TimerWheel.h"
 #include "InlineSet.h"
 #include "Stack.h"
 #include "Utils/Function.h"
@@ -13,6 +13,7 @@ namespace os {
 
 	class Thread;
 	class ThreadData;
+	class ThreadPool;
 
 	/**
 	 * Implementation of user-level threads.
@@ -30,6 +31,14 @@ namespace os {
 	class UThreadData;
 	class UThreadState;
 
+	// Default size of the stacks of UThreads. Large enough to run the compiler.
+	extern const size_t defaultStackSize;
+
+	// A smaller stack size, suitable for UThreads that mostly wait for I/O, such as handlers for
+	// network connections. Overflowing the stack hits the guard page below it, and causes a fault
+	// rather than corrupting other memory.
+	extern const size_t smallStackSize;
+
 	/**
 	 * This is a handle to a specific UThread. Currently, not many operations
 	 * is supported on another UThread than the current. Therefore, the backing
@@ -212,8 +221,9 @@ namespace os {
 		// Create for the first thread (where the stack is allocated by OS).
 		static UThreadData *createFirst(UThreadState *thread, void *stackBase);
 
-		// Create any other threads.
+		// Create any other threads. Uses the stack size of 'thread', unless another size is given.
 		static UThreadData *create(UThreadState *thread);
+		static UThreadData *create(UThreadState *thread, size_t stackSize);
 
 		// Destroy.
 		~UThreadData();
@@ -230,7 +240,9 @@ namespace os {
 			return BASE_PTR(UThreadData, stackPtr, stack);
 		}
 
-		// Move this UThread to another Thread.
+		// Move this UThread to another Thread. The UThread must not be running, and must not be
+		// in any ready queue. 'to' must be the state of the calling thread. The UThread is
+		// reachable by the GC through either 'from' or 'to' during the entire move.
 		void move(UThreadState *from, UThreadState *to);
 
 		// Switch from this thread to 'to'.
@@ -277,6 +289,13 @@ namespace os {
 		// Protected by the same lock as the Ready-queue.
 		InlineSet<Stack> stacks;
 
+		// Memory from the stacks of exited UThreads, re-used when new UThreads are spawned here.
+		StackCache stackCache;
+
+		// Size of the stacks of UThreads spawned on this thread. Safe to call from any thread.
+		inline size_t stackSize() const { return atomicRead(myStackSize); }
+		void stackSize(size_t size);
+
 		// Get all idle threads. Protects accesses to 'stacks' with the appropriate lock. Assumed to
 		// be executed from the appropriate OS thread.
 		vector<UThread> idleThreads();
@@ -287,6 +306,11 @@ namespace os {
 		// Any more ready threads? This includes waiting threads.
 		bool any();
 
+		// Number of UThreads alive on this thread, and the number of UThreads in the ready queue.
+		// Safe to call from any thread.
+		inline nat aliveThreads() const { return atomicRead(aliveCount); }
+		inline nat readyThreads() const { return atomicRead(readyCount); }
+
 		// Schedule the next thread.
 		bool leave();
 
@@ -327,6 +351,29 @@ namespace os {
 		// Notify there is a new stack.
 		void newStack(UThreadData *data);
 
+		// Notify that a stack was moved to another thread.
+		void removeStack(UThreadData *data);
+
+		/**
+		 * Thread pools. See ThreadPool.h for details.
+		 *
+		 * When this thread is a member of a pool, it steals ready UThreads from the other threads
+		 * in the pool whenever it runs out of work.
+		 */
+
+		// The pool we are a member of, if any.
+		inline ThreadPool *pool() const { return atomicRead(myPool); }
+
+		// Join a pool. May be called from any thread.
+		void joinPool(ThreadPool *pool);
+
+		// Leave the pool. Must be called from the owning thread before it terminates.
+		void leavePool();
+
+		// Steal a ready UThread from 'from', and make it belong to this thread. Must be called
+		// from the owning thread. Returns null if no UThread could be stolen.
+		UThreadData *stealFrom(UThreadState *from);
+
 		/**
 		 * Take a detour to another thread for a while, with the intention to return directly to the
 		 * currently running thread later. Used while spawning threads.
@@ -352,7 +399,7 @@ namespace os {
 
 		// Data for sleeping threads.
 		struct SleepData {
-			inline SleepData(int64 until) : next(null), prev(null), until(until) {}
+			inline SleepData(int64 until) : next(null), prev(null), until(until), slot(0) {}
 
 			// Next and prev entries in the list.
 			SleepData *next;
@@ -361,13 +408,11 @@ namespace os {
 			// Wait until this timestamp.
 			int64 until;
 
+			// Slot in the timer wheel.
+			nat slot;
+
 			// Signal wait done.
 			virtual void signal() = 0;
-
-			// Compare.
-			inline bool operator <(const SleepData &o) const {
-				return until < o.until;
-			}
 		};
 
 		// Add a custom sleep item.
@@ -386,11 +431,18 @@ namespace os {
 		// Ready threads. May be scheduled now.
 		InlineList<UThreadData> ready;
 
+		// Number of threads in 'ready'.
+		nat readyCount;
+
+		// Push and pop from 'ready', keeping 'readyCount' up to date. Assumes 'lock' is held.
+		void pushReady(UThreadData *data);
+		UThreadData *popReady();
+
 		// Keep track of exited threads. Remove these at earliest opportunity!
 		InlineList<UThreadData> exited;
 
 		// Threads which are currently waiting.
-		SortedInlineList<SleepData> sleeping;
+		TimerWheel<SleepData> sleeping;
 
 		// Lock for the 'sleeping' list.
 		util::Lock sleepingLock;
@@ -404,6 +456,18 @@ namespace os {
 
 		// Wake threads up until 'timestamp'.
 		void wakeThreads(int64 time);
+
+		// The pool we are a member of, if any.
+		ThreadPool *myPool;
+
+		// Size of new stacks.
+		size_t myStackSize;
+
+		// Steal a UThread from the pool, if we are a member of one.
+		UThreadData *steal();
+
+		// Can 'data' be stolen by another thread?
+		static bool stealable(UThreadData *data);
 	};
 
 }
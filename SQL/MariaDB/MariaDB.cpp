@@ -4,6 +4,7 @@
 #include "Exception.h"
 #include "StrUtils.h"
 #include "Core/Convert.h"
+#include "Core/Map.h"
 
 namespace sql {
 
@@ -205,6 +205,22 @@ namespace storm {
 			return (*fwd.createWatch)(e);
 		}
 
+		bool stableIdentityHash(Engine &e) {
+			return (*fwd.stableIdentityHash)(e);
+		}
+
+		Nat identityHash(Engine &e, const void *obj) {
+			return (*fwd.identityHash)(e, obj);
+		}
+
+		Nat storeIdentityHash(Engine &e, const void *obj) {
+			return (*fwd.storeIdentityHash)(e, obj);
+		}
+
+		void releaseIdentityHash(Engine &e, const void *obj) {
+			(*fwd.releaseIdentityHash)(e, obj);
+		}
+
 		void postStdRequest(Engine &e, StdRequest *request) {
 			(*fwd.postStdRequest)(e, request);
 		}
@@ -0,0 +1,145 @@
+#include "stdafx.h"
+#include "Code/Binary.h"
+#include "Code/Listing.h"
+#include "Code/Peephole.h"
+
+using namespace code;
+
+// Count the number of instructions with a particular op-code.
+static Nat countOp(Listing *l, op::OpCode op) {
+	Nat result = 0;
+	for (Nat i = 0; i < l->count(); i++)
+		if (l->at(i)->op() == op)
+			result++;
+	return result;
+}
+
+BEGIN_TEST(PeepholeJumps, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing(false, intDesc(e));
+	Var v = l->createIntVar(l->root());
+
+	Label a = l->label();
+	Label b = l->label();
+
+	*l << prolog();
+	*l << mov(v, intConst(1));
+	*l << jmp(a);
+	*l << mov(v, intConst(2));
+	*l << a;
+	*l << jmp(b);
+	*l << b;
+	*l << add(v, intConst(10));
+	*l << fnRet(v);
+
+	// The first jump should go directly to 'b', and the second one is not needed.
+	Listing *t = code::transform(l, arena, new (e) Peephole(arena));
+	CHECK_EQ(countOp(t, op::jmp), 1);
+
+	Binary *bin = new (e) Binary(arena, l);
+	typedef Int (*Fn)();
+	Fn fn = (Fn)bin->address();
+
+	CHECK_EQ((*fn)(), 11);
+
+} END_TEST
+
+BEGIN_TEST(PeepholeConstant, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing(false, intDesc(e));
+
+	Label t = l->label();
+
+	*l << prolog();
+	*l << mov(eax, intConst(3));
+	*l << cmp(eax, intConst(3));
+	*l << jmp(t, ifEqual);
+	*l << mov(eax, intConst(0));
+	*l << fnRet(eax);
+	*l << t;
+	*l << mov(eax, intConst(1));
+	*l << fnRet(eax);
+
+	// The comparison is known, so the jump is unconditional.
+	Listing *tfm = code::transform(l, arena, new (e) Peephole(arena));
+	for (Nat i = 0; i < tfm->count(); i++) {
+		if (tfm->at(i)->op() == op::jmp) {
+			CHECK(tfm->at(i)->src().condFlag() == ifAlways);
+		}
+	}
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)();
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(), 1);
+
+} END_TEST
+
+BEGIN_TEST(PeepholeArith, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing(false, intDesc(e));
+	Var p = l->createParam(intDesc(e));
+	Var v = l->createIntVar(l->root());
+
+	*l << prolog();
+	*l << mov(eax, p);
+	*l << mov(v, eax);
+	*l << mov(eax, v);
+	*l << mul(v, intConst(8));
+	*l << udiv(v, natConst(2));
+	*l << umod(v, natConst(16));
+	*l << add(v, intConst(0));
+	*l << fnRet(v);
+
+	// Everything should be replaced by shifts and masks.
+	Listing *t = code::transform(l, arena, new (e) Peephole(arena));
+	CHECK_EQ(countOp(t, op::mul), 0);
+	CHECK_EQ(countOp(t, op::udiv), 0);
+	CHECK_EQ(countOp(t, op::umod), 0);
+	CHECK_EQ(countOp(t, op::add), 0);
+	// The load into 'eax' is kept, since it clears the upper part of the register.
+	CHECK_EQ(countOp(t, op::mov), 3);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(3), 12);
+	CHECK_EQ((*fn)(5), 4);
+	CHECK_EQ((*fn)(7), 12);
+
+} END_TEST
+
+BEGIN_TEST(PeepholeStores, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing(false, longDesc(e));
+	Var p = l->createParam(longDesc(e));
+	Var v = l->createLongVar(l->root());
+
+	*l << prolog();
+	*l << mov(rax, p);
+	*l << mov(v, rax);
+	*l << mov(rax, v);
+	*l << add(rax, longConst(1));
+	*l << fnRet(rax);
+
+	// Loading a 64-bit value that was just stored is not needed.
+	Listing *t = code::transform(l, arena, new (e) Peephole(arena));
+	CHECK_EQ(countOp(t, op::mov), 2);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Long (*Fn)(Long);
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(10), 11);
+
+} END_TEST
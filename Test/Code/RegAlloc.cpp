@@ -0,0 +1,171 @@
+#include "stdafx.h"
+#include "Code/Binary.h"
+#include "Code/Listing.h"
+#include "Code/RegAlloc.h"
+
+using namespace code;
+
+Int CODECALL regAllocTwice(Int v) {
+	return v * 2;
+}
+
+void CODECALL regAllocIncrease(Int *v) {
+	*v += 10;
+}
+
+// Count the number of variable operands in a listing.
+static Nat countVars(Listing *l) {
+	Nat result = 0;
+	for (Nat i = 0; i < l->count(); i++) {
+		if (l->at(i)->dest().type() == opVariable)
+			result++;
+		if (l->at(i)->src().type() == opVariable)
+			result++;
+	}
+	return result;
+}
+
+BEGIN_TEST(RegAllocTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Ref twice = arena->external(S("twice"), address(&regAllocTwice));
+
+	Listing *l = new (e) Listing(false, intDesc(e));
+	Var p = l->createParam(intDesc(e));
+	Var sum = l->createIntVar(l->root());
+	Var i = l->createIntVar(l->root());
+	Var tmp = l->createIntVar(l->root());
+
+	Label loop = l->label();
+	Label done = l->label();
+
+	*l << prolog();
+
+	// The variables need to survive the function call.
+	*l << loop;
+	*l << cmp(i, p);
+	*l << jmp(done, ifGreaterEqual);
+	*l << fnParam(intDesc(e), i);
+	*l << fnCall(twice, false, intDesc(e), tmp);
+	*l << add(sum, tmp);
+	*l << add(i, intConst(1));
+	*l << jmp(loop);
+
+	*l << done;
+	*l << fnRet(sum);
+
+	// If the backend supports it, all variables should be in registers.
+	if (arena->varRegs()->count() >= 4) {
+		Listing *t = code::transform(l, arena, new (e) RegAlloc(arena));
+		CHECK_EQ(countVars(t), 0);
+	}
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(0), 0);
+	CHECK_EQ((*fn)(4), 12);
+	CHECK_EQ((*fn)(10), 90);
+
+} END_TEST
+
+BEGIN_TEST(RegAllocBlock, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing(false, intDesc(e));
+	Var p = l->createParam(intDesc(e));
+	Var sum = l->createIntVar(l->root());
+	Block b = l->createBlock(l->root());
+	Var inner = l->createIntVar(b);
+
+	Label loop = l->label();
+	Label done = l->label();
+
+	*l << prolog();
+
+	// 'inner' should be re-initialized each time the block is entered.
+	*l << loop;
+	*l << cmp(p, intConst(0));
+	*l << jmp(done, ifEqual);
+	*l << begin(b);
+	*l << add(inner, intConst(1));
+	*l << add(sum, inner);
+	*l << end(b);
+	*l << sub(p, intConst(1));
+	*l << jmp(loop);
+
+	*l << done;
+	*l << fnRet(sum);
+
+	Binary *bin = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)bin->address();
+
+	CHECK_EQ((*fn)(0), 0);
+	CHECK_EQ((*fn)(5), 5);
+
+} END_TEST
+
+BEGIN_TEST(RegAllocSpill, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Ref twice = arena->external(S("twice"), address(&regAllocTwice));
+
+	// More variables than there are registers for.
+	const Nat count = 10;
+	Listing *l = new (e) Listing(false, intDesc(e));
+	Var vars[count];
+	for (Nat i = 0; i < count; i++)
+		vars[i] = l->createIntVar(l->root());
+	Var sum = l->createIntVar(l->root());
+
+	*l << prolog();
+
+	for (Nat i = 0; i < count; i++) {
+		*l << fnParam(intDesc(e), intConst(i + 1));
+		*l << fnCall(twice, false, intDesc(e), vars[i]);
+	}
+
+	for (Nat i = 0; i < count; i++)
+		*l << add(sum, vars[i]);
+
+	*l << fnRet(sum);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)();
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(), 110);
+
+} END_TEST
+
+BEGIN_TEST(RegAllocAddress, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Ref increase = arena->external(S("increase"), address(&regAllocIncrease));
+
+	// 'v' has its address taken, and must therefore stay in memory.
+	Listing *l = new (e) Listing(false, intDesc(e));
+	Var v = l->createIntVar(l->root());
+
+	*l << prolog();
+
+	*l << mov(v, intConst(5));
+	*l << lea(ptrA, v);
+	*l << fnParam(ptrDesc(e), ptrA);
+	*l << fnCall(increase, false);
+	*l << add(v, intConst(1));
+	*l << fnRet(v);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)();
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(), 16);
+
+} END_TEST
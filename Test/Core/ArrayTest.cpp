@@ -61,6 +61,42 @@ BEGIN_TEST(ArraySortTest, CoreEx) {
 	CHECK_EQ(toS(v), L"[5, 6, 7, 8, 9, 10, 1, 2, 3, 4]");
 } END_TEST
 
+static bool parallelPredicate(Int a, Int b) {
+	// Reverse order.
+	return b < a;
+}
+
+BEGIN_TEST(ArrayParallelSortTest, CoreEx) {
+	Engine &e = gEngine();
+
+	// Large enough to be split between multiple workers.
+	const Int count = 100000;
+	Array<Int> *v = new (e) Array<Int>();
+	for (Int i = 0; i < count; i++)
+		*v << ((i * 7919) % count);
+
+	v->parallelSort();
+	CHECK_EQ(v->count(), Nat(count));
+	bool ok = true;
+	for (Int i = 0; i < count; i++)
+		ok &= v->at(i) == i;
+	CHECK(ok);
+
+	// With a predicate.
+	v->parallelSort(fnPtr(e, &parallelPredicate));
+	ok = true;
+	for (Int i = 0; i < count; i++)
+		ok &= v->at(i) == count - 1 - i;
+	CHECK(ok);
+
+	// Small arrays are sorted sequentially.
+	Array<Int> *small = new (e) Array<Int>();
+	for (Int i = 0; i < 10; i++)
+		*small << (10 - i);
+	small->parallelSort();
+	CHECK_EQ(toS(small), L"[1, 2, 3, 4, 5, 6, 7, 8, 9, 10]");
+} END_TEST
+
 BEGIN_TEST(ArrayRemoveDupTest, CoreEx) {
 	Engine &e = gEngine();
 
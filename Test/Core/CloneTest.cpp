@@ -0,0 +1,48 @@
+#include "stdafx.h"
+#include "Core/CloneEnv.h"
+#include "Core/Array.h"
+#include "Core/Str.h"
+
+static bool verify(CloneEnv *env, Array<Str *> *from, Array<Str *> *to, Nat count) {
+	for (Nat i = 0; i < count; i++)
+		if (env->cloned(from->at(i)) != to->at(i))
+			return false;
+
+	for (Nat i = count; i < from->count(); i++)
+		if (env->cloned(from->at(i)) != null)
+			return false;
+
+	return true;
+}
+
+BEGIN_TEST(CloneEnvTest, Core) {
+	Engine &e = gEngine();
+
+	// Store objects in arrays so that the GC can move them.
+	const Nat count = 100;
+	Array<Str *> *from = new (e) Array<Str *>();
+	Array<Str *> *to = new (e) Array<Str *>();
+	for (Nat i = 0; i < count; i++) {
+		from->push(new (e) Str(::toS(i).c_str()));
+		to->push(new (e) Str(::toS(i).c_str()));
+	}
+
+	CloneEnv *env = new (e) CloneEnv();
+	CHECK(verify(env, from, to, 0));
+
+	// Few objects use the linear representation.
+	for (Nat i = 0; i < 4; i++)
+		env->cloned(from->at(i), to->at(i));
+	CHECK(verify(env, from, to, 4));
+
+	// Many objects use the hash table.
+	for (Nat i = 4; i < count; i++)
+		env->cloned(from->at(i), to->at(i));
+	CHECK(verify(env, from, to, count));
+
+	// Objects may be moved by the GC.
+	for (Nat i = 0; i < 3; i++) {
+		e.gc.collect();
+		CHECK(verify(env, from, to, count));
+	}
+} END_TEST
@@ -2,6 +2,11 @@
 #include "Compiler/Debug.h"
 #include "Utils/Bitwise.h"
 #include "Storm/Fn.h"
+#include "Gc/HeapSnapshot.h"
+
+#if STORM_GC == STORM_GC_SMM
+#include "Gc/SMM/Generation.h"
+#endif
 
 using namespace storm::debug;
 
@@ -22,6 +27,217 @@ BEGIN_TEST(GcTest2, GcObjects) {
 
 } END_TEST
 
+BEGIN_TEST(GcIncremental, GcObjects) {
+	Engine &e = gEngine();
+
+	// Incremental collections must not disturb live objects, regardless of how much they manage
+	// to do in the given time.
+	const nat count = 50000;
+	Link *start = createList(e, count);
+	for (nat i = 0; i < 10; i++)
+		e.gc.collect(Nat(i));
+	CHECK(checkList(start, count));
+
+} END_TEST
+
+BEGIN_TEST(GcLarge, GcObjects) {
+	Engine &e = gEngine();
+
+	// The array is large enough to be allocated in a chunk of its own. It is never copied, but
+	// it needs to keep the objects it refers to alive, and references to them need to be
+	// updated when they are moved.
+	const nat count = 20000;
+	Array<Link *> *links = new (e) Array<Link *>();
+	for (nat i = 0; i < count; i++) {
+		Link *l = new (e) Link();
+		l->value = i;
+		links->push(l);
+	}
+
+	for (nat i = 0; i < 3; i++)
+		e.gc.collect();
+
+	bool ok = true;
+	for (nat i = 0; i < count; i++)
+		ok &= links->at(i)->value == i;
+	CHECK(ok);
+
+} END_TEST
+
+BEGIN_TEST(GcIdentityHash, GcObjects) {
+	Engine &e = gEngine();
+
+	// Only meaningful if the GC claims to provide stable hashes.
+	if (!e.gc.stableIdentityHash())
+		break;
+
+	// Objects are only referred to from the heap, so that they are free to move.
+	const nat count = 1000;
+	Array<Link *> *links = new (e) Array<Link *>();
+	vector<Nat> hashes(count, 0);
+	bool ok = true;
+	for (nat i = 0; i < count; i++) {
+		links->push(new (e) Link());
+		hashes[i] = e.gc.identityHash(links->at(i));
+		// Storing the hash does not change it.
+		if (i % 2 == 0)
+			ok &= e.gc.storeIdentityHash(links->at(i)) == hashes[i];
+	}
+	CHECK(ok);
+
+	for (nat i = 0; i < 3; i++)
+		e.gc.collect();
+
+	// Only stored hashes need to be stable.
+	ok = true;
+	for (nat i = 0; i < count; i += 2)
+		ok &= e.gc.identityHash(links->at(i)) == hashes[i];
+	CHECK(ok);
+
+	// Containers keyed on objects store the hashes of the objects they contain.
+	Set<Link *> *set = new (e) Set<Link *>();
+	for (nat i = 0; i < count; i++)
+		set->put(links->at(i));
+
+	for (nat i = 0; i < 3; i++)
+		e.gc.collect();
+
+	ok = true;
+	for (nat i = 0; i < count; i++)
+		ok &= set->has(links->at(i));
+	CHECK(ok);
+
+	// Removing objects from one container does not affect other containers with the same objects.
+	Set<Link *> *copy = new (e) Set<Link *>(*set);
+	for (nat i = 0; i < count; i += 2)
+		set->remove(links->at(i));
+
+	for (nat i = 0; i < 3; i++)
+		e.gc.collect();
+
+	ok = true;
+	for (nat i = 0; i < count; i++) {
+		ok &= copy->has(links->at(i));
+		ok &= set->has(links->at(i)) == (i % 2 == 1);
+	}
+	CHECK(ok);
+
+} END_TEST
+
+#if STORM_GC == STORM_GC_SMM
+
+BEGIN_TEST(GcAdaptSize, GcObjects) {
+	using storm::smm::Generation;
+	const size_t base = 1024*1024;
+	const nat target = 1000;
+
+	// Fast collections grow the generation, but at most by a factor of two.
+	CHECK_EQ(Generation::adaptedSize(base, base, target, base, base / 10, 10), 2*base);
+	CHECK_EQ(Generation::adaptedSize(base, base, target, base, base / 10, 0), 2*base);
+	CHECK_EQ(Generation::adaptedSize(base, base, target, base, base / 10, 250), 2*base);
+
+	// Slow collections shrink it, but at most by a factor of two.
+	CHECK_EQ(Generation::adaptedSize(base, base, target, base, base / 10, 4000), base / 2);
+	CHECK_EQ(Generation::adaptedSize(base, base, target, base, base / 10, 100000), base / 2);
+
+	// Collections that take the desired time do not change the size.
+	CHECK_EQ(Generation::adaptedSize(base, base, target, base, base / 10, target), base);
+
+	// If most objects survive, the generation shrinks even if collections are fast.
+	CHECK_EQ(Generation::adaptedSize(base, base, target, base, base * 9 / 10, 10), size_t(base * 0.6));
+	CHECK_EQ(Generation::adaptedSize(base, base, target, 0, 0, 10), 2*base);
+
+	// The size stays within limits relative to the size requested by the user.
+	size_t maxSize = base * storm::smm::adaptiveMaxFactor;
+	size_t minSize = base / storm::smm::adaptiveMinFactor;
+	CHECK_EQ(Generation::adaptedSize(maxSize, base, target, base, base / 10, 10), maxSize);
+	CHECK_EQ(Generation::adaptedSize(minSize, base, target, base, base / 10, 4000), minSize);
+} END_TEST
+
+#endif
+
+BEGIN_TEST(GcEvents, GcObjects) {
+	Engine &e = gEngine();
+
+	GcTelemetry *telemetry = e.gc.telemetry();
+	if (!telemetry)
+		break;
+
+	vector<GcTelemetry::Event> old = telemetry->events(0);
+	size_t after = old.empty() ? 0 : old.back().id;
+	size_t pauses = telemetry->pauses.total();
+
+	Link *start = createList(e, 1000);
+	e.gc.collect();
+	CHECK(checkList(start, 1000));
+
+	vector<GcTelemetry::Event> found = telemetry->events(after);
+	CHECK(!found.empty());
+	CHECK(telemetry->pauses.total() >= pauses + found.size());
+
+	bool ok = true;
+	for (size_t i = 0; i < found.size(); i++) {
+		ok &= found[i].id == after + i + 1;
+		ok &= found[i].start <= found[i].end;
+	}
+	CHECK(ok);
+
+} END_TEST
+
+BEGIN_TEST(GcAllocProfile, GcObjects) {
+	Engine &e = gEngine();
+	AllocProfiler &profiler = e.gc.profiler;
+
+	// Sample often, so that we are sure to get some samples.
+	profiler.clear();
+	profiler.start(256);
+	Link *start = createList(e, 1000);
+	profiler.stop();
+	CHECK(checkList(start, 1000));
+
+	Type *linkType = Link::stormType(e);
+	size_t samples = 0;
+	bool foundLink = false;
+	AllocProfiler::Site site;
+	for (nat i = 0; profiler.site(i, site); i++) {
+		samples += site.samples;
+		foundLink |= site.type == linkType;
+		CHECK_GTE(site.bytes, site.samples * 256);
+	}
+	CHECK_GT(samples, 0);
+	CHECK(foundLink);
+
+	profiler.clear();
+	CHECK_EQ(profiler.siteCount(), 0);
+
+} END_TEST
+
+BEGIN_TEST(GcHeapSnapshot, GcObjects) {
+	Engine &e = gEngine();
+
+	Link *start = createList(e, 1000);
+
+	HeapSnapshot snapshot(e.gc);
+	CHECK(checkList(start, 1000));
+
+	// Not all GCs support walking the heap.
+	if (snapshot.count() == 0)
+		break;
+
+	Type *linkType = Link::stormType(e);
+	bool found = false;
+	for (nat i = 0; i < snapshot.count(); i++) {
+		HeapSnapshot::Entry entry = snapshot.at(i);
+		CHECK_GTE(entry.retained, entry.bytes);
+		if (entry.type == linkType) {
+			found = true;
+			CHECK_GTE(entry.count, 1000);
+		}
+	}
+	CHECK(found);
+
+} END_TEST
+
 /**
  * Long-running stresstest of the GC logic. Too slow for regular use, but good when debugging.
  */
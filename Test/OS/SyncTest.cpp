@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "OS/SortedInlineList.h"
 
 struct OtherData {
 	os::Sema sync;
@@ -63,6 +64,59 @@ BEGIN_TEST(WaitTest, OS) {
 	os::UThread::sleep(100);
 } END_TEST
 
+class WheelItem {
+public:
+	WheelItem(int64 until) : next(null), prev(null), until(until), slot(0) {}
+	WheelItem *next;
+	WheelItem *prev;
+	int64 until;
+	nat slot;
+};
+
+BEGIN_TEST(TimerWheelTest, OS) {
+	// Ticks of length 10, starting at time 0.
+	os::TimerWheel<WheelItem> w(10, 0);
+
+	WheelItem a(5);
+	WheelItem b(100);
+	WheelItem c(1000);
+	WheelItem d(50000);
+	WheelItem e(500000000);
+
+	w.push(&e);
+	w.push(&d);
+	w.push(&c);
+	w.push(&b);
+	w.push(&a);
+
+	int64 next = 0;
+	CHECK(w.next(next));
+	CHECK_EQ(next, 10);
+
+	CHECK(w.pop(4) == null);
+	CHECK(w.pop(10) == &a);
+	CHECK(w.pop(10) == null);
+
+	CHECK(w.next(next));
+	CHECK_EQ(next, 100);
+
+	// Removing an element in a higher level.
+	w.erase(&c);
+	CHECK(w.pop(100000) == &b);
+	CHECK(w.pop(100000) == &d);
+	CHECK(w.pop(100000) == null);
+
+	// Elements that have already expired are returned immediately.
+	WheelItem f(0);
+	w.push(&f);
+	CHECK(w.pop(100000) == &f);
+
+	// Elements far into the future.
+	CHECK(w.pop(499999999) == null);
+	CHECK(w.pop(500000000) == &e);
+	CHECK(w.empty());
+} END_TEST
+
 class OtherCond {
 public:
 	os::IOCondition cond;
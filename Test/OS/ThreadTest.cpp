@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "OS/Thread.h"
 #include "OS/ThreadGroup.h"
+#include "OS/ThreadPool.h"
 #include "OS/Condition.h"
 #include "Tracker.h"
 
@@ -167,3 +168,51 @@ BEGIN_TEST(ConditionTest, OS) {
 	// Now z.count is 10, and the other thread will terminate eventually.
 } END_TEST;
 
+
+struct PoolWork {
+	// Semaphore to indicate that a UThread is done.
+	Semaphore done;
+
+	// Lock for 'seen'.
+	util::Lock lock;
+
+	// Threads that executed some part of the work.
+	set<uintptr_t> seen;
+
+	PoolWork() : done(0) {}
+
+	// Run some work, yielding now and then.
+	void run() {
+		for (nat i = 0; i < 20; i++) {
+			{
+				util::Lock::L z(lock);
+				seen.insert(os::Thread::current().id());
+			}
+			Sleep(1);
+			UThread::leave();
+		}
+		done.up();
+	}
+};
+
+BEGIN_TEST(ThreadPoolTest, OS) {
+	ThreadGroup g;
+	PoolWork work;
+
+	{
+		os::Thread pool = ThreadPool::spawn(4, g);
+
+		// Everything is spawned on the first thread, the others need to steal.
+		for (nat i = 0; i < 16; i++)
+			UThread::spawn(util::memberVoidFn(&work, &PoolWork::run), &pool);
+
+		for (nat i = 0; i < 16; i++)
+			work.done.down();
+	}
+
+	CHECK_GT(work.seen.size(), size_t(1));
+	CHECK_LTE(work.seen.size(), size_t(4));
+
+	// All threads in the pool terminate when the pool is released.
+	g.join();
+} END_TEST
@@ -516,3 +516,34 @@ BEGIN_TEST(UThreadSemaInterop, OS) {
 	CHECK_EQ(t.state, 2);
 
 } END_TEST
+
+static void emptyFn() {}
+
+BEGIN_TEST(UThreadStackReuse, OS) {
+	UThreadState *state = UThreadState::current();
+	size_t oldSize = state->stackSize();
+
+	for (nat s = 0; s < 2; s++) {
+		state->stackSize(s == 0 ? os::defaultStackSize : os::smallStackSize);
+
+		// Spawn a thread and let it exit, so that its stack ends up in the cache.
+		UThread::spawn(util::simpleVoidFn(&emptyFn));
+		UThread::leave();
+
+		// The stack should be re-used from now on.
+		size_t before = Stack::allocatedMemory();
+		for (nat i = 0; i < 10; i++) {
+			UThread::spawn(util::simpleVoidFn(&emptyFn));
+			UThread::leave();
+		}
+		CHECK_EQ(Stack::allocatedMemory(), before);
+	}
+
+	// Too small stacks are not allowed.
+	state->stackSize(10);
+	CHECK_GT(state->stackSize(), size_t(10));
+
+	state->stackSize(oldSize);
+	CHECK(!UThread::any());
+
+} END_TEST
@@ -1,5 +1,8 @@
 #include "stdafx.h"
 #include "Compiler/Package.h"
+#include "Compiler/Function.h"
+#include "Compiler/Code.h"
+#include "Compiler/Exception.h"
 
 void compileNoRes(Package *in) {
 	in->forceLoad();
@@ -34,6 +37,47 @@ BEGIN_TEST(Util, Compile) {
 	CHECK_RUNS(e.package(S("util"))->compile());
 } END_TEST
 
+// Count the functions in 'names' that are lazily compiled, and the ones that are compiled so far.
+static void countCompiled(Array<Named *> *names, Nat &lazy, Nat &compiled) {
+	lazy = 0;
+	compiled = 0;
+	for (Nat i = 0; i < names->count(); i++) {
+		Function *fn = as<Function>(names->at(i));
+		if (!fn)
+			continue;
+
+		LazyCode *code = as<LazyCode>(fn->getCode());
+		if (!code)
+			continue;
+
+		lazy++;
+		if (code->compiled())
+			compiled++;
+	}
+}
+
+BEGIN_TEST(WarmUp, Compile) {
+	Engine &e = gEngine();
+	CHECK_RUNS(e.package(S("util"))->warmUp());
+
+	// Nothing in here is used elsewhere, so nothing is compiled before 'warmUp'.
+	Package *pkg = e.package(S("tests.warmup"));
+	VERIFY(pkg);
+	Array<Named *> *names = pkg->warmUpNames();
+
+	Nat lazy = 0, compiled = 0;
+	countCompiled(names, lazy, compiled);
+	CHECK_GT(lazy, 0);
+	CHECK_EQ(compiled, 0);
+
+	CHECK_RUNS(pkg->warmUp());
+	countCompiled(names, lazy, compiled);
+	CHECK_EQ(compiled, lazy);
+
+	// Errors are propagated to the caller.
+	CHECK_ERROR(e.package(S("tests.bs.errors"))->warmUp(), SyntaxError);
+} END_TEST
+
 BEGIN_TEST(Demo, Compile) {
 	Engine &e = gEngine();
 	CHECK_RUNS(e.package(S("demo"))->compile());
@@ -445,6 +445,13 @@ BEGIN_TEST(BSArrayTest, BS) {
 	CHECK_EQ(toS(runFn<Str *>(S("tests.bs.sortArrayP"))), L"[3, 4, 5, 1, 2]");
 	CHECK_EQ(toS(runFn<Str *>(S("tests.bs.sortedArrayP"))), L"[3, 4, 5, 1, 2][5, 4, 3, 2, 1]");
 
+	// Parallel algorithms.
+	CHECK_EQ(toS(runFn<Str *>(S("tests.bs.parallelMapArray"))), L"09991000");
+	CHECK_EQ(runFn<Int>(S("tests.bs.parallelReduceArray")), 500500);
+	CHECK(runFn<Bool>(S("tests.bs.parallelReduceOrder")));
+	CHECK_EQ(runFn<Int>(S("tests.bs.parallelForArray")), 999000);
+	CHECK_EQ(runFn<Int>(S("tests.bs.parallelForCompile")), 1498500);
+
 	// Remove duplicates.
 	CHECK_EQ(toS(runFn<Str *>(S("tests.bs.noDuplicates"))), L"[1, 2, 3, 4]");
 	CHECK_EQ(toS(runFn<Str *>(S("tests.bs.noDuplicatesP1"))), L"0, 1, 2, 3, 4");
@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "Fn.h"
 #include "Compiler/Exception.h"
+#include "Compiler/Code.h"
+#include "Compiler/Package.h"
 
 BEGIN_TEST(BasicSyntax, SimpleBS) {
 	CHECK_RUNS(runFn<void>(S("tests.bs-simple.voidFn")));
@@ -42,3 +44,41 @@ BEGIN_TEST(LoopTest, SimpleBS) {
 	CHECK_EQ(runFn<Int>(S("tests.bs-simple.loop5")), 27);
 } END_TEST
 
+BEGIN_TEST(TierUpTest, SimpleBS) {
+	Engine &e = gEngine();
+
+	// Code is only optimized later if the source is kept. Note: This has to be done before
+	// anything in the package is loaded.
+	Package *pkg = e.package(S("tests.tierup"));
+	VERIFY(pkg);
+	pkg->noDiscard();
+
+	Function *fn = as<Function>(pkg->find(S("tierUpFn"), Value(StormInfo<Int>::type(e)), Scope()));
+	VERIFY(fn);
+	LazyCode *code = as<LazyCode>(fn->getCode());
+	VERIFY(code);
+
+	CHECK_EQ(runFn<Int>(S("tests.tierup.tierUpFn"), 1), 3);
+	CHECK(code->compiled());
+	CHECK(!code->optimized());
+	const void *unoptimized = fn->ref().address();
+
+	// Call the function often enough for it to be optimized. It should behave the same before,
+	// during and after the switch.
+	for (Int i = 0; i < 3000; i++) {
+		CHECK_EQ(runFn<Int>(S("tests.tierup.tierUpFn"), i % 3 + 1), i % 3 + 3);
+
+		// Let the optimization run.
+		if (i % 100 == 0)
+			os::UThread::leave();
+	}
+
+	// Wait for the optimization to finish.
+	for (Nat i = 0; i < 100 && fn->ref().address() == unoptimized; i++)
+		os::UThread::sleep(10);
+
+	CHECK(code->optimized());
+	CHECK_NEQ(fn->ref().address(), unoptimized);
+	CHECK_EQ(runFn<Int>(S("tests.tierup.tierUpFn"), 2), 4);
+} END_TEST
+
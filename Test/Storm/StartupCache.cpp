@@ -0,0 +1,169 @@
+#include "stdafx.h"
+#include "Compiler/StartupCache.h"
+#include "Compiler/Package.h"
+#include "Compiler/Function.h"
+#include "Compiler/Code.h"
+#include "Core/Io/Text.h"
+#include "Core/Io/Utf8Text.h"
+
+// Directory for the files used in the tests below.
+static Url *startupDir(Engine &e) {
+	return cwdUrl(e)->pushDir(new (e) Str(S("storm-startup-cache")));
+}
+
+// Write 'text' to 'file'.
+static void writeText(Url *file, Str *text) {
+	TextOutput *out = new (file) Utf8Output(file->write());
+	out->write(text);
+	out->close();
+}
+
+// Source of the packages used in the tests.
+static const wchar *startupSource =
+	S("Int startupA(Int x) { x + 1; }\n")
+	S("Int startupB(Int x) { x + 2; }\n")
+	S("Int startupC(Int x) { x + 3; }\n");
+
+// Create a package named 'name' that contains 'startupSource', and add it to 'tests'. Each test
+// uses a package of its own, so that the functions are not compiled before the test starts. The
+// package keeps its source, as code is otherwise always compiled with optimizations.
+static Package *startupPackage(Engine &e, const wchar *name) {
+	Url *dir = startupDir(e)->pushDir(new (e) Str(name));
+	dir->deleteTree();
+	dir->createDirTree();
+	writeText(dir->push(new (e) Str(S("startup.bs"))), new (e) Str(startupSource));
+
+	Package *pkg = new (e) Package(dir);
+	pkg->noDiscard();
+	e.package(S("tests"))->add(pkg);
+	return pkg;
+}
+
+// Get one of the functions in 'startupSource'.
+static Function *startupFn(Package *pkg, const wchar *name) {
+	Engine &e = pkg->engine();
+	return as<Function>(pkg->find(name, Value(StormInfo<Int>::type(e)), Scope()));
+}
+
+// Get the code for one of the functions in 'startupSource'.
+static LazyCode *startupCode(Package *pkg, const wchar *name) {
+	Function *fn = startupFn(pkg, name);
+	if (!fn)
+		return null;
+	return as<LazyCode>(fn->getCode());
+}
+
+// Get the file used as the cache for the package 'name'. It is outside of the package, since
+// the key of the package depends on all files in it.
+static Url *startupFile(Engine &e, const wchar *name) {
+	Url *file = startupDir(e)->push(TO_S(e, name << S(".cache")));
+	file->deleteTree();
+	return file;
+}
+
+BEGIN_TEST(StartupRoundTrip, Compile) {
+	Engine &e = gEngine();
+	Package *pkg = startupPackage(e, S("startupRoundTrip"));
+	Url *file = startupFile(e, S("startupRoundTrip"));
+
+	LazyCode *a = startupCode(pkg, S("startupA"));
+	LazyCode *b = startupCode(pkg, S("startupB"));
+	VERIFY(a && b);
+
+	// Nothing is known without a file.
+	StartupCache *cache = new (e) StartupCache(file);
+	CHECK_EQ(cache->warmUp(pkg), 0);
+
+	a->compile();
+	b->compileOptimized();
+	cache->record(pkg);
+	cache->save();
+	CHECK(file->exists());
+
+	// Read it back.
+	cache = new (e) StartupCache(file);
+	CHECK_EQ(cache->warmUp(pkg), 2);
+
+	// Files in an unknown format are ignored.
+	writeText(file, new (e) Str(S("not a cache\n")));
+	cache = new (e) StartupCache(file);
+	CHECK_EQ(cache->warmUp(pkg), 0);
+
+	startupDir(e)->deleteTree();
+} END_TEST
+
+BEGIN_TEST(StartupInvalidate, Compile) {
+	Engine &e = gEngine();
+	Package *pkg = startupPackage(e, S("startupInvalidate"));
+	Url *file = startupFile(e, S("startupInvalidate"));
+
+	LazyCode *a = startupCode(pkg, S("startupA"));
+	VERIFY(a);
+	a->compile();
+
+	StartupCache *cache = new (e) StartupCache(file);
+	cache->record(pkg);
+	cache->save();
+
+	Str *saved = readAllText(file);
+	CHECK_EQ((new (e) StartupCache(file))->warmUp(pkg), 1);
+
+	// A different executable. The key starts with the hash of the executable, so changing its
+	// first digit is the same as recording the package with another executable.
+	Str *packagePrefix = new (e) Str(S("package "));
+	Str::Iter key = saved->find(packagePrefix);
+	VERIFY(key != saved->end());
+	key = key + packagePrefix->peekLength();
+
+	StrBuf *changed = new (e) StrBuf();
+	*changed << saved->cut(saved->begin(), key);
+	*changed << (key.v() == Char('0') ? S("1") : S("0"));
+	*changed << saved->cut(key + 1);
+	writeText(file, changed->toS());
+	CHECK_EQ((new (e) StartupCache(file))->warmUp(pkg), 0);
+
+	// An edited file in the package.
+	writeText(file, saved);
+	CHECK_EQ((new (e) StartupCache(file))->warmUp(pkg), 1);
+	Url *src = pkg->url()->push(new (e) Str(S("startup.bs")));
+	writeText(src, *new (e) Str(startupSource) + S("// Edited.\n"));
+	CHECK_EQ((new (e) StartupCache(file))->warmUp(pkg), 0);
+
+	startupDir(e)->deleteTree();
+} END_TEST
+
+BEGIN_TEST(StartupOptimize, Compile) {
+	Engine &e = gEngine();
+	Package *pkg = startupPackage(e, S("startupOptimize"));
+	Url *file = startupFile(e, S("startupOptimize"));
+
+	Function *fnA = startupFn(pkg, S("startupA"));
+	Function *fnB = startupFn(pkg, S("startupB"));
+	LazyCode *a = startupCode(pkg, S("startupA"));
+	LazyCode *b = startupCode(pkg, S("startupB"));
+	LazyCode *c = startupCode(pkg, S("startupC"));
+	VERIFY(a && b && c);
+
+	// Record the package while nothing is compiled, to get a file with the right key. Then add
+	// the functions to the file, so that 'warmUp' is the first to compile them.
+	StartupCache *cache = new (e) StartupCache(file);
+	cache->record(pkg);
+	cache->save();
+
+	StrBuf *text = new (e) StrBuf();
+	*text << readAllText(file);
+	*text << S("- ") << fnA->identifier() << S("\n");
+	*text << S("+ ") << fnB->identifier() << S("\n");
+	writeText(file, text->toS());
+
+	cache = new (e) StartupCache(file);
+	CHECK_EQ(cache->warmUp(pkg), 2);
+
+	CHECK(a->compiled());
+	CHECK(!a->optimized());
+	CHECK(b->compiled());
+	CHECK(b->optimized());
+	CHECK(!c->compiled());
+
+	startupDir(e)->deleteTree();
+} END_TEST
@@ -59,4 +59,19 @@ BEGIN_TEST(BSThread, BS) {
 	// Check the semantics of the "spawn(...)" syntax:
 	CHECK_EQ(runFn<Int>(S("tests.bs.asyncPostExplicit")), 6); // 1 copy + 1 deep copy, starts at 4.
 	CHECK_ERROR(runFn<void>(S("tests.bs.asyncPostExplictError")), SyntaxError);
+
+	// Transfer<T> moves objects without copying them.
+	CHECK_EQ(runFn<Int>(S("tests.bs.transferObject")), 4); // No copies, starts at 4.
+	CHECK_ERROR(runFn<void>(S("tests.bs.transferTwice")), UsageError);
+	CHECK_EQ(runFn<Int>(S("tests.bs.transferClone")), 7);
+	CHECK_EQ(runFn<Nat>(S("tests.bs.transferBuffer")), 10);
+
+	// Channels.
+	CHECK_EQ(runFn<Int>(S("tests.bs.channelSum")), 5050);
+	CHECK_EQ(runFn<Int>(S("tests.bs.channelObjects")), 5);
+	CHECK_EQ(runFn<Nat>(S("tests.bs.channelSelect")), 31);
+	CHECK_EQ(runFn<Nat>(S("tests.bs.channelDrain")), 32);
+	CHECK_ERROR(runFn<void>(S("tests.bs.channelSendClosed")), UsageError);
+
+	CHECK_EQ(runFn<Nat>(S("tests.bs.threadStatsCalls")), 10);
 } END_TEST